@@ -50,16 +50,50 @@ public:
     std::string getVectorBackend() const { return vector_backend_; }
     std::string getVectorPath() const { return vector_path_; }
     std::string getVectorUrl() const { return vector_url_; }
+    bool getVectorHNSWEnabled() const { return vector_hnsw_enabled_; }
+    int getVectorHNSWM() const { return vector_hnsw_m_; }
+    int getVectorHNSWEfSearch() const { return vector_hnsw_ef_search_; }
+    std::string getVectorQuantization() const { return vector_quantization_; }
+    int getVectorSearchThreads() const { return vector_search_threads_; }
+    std::string getVectorSQLiteSynchronous() const { return vector_sqlite_synchronous_; }
+    int getVectorSQLiteCacheKb() const { return vector_sqlite_cache_kb_; }
+    int64_t getVectorSQLiteMmapBytes() const { return vector_sqlite_mmap_bytes_; }
+    bool getVectorSparseVectors() const { return vector_sparse_vectors_; }
+    int64_t getVectorChromaBatchBytes() const { return vector_chroma_batch_bytes_; }
+    int getVectorChromaConcurrency() const { return vector_chroma_concurrency_; }
 
     // Embedding settings
     std::string getEmbeddingProvider() const { return embedding_provider_; }
     std::string getEmbeddingModel() const { return embedding_model_; }
+    int getEmbeddingBatchSize() const { return embedding_batch_size_; }
+    int getEmbeddingConcurrency() const { return embedding_concurrency_; }
+    bool getEmbeddingCacheEnabled() const { return embedding_cache_enabled_; }
+    int getEmbeddingCacheMaxMB() const { return embedding_cache_max_mb_; }
+    int getEmbeddingLocalDimensions() const { return embedding_local_dimensions_; }
 
     // RAG settings
     bool getRAGEnabled() const { return rag_enabled_; }
     bool getRAGAutoContext() const { return rag_auto_context_; }
     double getRAGSimilarityThreshold() const { return rag_similarity_threshold_; }
     int getRAGMaxChunks() const { return rag_max_chunks_; }
+    int getRAGIngestReaders() const { return rag_ingest_readers_; }
+    int getRAGIngestChunkers() const { return rag_ingest_chunkers_; }
+    int getRAGIngestEmbedders() const { return rag_ingest_embedders_; }
+    int getRAGIngestQueueDepth() const { return rag_ingest_queue_depth_; }
+    bool getRAGHybridSearch() const { return rag_hybrid_search_; }
+    double getRAGVectorWeight() const { return rag_vector_weight_; }
+    double getRAGLexicalWeight() const { return rag_lexical_weight_; }
+    int getRAGFusionK() const { return rag_fusion_k_; }
+    int getRAGQueryCacheSize() const { return rag_query_cache_size_; }
+    bool getRAGWatchDirectories() const { return rag_watch_directories_; }
+    int getRAGWatchDebounceMs() const { return rag_watch_debounce_ms_; }
+    int getRAGMaxFileMb() const { return rag_max_file_mb_; }
+    bool getRAGSkipBinary() const { return rag_skip_binary_; }
+    std::string getRAGSkipExtensions() const { return rag_skip_extensions_; }
+    int getRAGStreamWindowMb() const { return rag_stream_window_mb_; }
+    int getRAGMaxContextTokens() const { return rag_max_context_tokens_; }
+    double getRAGMMRLambda() const { return rag_mmr_lambda_; }
+    double getRAGDuplicateThreshold() const { return rag_duplicate_threshold_; }
 
     // License settings
     std::string getLicenseServerUrl() const { return license_server_url_; }
@@ -87,16 +121,50 @@ public:
     void setVectorBackend(const std::string& backend);
     void setVectorPath(const std::string& path);
     void setVectorUrl(const std::string& url);
+    void setVectorHNSWEnabled(bool value);
+    void setVectorHNSWM(int value);
+    void setVectorHNSWEfSearch(int value);
+    void setVectorQuantization(const std::string& value);
+    void setVectorSearchThreads(int value);
+    void setVectorSQLiteSynchronous(const std::string& value);
+    void setVectorSQLiteCacheKb(int value);
+    void setVectorSQLiteMmapBytes(int64_t value);
+    void setVectorSparseVectors(bool value);
+    void setVectorChromaBatchBytes(int64_t value);
+    void setVectorChromaConcurrency(int value);
 
     // Embedding setters
     void setEmbeddingProvider(const std::string& provider);
     void setEmbeddingModel(const std::string& model);
+    void setEmbeddingBatchSize(int value);
+    void setEmbeddingConcurrency(int value);
+    void setEmbeddingCacheEnabled(bool value);
+    void setEmbeddingCacheMaxMB(int value);
+    void setEmbeddingLocalDimensions(int value);
 
     // RAG setters
     void setRAGEnabled(bool enabled);
     void setRAGAutoContext(bool enabled);
     void setRAGSimilarityThreshold(double threshold);
     void setRAGMaxChunks(int chunks);
+    void setRAGIngestReaders(int value);
+    void setRAGIngestChunkers(int value);
+    void setRAGIngestEmbedders(int value);
+    void setRAGIngestQueueDepth(int value);
+    void setRAGHybridSearch(bool value);
+    void setRAGVectorWeight(double value);
+    void setRAGLexicalWeight(double value);
+    void setRAGFusionK(int value);
+    void setRAGQueryCacheSize(int value);
+    void setRAGWatchDirectories(bool value);
+    void setRAGWatchDebounceMs(int value);
+    void setRAGMaxFileMb(int value);
+    void setRAGSkipBinary(bool value);
+    void setRAGSkipExtensions(const std::string& value);
+    void setRAGStreamWindowMb(int value);
+    void setRAGMaxContextTokens(int value);
+    void setRAGMMRLambda(double value);
+    void setRAGDuplicateThreshold(double value);
 
     // License setters
     void setLicenseServerUrl(const std::string& url);
@@ -123,6 +191,7 @@ public:
     static std::string getHistoryPath();
     static std::string getMCPConfigPath();
     static std::string getDefaultVectorPath();
+    static std::string getDefaultEmbeddingCachePath();
 
 private:
     void createDefaultConfig();
@@ -156,16 +225,50 @@ private:
     std::string vector_backend_;
     std::string vector_path_;
     std::string vector_url_;
+    bool vector_hnsw_enabled_;
+    int vector_hnsw_m_;
+    int vector_hnsw_ef_search_;
+    std::string vector_quantization_;
+    int vector_search_threads_;
+    std::string vector_sqlite_synchronous_;
+    int vector_sqlite_cache_kb_;
+    int64_t vector_sqlite_mmap_bytes_;
+    bool vector_sparse_vectors_;
+    int64_t vector_chroma_batch_bytes_;
+    int vector_chroma_concurrency_;
 
     // Embedding settings
     std::string embedding_provider_;
     std::string embedding_model_;
+    int embedding_batch_size_;
+    int embedding_concurrency_;
+    bool embedding_cache_enabled_;
+    int embedding_cache_max_mb_;
+    int embedding_local_dimensions_;
 
     // RAG settings
     bool rag_enabled_;
     bool rag_auto_context_;
     double rag_similarity_threshold_;
     int rag_max_chunks_;
+    int rag_ingest_readers_;
+    int rag_ingest_chunkers_;
+    int rag_ingest_embedders_;
+    int rag_ingest_queue_depth_;
+    bool rag_hybrid_search_;
+    double rag_vector_weight_;
+    double rag_lexical_weight_;
+    int rag_fusion_k_;
+    int rag_query_cache_size_;
+    bool rag_watch_directories_;
+    int rag_watch_debounce_ms_;
+    int rag_max_file_mb_;
+    bool rag_skip_binary_;
+    std::string rag_skip_extensions_;
+    int rag_stream_window_mb_;
+    int rag_max_context_tokens_;
+    double rag_mmr_lambda_;
+    double rag_duplicate_threshold_;
 
     // License settings
     std::string license_server_url_;
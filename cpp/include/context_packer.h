@@ -0,0 +1,45 @@
+#ifndef CASPER_CONTEXT_PACKER_H
+#define CASPER_CONTEXT_PACKER_H
+
+#include "vector_db.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace casper {
+
+// Turns retrieved chunks into the passages placed in a prompt.
+//
+// Chunks of the same source whose chunk_index values are equal or adjacent
+// are merged into one passage, with the text consecutive chunks share
+// (chunk_overlap) kept once. A merged passage scores as its best chunk but
+// is worth the sum of its chunks when selecting.
+//
+// Passages are then picked greedily by value per token until the budget is
+// spent, where the value is discounted by maximal marginal relevance:
+// value * (1 - (1 - mmr_lambda) * similarity), similarity being the highest
+// word-bigram containment against any passage already picked. A passage at
+// least duplicate_threshold similar to one already picked is dropped. Each
+// passage costs its text and source plus a fixed header allowance, in the
+// same ~4 characters per token estimate RAGEngine uses. If not even the
+// best passage fits, it is cut at a word boundary instead.
+class ContextPacker {
+public:
+    // A token_budget of 0 or less means no limit
+    ContextPacker(int token_budget, double mmr_lambda = 0.7, double duplicate_threshold = 0.9);
+
+    // Passages in descending score order
+    std::vector<VectorSearchResult> pack(const std::vector<VectorSearchResult>& results) const;
+
+    // Tokens a passage with this source and content takes up in the prompt
+    static int passageTokens(std::string_view source, std::string_view content);
+
+private:
+    int token_budget_;
+    double mmr_lambda_;
+    double duplicate_threshold_;
+};
+
+} // namespace casper
+
+#endif // CASPER_CONTEXT_PACKER_H
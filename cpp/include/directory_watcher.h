@@ -0,0 +1,74 @@
+#ifndef CASPER_DIRECTORY_WATCHER_H
+#define CASPER_DIRECTORY_WATCHER_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace casper {
+
+// Watches directory trees and reports changed paths in debounced batches.
+//
+// Uses inotify, so it only works on Linux; elsewhere isSupported() is false
+// and watch() fails. Every directory under a root gets its own watch, and
+// directories created or moved in later are added as they appear. Hidden
+// files and directories are ignored, as in RAGEngine::listFiles.
+//
+// A batch is delivered once no event has arrived for debounce_ms, so an
+// editor's write-rename-chmod sequence or a git checkout produces one
+// callback. It holds files that were written, created, moved or deleted,
+// and directories that appeared or disappeared as a whole. If the kernel
+// queue overflows, the batch holds the watched roots instead. The callback
+// runs on the watcher's own thread, at reduced CPU priority.
+class DirectoryWatcher {
+public:
+    using Callback = std::function<void(const std::vector<std::string>& paths)>;
+
+    explicit DirectoryWatcher(Callback callback, int debounce_ms = 500);
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    static bool isSupported();
+
+    // Watch a directory tree; starts the thread on first use
+    bool watch(const std::string& root);
+    void unwatch(const std::string& root);
+    std::vector<std::string> roots();
+
+    // Stops the thread and drops every watch. Pending changes are discarded.
+    void stop();
+
+private:
+    Callback callback_;
+    int debounce_ms_;
+    std::mutex mutex_;
+    std::set<std::string> roots_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+#ifdef __linux__
+    int inotify_fd_;
+    int wake_fd_[2];                    // Pipe that interrupts poll() on stop
+    std::map<int, std::string> dirs_;   // Watch descriptor -> directory
+    std::map<std::string, int> wds_;    // Directory -> watch descriptor
+
+    bool start();
+    void run();
+    // Add or drop watches for dir and every directory below it
+    void addTree(const std::string& dir);
+    void removeTree(const std::string& dir);
+    // Parses a buffer of inotify events into pending paths
+    void handleEvents(const char* buffer, size_t length, std::set<std::string>& pending);
+#endif
+};
+
+} // namespace casper
+
+#endif // CASPER_DIRECTORY_WATCHER_H
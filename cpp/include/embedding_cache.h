@@ -0,0 +1,80 @@
+#ifndef CASPER_EMBEDDING_CACHE_H
+#define CASPER_EMBEDDING_CACHE_H
+
+#include "embeddings.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+
+namespace casper {
+
+// Embedding cache statistics
+struct EmbeddingCacheStats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    int64_t evictions = 0;
+    int64_t entries = 0;
+    int64_t bytes = 0;       // Embedding payload held on disk
+};
+
+// Persistent, content-addressed embedding cache.
+//
+// Entries are keyed by (provider, model, 128-bit hash of the normalized text)
+// in a small SQLite database, so the same chunk is only embedded once per
+// model, across runs and across machines sharing the file. Least recently
+// used entries are evicted once the entry or byte limit is exceeded.
+//
+// Several processes may use the same file: entry and byte totals and the
+// LRU clock live in the database and are read inside each write
+// transaction, and writers wait for each other instead of failing.
+class EmbeddingCache {
+public:
+    EmbeddingCache();
+    ~EmbeddingCache();
+
+    // The open cache for path, shared by every caller in this process;
+    // nullptr if it cannot be opened
+    static std::shared_ptr<EmbeddingCache> shared(const std::string& path);
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return db_ != nullptr; }
+
+    // 0 = unlimited
+    void setLimits(int64_t max_entries, int64_t max_bytes);
+
+    // Look up every text. Hits are written to embeddings[i] and flagged in
+    // found[i]; returns the number of hits.
+    size_t lookup(const std::string& provider, const std::string& model,
+                  const std::vector<std::string>& texts,
+                  std::vector<Embedding>& embeddings, std::vector<bool>& found);
+
+    // Store embeddings for texts (same order), evicting if over the limits
+    void store(const std::string& provider, const std::string& model,
+               const std::vector<std::string>& texts, const std::vector<Embedding>& embeddings);
+
+    void clear();
+    EmbeddingCacheStats getStats();
+
+    // Whitespace-insensitive form the hash is taken over: runs of
+    // whitespace become one space, leading and trailing whitespace is dropped
+    static std::string normalizeText(const std::string& text);
+
+private:
+    void* db_;  // sqlite3*
+    std::mutex mutex_;
+    int64_t max_entries_;
+    int64_t max_bytes_;
+    EmbeddingCacheStats stats_;  // Hits, misses and evictions of this process
+
+    bool begin();  // Write transaction, waiting for other writers
+    bool readTotals(int64_t& entries, int64_t& bytes);
+    int64_t lastStamp();  // Newest last_used (LRU order)
+    void evict();
+};
+
+} // namespace casper
+
+#endif // CASPER_EMBEDDING_CACHE_H
@@ -0,0 +1,81 @@
+#ifndef CASPER_EMBEDDING_MATRIX_H
+#define CASPER_EMBEDDING_MATRIX_H
+
+#include "embeddings.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+namespace casper {
+
+// Resident structure-of-arrays copy of every stored embedding: one id column
+// and one contiguous row block. Rows are padded to a multiple of 64 bytes
+// and the block is 64-byte aligned, so every row starts on a cache line.
+//
+// A matrix holds either raw float rows (reset) or fixed-size quantized codes
+// (resetCodes); dimensions() is the logical embedding size in both cases.
+//
+// Removal swaps the last row into the hole, keeping the block dense.
+class EmbeddingMatrix {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    EmbeddingMatrix();
+    ~EmbeddingMatrix();
+
+    EmbeddingMatrix(const EmbeddingMatrix&) = delete;
+    EmbeddingMatrix& operator=(const EmbeddingMatrix&) = delete;
+
+    // Drop all rows and switch to float rows; dimensions == 0 means
+    // "take from first row"
+    void reset(int dimensions = 0);
+    // Drop all rows and switch to code rows of code_bytes each
+    void resetCodes(int dimensions, size_t code_bytes);
+    void reserve(size_t rows);
+
+    // Insert or replace a float row. Rows whose size differs from the
+    // matrix dimensionality are rejected.
+    bool upsert(const std::string& id, const Embedding& embedding);
+    bool upsert(const std::string& id, const float* data, size_t count);
+    // Insert or replace a code row
+    bool upsertCode(const std::string& id, const uint8_t* code, size_t bytes);
+    bool remove(const std::string& id);
+
+    // Lookup
+    bool contains(const std::string& id) const { return rows_.count(id) > 0; }
+    int64_t rowOf(const std::string& id) const;
+    const std::string& idAt(size_t row) const { return ids_[row]; }
+    const float* rowAt(size_t row) const { return reinterpret_cast<const float*>(codeAt(row)); }
+    const uint8_t* codeAt(size_t row) const { return data_ + row * stride_bytes_; }
+
+    // Shape
+    size_t size() const { return ids_.size(); }
+    bool empty() const { return ids_.empty(); }
+    bool holdsCodes() const { return codes_; }
+    int dimensions() const { return dimensions_; }
+    size_t rowBytes() const { return row_bytes_; }
+    size_t strideBytes() const { return stride_bytes_; }
+    size_t stride() const { return stride_bytes_ / sizeof(float); }  // Floats between row starts
+    size_t memoryBytes() const { return capacity_ * stride_bytes_; }
+
+private:
+    int dimensions_;
+    bool codes_;
+    size_t row_bytes_;
+    size_t stride_bytes_;
+    size_t capacity_;
+    uint8_t* data_;
+    std::vector<std::string> ids_;
+    std::unordered_map<std::string, size_t> rows_;
+
+    void clear();
+    void setRowBytes(size_t bytes);
+    bool store(const std::string& id, const void* data, size_t bytes);
+    void grow(size_t min_rows);
+};
+
+} // namespace casper
+
+#endif // CASPER_EMBEDDING_MATRIX_H
@@ -2,9 +2,12 @@
 #define CASPER_EMBEDDINGS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <functional>
+#include <mutex>
+#include <cstdint>
 
 namespace casper {
 
@@ -49,11 +52,16 @@ public:
 };
 
 // Ollama embedding provider
+//
+// Texts are sent to /api/embed as `input` arrays of up to batch_size texts,
+// with up to `concurrency` requests in flight. Connections are kept alive
+// between requests and calls. Servers without /api/embed fall back to one
+// /api/embeddings request per text.
 class OllamaEmbeddingProvider : public EmbeddingProvider {
 public:
     explicit OllamaEmbeddingProvider(const std::string& host = "http://localhost:11434",
                                       const std::string& model = "nomic-embed-text");
-    ~OllamaEmbeddingProvider() override = default;
+    ~OllamaEmbeddingProvider() override;
 
     EmbeddingResult embed(const std::string& text) override;
     BatchEmbeddingResult embedBatch(const std::vector<std::string>& texts) override;
@@ -68,6 +76,12 @@ public:
     // Set embedding model
     void setModel(const std::string& model);
 
+    // Texts per /api/embed request and requests kept in flight
+    void setBatchSize(int batch_size);
+    void setConcurrency(int concurrency);
+    int getBatchSize() const { return batch_size_; }
+    int getConcurrency() const { return concurrency_; }
+
     // Test connection
     bool testConnection();
 
@@ -78,48 +92,78 @@ private:
     std::string host_;
     std::string model_;
     int dimensions_;
+    int batch_size_;
+    int concurrency_;
+    bool legacy_api_;              // Server has no /api/embed
+    void* multi_;                  // CURLM*, owns the shared connection cache
+    std::vector<void*> handles_;   // CURL*, one per request slot, reused
+    std::mutex mutex_;             // Serializes use of the handles
 
     // Detect dimensions from first embedding
     void detectDimensions(const Embedding& emb);
+
+    void* handle(size_t slot);
+    BatchEmbeddingResult embedLegacy(const std::vector<std::string>& texts);
 };
 
+class WorkerPool;
+
 // Local embedding provider (using simple TF-IDF or word2vec-like approach)
 // This is a fallback when Ollama is not available
+//
+// Each ASCII alphanumeric run of two or more characters, lowercased, adds
+// +-1 at four hashed positions, 0.5 per character bigram and 0.3 per
+// trigram; the vector is then normalized. Hashes are computed straight from
+// the input bytes, so embedding allocates nothing but the result. Batches
+// large enough to pay for it are spread over a worker pool.
 class LocalEmbeddingProvider : public EmbeddingProvider {
 public:
-    LocalEmbeddingProvider();
-    ~LocalEmbeddingProvider() override = default;
+    explicit LocalEmbeddingProvider(int dimensions = 256);
+    ~LocalEmbeddingProvider() override;
 
     EmbeddingResult embed(const std::string& text) override;
     BatchEmbeddingResult embedBatch(const std::vector<std::string>& texts) override;
 
     std::string getName() const override { return "local"; }
-    std::string getModel() const override { return "tfidf-256"; }
+    std::string getModel() const override { return "tfidf-" + std::to_string(dimensions_); }
     int getDimensions() const override { return dimensions_; }
 
+    // Changes the model name too, so cached embeddings of another size are
+    // not mixed in
+    void setDimensions(int dimensions);
+
 private:
     int dimensions_;
+    std::unique_ptr<WorkerPool> pool_;  // Created by the first large batch
+    std::mutex pool_mutex_;
 
     // Simple hash-based embedding (bag of words style)
-    Embedding hashEmbed(const std::string& text);
-
-    // Tokenize text
-    std::vector<std::string> tokenize(const std::string& text);
-
-    // Hash function for tokens
-    uint32_t hash(const std::string& token);
+    Embedding hashEmbed(std::string_view text) const;
 };
 
+class EmbeddingCache;
+
 // Main embedding client
 class EmbeddingClient {
 public:
     EmbeddingClient();
-    ~EmbeddingClient() = default;
+    ~EmbeddingClient();
 
     // Configure
     void setProvider(const std::string& provider);  // "ollama" or "local"
     void setOllamaHost(const std::string& host);
     void setOllamaModel(const std::string& model);
+    void setBatchSize(int batch_size);
+    void setConcurrency(int concurrency);
+    void setLocalDimensions(int dimensions);
+
+    // Persistent cache consulted before the provider (see embedding_cache.h).
+    // max_bytes = 0 leaves the cache unbounded. Enabling the cache that is
+    // already in use only updates its limit. Embedding calls in progress keep
+    // the cache they started with when it is replaced or disabled.
+    bool enableCache(const std::string& path, int64_t max_bytes = 0);
+    void disableCache();
+    std::shared_ptr<EmbeddingCache> getCache() const;
 
     // Get current provider info
     std::string getProvider() const;
@@ -130,11 +174,16 @@ public:
     EmbeddingResult embed(const std::string& text);
     BatchEmbeddingResult embedBatch(const std::vector<std::string>& texts);
 
-    // Utility functions
+    // Utility functions (SIMD accelerated, see simd_kernels.h)
     static float cosineSimilarity(const Embedding& a, const Embedding& b);
     static float dotProduct(const Embedding& a, const Embedding& b);
     static Embedding normalize(const Embedding& emb);
 
+    // Score one query against a block of `count` rows spaced `stride` floats
+    // apart, writing one score per row into `scores`
+    static void dotProductBatch(const Embedding& query, const float* rows, size_t count, size_t stride, float* scores);
+    static void cosineSimilarityBatch(const Embedding& query, const float* rows, size_t count, size_t stride, float* scores);
+
     // Test if embeddings are available
     bool isAvailable();
 
@@ -142,6 +191,10 @@ private:
     std::string current_provider_;
     std::unique_ptr<OllamaEmbeddingProvider> ollama_;
     std::unique_ptr<LocalEmbeddingProvider> local_;
+    std::shared_ptr<EmbeddingCache> cache_;
+    std::string cache_path_;
+    int64_t cache_max_bytes_;
+    mutable std::mutex cache_mutex_;  // Guards cache_ and its settings
 
     EmbeddingProvider* getActiveProvider();
 };
@@ -0,0 +1,157 @@
+#ifndef CASPER_HNSW_INDEX_H
+#define CASPER_HNSW_INDEX_H
+
+#include "embeddings.h"
+#include "embedding_matrix.h"
+#include "quantizer.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <random>
+#include <cstdint>
+
+namespace casper {
+
+// HNSW tuning parameters
+struct HNSWParams {
+    int M = 16;                 // Max links per node on upper layers (2*M on layer 0)
+    int ef_construction = 200;  // Candidate list size while inserting
+    int ef_search = 64;         // Candidate list size while searching
+};
+
+// Hierarchical Navigable Small World graph for approximate nearest neighbour
+// search over cosine similarity. Vectors are unit-length so that the
+// similarity of two nodes is a plain dot product.
+//
+// Nodes are addressed by a dense label. Removal marks a node as deleted: it
+// still routes searches but is never returned or linked to by new nodes.
+// Tombstones are dropped when the index is rebuilt.
+//
+// The graph holds no vectors of its own: a live node reads its row of the
+// EmbeddingMatrix given to reset(), found through a label -> row map. The
+// owner keeps that map current (markDeleted() before a row is removed or
+// overwritten, rowMoved() after the matrix moves one). Tombstones keep a
+// private copy, taken when they are deleted, so they can still route.
+//
+// Rows are float32, or the codes of a VectorQuantizer when reset() is given
+// one (the matrix then holds those codes); codes are decoded for each
+// distance, so similarities are then approximate and callers re-rank the
+// results exactly.
+class HNSWIndex {
+public:
+    struct Node {
+        std::string id;
+        int level;
+        bool deleted;
+        std::vector<std::vector<uint32_t>> links;  // links[layer]
+    };
+
+    HNSWIndex();
+    explicit HNSWIndex(const HNSWParams& params);
+
+    // Configuration
+    void setParams(const HNSWParams& params);
+    HNSWParams getParams() const { return params_; }
+    void setEfSearch(int ef) { params_.ef_search = ef; }
+
+    // Drop everything and start over on the rows of matrix. With a ready
+    // quantizer, rows are its codes (and dimensionality is the
+    // quantizer's). Both must outlive the index or the next reset().
+    void reset(const EmbeddingMatrix* matrix, const VectorQuantizer* quantizer = nullptr);
+
+    // Mutations. add() uses the matrix row of id when there is one that
+    // fits, and keeps a copy of the embedding otherwise.
+    uint32_t add(const std::string& id, const Embedding& embedding);
+    bool markDeleted(const std::string& id);
+    bool contains(const std::string& id) const;
+
+    // Row bookkeeping: the matrix moved id to row, or reloaded all rows
+    void rowMoved(const std::string& id, size_t row);
+    void remapRows();
+
+    // Returns (id, cosine similarity) pairs ordered by descending similarity
+    std::vector<std::pair<std::string, float>> search(const Embedding& query, int k, int ef = 0) const;
+
+    // Size information
+    size_t size() const { return nodes_.size(); }
+    size_t liveCount() const { return nodes_.size() - deleted_count_; }
+    size_t deletedCount() const { return deleted_count_; }
+    int getDimensions() const { return dimensions_; }
+    bool empty() const { return liveCount() == 0; }
+    bool holdsCodes() const { return quantizer_ != nullptr; }
+    size_t memoryBytes() const;  // Links, row map and copies held
+
+    // Persistence support
+    const Node& node(uint32_t label) const { return nodes_[label]; }
+    int64_t entryPoint() const { return entry_point_; }
+    int maxLevel() const { return max_level_; }
+    std::vector<uint32_t> takeDirty();
+    // row is the node's matrix row, or -1 for a tombstone restored without a vector
+    void restoreNode(uint32_t label, const std::string& id, int level, bool deleted,
+                     std::vector<std::vector<uint32_t>> links, int64_t row);
+    void restoreEntryPoint(int64_t entry_point, int max_level);
+    // Whether every link, and the entry point, lead to a node that exists
+    // on the layer they are followed on
+    bool linksConsistent() const;
+    // Unlink tombstones whose vectors are no longer available (after a
+    // reload), reconnecting their live neighbours through them. Moves the
+    // entry point to a live node if necessary.
+    void detachDeleted();
+
+    // Link list (de)serialization: per layer a uint32 count followed by labels
+    static std::string serializeLinks(const std::vector<std::vector<uint32_t>>& links);
+    static std::vector<std::vector<uint32_t>> deserializeLinks(const void* data, size_t size);
+
+private:
+    HNSWParams params_;
+    int dimensions_;
+    std::vector<Node> nodes_;
+    const EmbeddingMatrix* matrix_;
+    const VectorQuantizer* quantizer_;  // Set when rows are codes
+    size_t row_bytes_;              // Bytes of one vector (or code)
+    // label -> matrix row; kNoRow, or kCopied - i for copies_ entry i
+    std::vector<int64_t> rows_;
+    std::vector<uint8_t> copies_;   // Vectors of tombstones and of nodes without a matrix row
+    std::vector<uint8_t> zeros_;    // Stand-in for nodes without any vector
+    std::unordered_map<std::string, uint32_t> labels_;  // live id -> label
+    std::unordered_set<uint32_t> dirty_;
+    int64_t entry_point_;
+    int max_level_;
+    size_t deleted_count_;
+    std::mt19937 rng_;
+    double level_mult_;
+
+    using Candidate = std::pair<float, uint32_t>;  // (distance, label)
+    static constexpr int64_t kNoRow = -1;
+    static constexpr int64_t kCopied = -2;
+
+    const uint8_t* rowData(uint32_t label) const {
+        int64_t row = rows_[label];
+        if (row >= 0) return matrix_->codeAt(static_cast<size_t>(row));
+        if (row == kNoRow) return zeros_.data();
+        return copies_.data() + static_cast<size_t>(kCopied - row) * row_bytes_;
+    }
+    // A node's vector; decoded into scratch (dimensions_ floats) when codes are held
+    const float* vectorAt(uint32_t label, float* scratch) const {
+        if (!quantizer_) return reinterpret_cast<const float*>(rowData(label));
+        quantizer_->decode(rowData(label), scratch);
+        return scratch;
+    }
+    std::vector<float> scratch() const { return std::vector<float>(quantizer_ ? dimensions_ : 0); }
+    float distance(const float* a, const float* b) const;
+    int randomLevel();
+    size_t maxLinks(int layer) const;
+
+    uint32_t greedyClosest(const float* query, uint32_t entry, int from_layer, int to_layer) const;
+    std::vector<Candidate> searchLayer(const float* query, uint32_t entry, size_t ef, int layer) const;
+    std::vector<uint32_t> selectNeighbors(std::vector<Candidate> candidates, size_t m) const;
+    void setDimensions(int dimensions);
+    bool rowFits(int64_t row, const std::string& id) const;  // The matrix row holds id in this index's layout
+    void copyRow(uint32_t label, const uint8_t* data);
+    void setRow(uint32_t label, int64_t row);
+};
+
+} // namespace casper
+
+#endif // CASPER_HNSW_INDEX_H
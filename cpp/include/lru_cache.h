@@ -0,0 +1,95 @@
+#ifndef CASPER_LRU_CACHE_H
+#define CASPER_LRU_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace casper {
+
+// Thread-safe in-memory map holding at most `capacity` entries; inserting
+// into a full cache drops the least recently used one. A capacity of 0
+// disables the cache: put() stores nothing and get() always misses.
+template <typename K, typename V>
+class LRUCache {
+public:
+    explicit LRUCache(size_t capacity = 0)
+        : capacity_(capacity) {
+    }
+
+    LRUCache(const LRUCache&) = delete;
+    LRUCache& operator=(const LRUCache&) = delete;
+
+    // Copies the value out and marks the entry as most recently used
+    bool get(const K& key, V& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) return false;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        value = it->second->second;
+        return true;
+    }
+
+    void put(const K& key, V value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (capacity_ == 0) return;
+
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            it->second->second = std::move(value);
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return;
+        }
+
+        entries_.emplace_front(key, std::move(value));
+        index_[key] = entries_.begin();
+        trim();
+    }
+
+    bool erase(const K& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) return false;
+        entries_.erase(it->second);
+        index_.erase(it);
+        return true;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+    }
+
+    void setCapacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        trim();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+private:
+    using Entry = std::pair<K, V>;
+
+    void trim() {
+        while (entries_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+
+    size_t capacity_;
+    std::list<Entry> entries_;  // Most recently used first
+    std::unordered_map<K, typename std::list<Entry>::iterator> index_;
+    std::mutex mutex_;
+};
+
+} // namespace casper
+
+#endif // CASPER_LRU_CACHE_H
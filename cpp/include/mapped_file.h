@@ -0,0 +1,60 @@
+#ifndef CASPER_MAPPED_FILE_H
+#define CASPER_MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstddef>
+
+namespace casper {
+
+// Read-only, memory-mapped view of a whole file.
+//
+// Nothing is copied: the kernel pages the file in as the view is read, and
+// release() hands pages that are done with back, so reading a file far
+// larger than RAM keeps a bounded resident set. Empty files open with an
+// empty view.
+//
+// A file that shrinks while it is mapped would raise SIGBUS on the pages
+// past its new end. Those pages read as zeros instead, and changed() tells
+// the caller that the view no longer matches the file.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Files smaller than map_from bytes are read into memory instead
+    bool open(const std::string& path, size_t map_from = 0);
+    void close();
+    bool isOpen() const { return open_; }
+    bool isMapped() const { return slot_ >= 0; }
+    // True once a read of the mapping ran past the end of the file
+    bool changed() const;
+
+    std::string_view view() const { return std::string_view(static_cast<const char*>(data_), size_); }
+    size_t size() const { return size_; }
+
+    // Drop the whole pages inside [offset, offset + length) from memory;
+    // they are read from the file again if touched later
+    void release(size_t offset, size_t length);
+
+    // Heuristic on a leading sample: NUL bytes, or more than 10% control
+    // characters other than whitespace, backspace and escape
+    static bool looksBinary(std::string_view sample);
+
+private:
+    void* data_;
+    size_t size_;
+    bool open_;
+    int slot_;                      // Fault guard slot of the mapping, -1 when read
+    std::unique_ptr<char[]> buffer_;  // Contents of a file that was read
+};
+
+} // namespace casper
+
+#endif // CASPER_MAPPED_FILE_H
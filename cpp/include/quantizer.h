@@ -0,0 +1,91 @@
+#ifndef CASPER_QUANTIZER_H
+#define CASPER_QUANTIZER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace casper {
+
+// Compressed embedding representations
+enum class QuantizationMode {
+    None,   // float32
+    FP16,   // IEEE half precision, 2 bytes per dimension
+    Int8,   // Symmetric int8 with one float scale per vector
+    PQ      // Product quantization, 1 byte per subspace (256 centroids)
+};
+
+// Encodes unit-length embeddings into fixed-size codes and scores a float
+// query against them. Scores approximate the dot product with the original
+// vector, so they are meant for a first pass that is re-ranked exactly.
+//
+// Code layouts:
+//   FP16 - dims x uint16
+//   Int8 - float scale followed by dims x int8 (value = scale * code)
+//   PQ   - one centroid index per subspace
+class VectorQuantizer {
+public:
+    static constexpr size_t kCentroids = 256;
+    static constexpr size_t kMinTrainingRows = 256;   // PQ needs at least this many samples
+    static constexpr size_t kMaxTrainingRows = 4096;
+
+    // Query prepared for scoring (PQ keeps a per-subspace lookup table)
+    struct PreparedQuery {
+        std::vector<float> query;
+        std::vector<float> table;  // subspaces * kCentroids
+    };
+
+    VectorQuantizer();
+
+    // "none", "fp16", "int8", "pq"; unknown names map to None
+    static QuantizationMode parseMode(const std::string& name);
+    static std::string modeName(QuantizationMode mode);
+
+    // Select the mode and dimensionality; drops any trained codebook
+    void configure(QuantizationMode mode, int dimensions);
+    QuantizationMode mode() const { return mode_; }
+    int dimensions() const { return dimensions_; }
+
+    // True once encode() can be used (PQ additionally needs a codebook)
+    bool ready() const;
+    bool needsTraining() const { return mode_ == QuantizationMode::PQ && centroids_.empty(); }
+    size_t codeSize() const;
+    double compressionRatio() const;  // float32 bytes / code bytes
+
+    // PQ codebook training (k-means per subspace) and persistence.
+    // `rows` are `count` vectors laid out `stride` floats apart.
+    bool train(const float* rows, size_t count, size_t stride);
+    std::string serializeCodebook() const;
+    bool loadCodebook(const void* data, size_t size);
+
+    // Encode one vector of dimensions() floats into codeSize() bytes
+    void encode(const float* vector, uint8_t* code) const;
+    // Approximate reconstruction of an encoded vector (dimensions() floats)
+    void decode(const uint8_t* code, float* vector) const;
+
+    // Approximate dot products of a query with `count` codes stride_bytes apart
+    PreparedQuery prepare(const float* query) const;
+    void scoreBatch(const PreparedQuery& query, const uint8_t* codes, size_t count,
+                    size_t stride_bytes, float* out) const;
+
+private:
+    QuantizationMode mode_;
+    int dimensions_;
+    size_t sub_dims_;      // PQ: floats per subspace
+    size_t subspaces_;     // PQ: dimensions_ / sub_dims_
+    std::vector<float> centroids_;  // PQ: subspaces_ * kCentroids * sub_dims_
+    std::vector<float> columns_;    // PQ: centroids transposed per subspace (sub_dims_ x kCentroids)
+    std::vector<float> centroid_norms_;  // PQ: squared length of each centroid
+
+    const float* centroid(size_t subspace, size_t index) const {
+        return centroids_.data() + (subspace * kCentroids + index) * sub_dims_;
+    }
+    void refreshSubspace(size_t subspace);
+    void dotCentroids(size_t subspace, const float* sub, float scale, float* out) const;
+    size_t nearestCentroid(size_t subspace, const float* sub) const;
+};
+
+} // namespace casper
+
+#endif // CASPER_QUANTIZER_H
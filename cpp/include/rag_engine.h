@@ -3,9 +3,14 @@
 
 #include "vector_db.h"
 #include "embeddings.h"
+#include "embedding_cache.h"
+#include "lru_cache.h"
+#include "directory_watcher.h"
 #include <string>
 #include <vector>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <functional>
 
 namespace casper {
@@ -22,7 +27,7 @@ struct DocumentChunk {
 // RAG context result
 struct RAGContext {
     std::vector<VectorSearchResult> results;
-    std::string formatted_context;
+    std::string formatted_context;   // Packed passages, within max_context_tokens
     int total_tokens_estimate;
 };
 
@@ -33,6 +38,30 @@ struct LearnResult {
     int documents_added;
     int chunks_created;
     std::string source;
+    int chunks_unchanged = 0;   // Already indexed, not embedded again
+    int files_unchanged = 0;    // Skipped, content as last indexed
+    int files_removed = 0;      // Deleted from disk, forgotten
+    int files_skipped = 0;      // Too large, excluded type or binary
+};
+
+// Throughput of one stage of the ingestion pipeline
+struct IngestStageStats {
+    std::string name;              // reader, chunker, embedder or writer
+    int workers = 0;
+    int64_t files = 0;             // Files that passed through the stage
+    int64_t units = 0;             // Bytes read, or chunks produced / embedded / written
+    std::string unit;              // "bytes" or "chunks"
+    double busy_seconds = 0.0;     // Time spent working, summed over workers
+    double stall_seconds = 0.0;    // Time blocked on a full downstream queue
+
+    // Rate the stage sustains while it has work
+    double unitsPerSecond() const { return busy_seconds > 0.0 ? units * workers / busy_seconds : 0.0; }
+};
+
+// Statistics of the last learnDirectory run
+struct IngestStats {
+    double wall_seconds = 0.0;
+    std::vector<IngestStageStats> stages;
 };
 
 // RAG Engine configuration
@@ -41,9 +70,48 @@ struct RAGConfig {
     bool auto_context = true;
     double similarity_threshold = 0.7;
     int max_chunks = 5;
-    int chunk_size = 500;       // Characters per chunk
+    int chunk_size = 500;       // Maximum bytes per chunk
     int chunk_overlap = 50;     // Overlap between chunks
+    std::string chunk_strategy = "sentence";  // Preferred chunk ends: sentence, paragraph or line
+    // Retrieved chunks are packed into at most max_context_tokens (0 = no
+    // limit): adjacent chunks of a source are merged, near-duplicates
+    // dropped and the rest picked by relevance per token (see ContextPacker)
     int max_context_tokens = 2000;
+    double mmr_lambda = 0.7;          // 1 = relevance only, lower favours diverse passages
+    double duplicate_threshold = 0.9; // Word-bigram overlap at which a passage is a duplicate
+    // Hybrid retrieval: keyword (BM25) and vector hits are merged by
+    // reciprocal rank fusion, score = sum of weight / (fusion_k + rank)
+    bool hybrid_search = true;
+    double vector_weight = 1.0;
+    double lexical_weight = 1.0;
+    int fusion_k = 60;
+    int query_cache_size = 256;      // Recent queries whose embedding and results are kept, 0 = off
+    int embedding_batch_size = 32;   // Texts per embedding request
+    int embedding_concurrency = 4;   // Embedding requests kept in flight
+    bool embedding_cache = true;     // Reuse embeddings of unchanged text across runs
+    std::string embedding_cache_path;  // Empty = Config::getDefaultEmbeddingCachePath()
+    int embedding_cache_max_mb = 512;  // 0 = unbounded
+    int local_embedding_dimensions = 256;  // Size of the local provider's vectors
+    // learnDirectory pipeline: threads per stage and files buffered between
+    // stages. The writer is always the calling thread.
+    int ingest_readers = 2;
+    int ingest_chunkers = 0;         // 0 = one per hardware thread
+    int ingest_embedders = 1;        // Concurrent embedBatch calls
+    int ingest_queue_depth = 8;
+    // Per-file policy: files over max_file_mb, with an extension listed in
+    // skip_extensions (comma separated, case-insensitive) or that look
+    // binary are not indexed. Files are memory-mapped; those over
+    // stream_window_mb are embedded and stored one window of chunks at a
+    // time, so memory stays bounded whatever their size.
+    int max_file_mb = 64;            // 0 = no limit
+    bool skip_binary = true;
+    std::string skip_extensions = ".png,.jpg,.jpeg,.gif,.ico,.pdf,.zip,.gz,.tar,.jar,.so,.o,.a,.exe,.dll,.pyc,.db,.sqlite";
+    int stream_window_mb = 4;
+    // Keep directories passed to learnDirectory indexed as files change
+    // (Linux only). A batch of changes is re-indexed incrementally once no
+    // event has arrived for watch_debounce_ms.
+    bool watch_directories = false;
+    int watch_debounce_ms = 500;
 };
 
 // RAG Engine - orchestrates learning and retrieval
@@ -52,7 +120,8 @@ public:
     RAGEngine();
     ~RAGEngine();
 
-    // Initialize with vector DB and embeddings
+    // Initialize with vector DB and embeddings. vector_path holds the
+    // default collection (see VectorDB::collectionPath).
     bool initialize(const std::string& vector_backend, const std::string& vector_path,
                    const std::string& embedding_provider, const std::string& ollama_host,
                    const std::string& embedding_model);
@@ -60,28 +129,60 @@ public:
     // Configuration
     void setConfig(const RAGConfig& config);
     RAGConfig getConfig() const;
+    void setVectorDBOptions(const VectorDBOptions& options);
+
+    // Collections. Every operation below works on one collection, named by
+    // its last argument; "" is the default collection. A collection is
+    // created on first use and keeps the embedding model it was first
+    // filled with: its queries and new chunks are embedded with that model
+    // even after the configured one changes, until it is forgotten entirely.
+    std::vector<std::string> listCollections();
+
+    // Learning operations. Files are re-indexed incrementally: unchanged files
+    // are skipped, and only the chunks of a changed file that differ from the
+    // last run are embedded again. learnDirectory also forgets files that
+    // were learned from the directory before and no longer exist, and runs
+    // reading, chunking, embedding and writing as a pipeline of concurrent
+    // stages (see RAGConfig::ingest_*).
+    LearnResult learnFile(const std::string& file_path, const std::string& collection = "");
+    LearnResult learnDirectory(const std::string& dir_path, const std::string& pattern = "*",
+                               const std::string& collection = "");
+    LearnResult learnText(const std::string& text, const std::string& source, const std::string& collection = "");
+    LearnResult learnUrl(const std::string& url, const std::string& collection = "");
 
-    // Learning operations
-    LearnResult learnFile(const std::string& file_path);
-    LearnResult learnDirectory(const std::string& dir_path, const std::string& pattern = "*");
-    LearnResult learnText(const std::string& text, const std::string& source);
-    LearnResult learnUrl(const std::string& url);
+    // Live indexing (see RAGConfig::watch_directories). Changed files under a
+    // watched directory are re-indexed on a low-priority background thread;
+    // retrieval only waits for the write of each file (for files over
+    // stream_window_mb, which are embedded window by window as they are
+    // written, for their embedding too).
+    bool watchDirectory(const std::string& dir_path, const std::string& pattern = "*",
+                        const std::string& collection = "");
+    void unwatchDirectory(const std::string& dir_path, const std::string& collection = "");
+    std::vector<std::string> getWatchedDirectories();
 
     // Forgetting operations
-    bool forget(const std::string& source);
-    bool forgetAll();
+    bool forget(const std::string& source, const std::string& collection = "");
+    bool forgetAll(const std::string& collection = "");
 
-    // Retrieval operations
-    RAGContext retrieve(const std::string& query, int max_results = -1);
+    // Retrieval operations. With hybrid_search, passages found only by
+    // keyword are returned too.
+    RAGContext retrieve(const std::string& query, int max_results = -1, const SearchFilter& filter = SearchFilter(),
+                        const std::string& collection = "");
 
-    // Context injection for prompts
+    // Context injection for prompts (default collection). Only passages the
+    // vector search finds above similarity_threshold are injected; keyword
+    // matches can raise their rank but not add passages of their own.
     std::string injectContext(const std::string& user_message);
 
-    // Get learned sources
-    std::vector<std::string> getSources();
+    // Learned sources, from the vector DB's source catalog
+    std::vector<std::string> getSources(const std::string& collection = "");
+    std::vector<SourceInfo> getSourceInfo(const std::string& prefix = "", const std::string& collection = "");
+    bool getSource(const std::string& source, SourceInfo& info, const std::string& collection = "");
 
     // Statistics
-    VectorDBStats getStats();
+    VectorDBStats getStats(const std::string& collection = "");
+    EmbeddingCacheStats getEmbeddingCacheStats();
+    IngestStats getIngestStats() const;
 
     // Status
     bool isInitialized() const;
@@ -91,16 +192,94 @@ public:
     void setProgressCallback(std::function<void(const std::string&, int, int)> callback);
 
 private:
-    std::unique_ptr<VectorDB> vector_db_;
+    // One open collection. embedder is embedder_, unless the collection was
+    // filled with another model than the configured one.
+    struct Collection {
+        std::string name;
+        std::unique_ptr<VectorDB> db;
+        EmbeddingClient* embedder = nullptr;
+        std::unique_ptr<EmbeddingClient> own_embedder;
+        std::string own_model;  // "provider/model" of own_embedder
+    };
+
     std::unique_ptr<EmbeddingClient> embedder_;
+    std::string vector_backend_;
+    std::string vector_path_;
+    std::string ollama_host_;
+    std::map<std::string, std::unique_ptr<Collection>> collections_;  // Opened on first use
     RAGConfig config_;
+    VectorDBOptions vector_options_;
     bool initialized_;
     std::function<void(const std::string&, int, int)> progress_callback_;
+    IngestStats ingest_stats_;
+
+    // Recent retrievals. A query's embedding only depends on its text; its
+    // results are tagged with the vector DB generation they were computed at
+    // and ignored once the database has changed.
+    struct CachedResults {
+        uint64_t generation;
+        std::vector<VectorSearchResult> results;
+    };
+    LRUCache<std::string, Embedding> query_embeddings_;
+    LRUCache<std::string, CachedResults> query_results_;
+
+    // Serializes vector DB access once the watcher re-indexes in the
+    // background. Recursive because learnDirectory forgets through forget().
+    mutable std::recursive_mutex index_mutex_;
+    std::mutex watch_mutex_;
+    // (collection, watched root) -> file pattern
+    std::map<std::pair<std::string, std::string>, std::string> watch_patterns_;
+    std::unique_ptr<DirectoryWatcher> watcher_;          // Declared last: stopped first
+
+    struct SourceFile {
+        std::string path;
+        int64_t size;
+        int64_t mtime;  // Nanoseconds
+    };
+    struct IngestItem;
+
+    // Ingestion stages, applied in this order to each file (embedChunks to
+    // several at once). Only commitSource touches the vector DB; the others
+    // are safe to run on worker threads. Each returns the units it processed
+    // (see IngestStageStats).
+    int64_t readSource(IngestItem& item);
+    int64_t planChunks(IngestItem& item);
+    int64_t embedChunks(const std::vector<IngestItem*>& items);
+    int64_t commitSource(IngestItem& item);
+    // commitSource for files over stream_window_mb: embeds and stores the
+    // fresh chunks window by window. Returns the chunks stored, -1 on failure.
+    int streamChunks(IngestItem& item, bool manifests);
+
+    // Watcher callback: re-learns changed files, rescans new directories and
+    // forgets what was deleted
+    void refreshPaths(const std::vector<std::string>& paths);
+    void refreshFile(Collection& collection, const std::string& path);
+
+    // Opens the collection on first use; nullptr if the name is invalid or
+    // its database cannot be opened. Called with index_mutex_ held.
+    Collection* openCollection(const std::string& name);
+    // Picks the embedder for a freshly opened or emptied collection
+    void assignEmbedder(Collection& collection);
+    // Gives the collection an embedder of its own for model ("provider/model")
+    void pinEmbedder(Collection& collection, const std::string& model);
 
     // Helper methods
+    // Batching, cache and local dimensions from config_; model, if given,
+    // is the "provider/model" a collection's own embedder must use
+    void applyEmbedderConfig(EmbeddingClient& embedder, const std::string& model = "");
     std::vector<DocumentChunk> chunkText(const std::string& text, const std::string& source);
-    std::string readFile(const std::string& path);
-    std::vector<std::string> listFiles(const std::string& dir_path, const std::string& pattern);
+    // ids may be empty (generated by the vector DB)
+    int storeChunks(Collection& collection, const std::vector<DocumentChunk>& chunks,
+                    const std::vector<std::string>& ids, bool chunk_metadata, std::string& error);
+    std::vector<SourceFile> listFiles(const std::string& dir_path, const std::string& pattern);
+    // keyword_hits: whether passages found only by keyword are kept
+    RAGContext retrieveContext(const std::string& query, int max_results, const SearchFilter& filter,
+                               const std::string& collection, bool keyword_hits);
+    bool searchIndex(Collection& collection, const std::string& query, int top_k, const SearchFilter& filter,
+                     bool keyword_hits, std::vector<VectorSearchResult>& results);
+    std::vector<VectorSearchResult> fuseResults(const std::vector<VectorSearchResult>& semantic,
+                                                const std::vector<VectorSearchResult>& lexical, int top_k,
+                                                bool keyword_hits) const;
     std::string formatContext(const std::vector<VectorSearchResult>& results);
     int estimateTokens(const std::string& text);
 };
@@ -0,0 +1,54 @@
+#ifndef CASPER_SIMD_KERNELS_H
+#define CASPER_SIMD_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace casper {
+namespace simd {
+
+// Vectorized float kernels used by similarity search.
+//
+// On x86-64 the implementation (AVX-512, AVX2+FMA, SSE4.2 or scalar) is
+// picked once, on first use, from CPUID. On AArch64 NEON is always used.
+// All pointers may be unaligned; rows of a block are `stride` floats apart.
+
+// Name of the selected implementation ("avx512", "avx2", "sse4.2", "neon", "scalar")
+const char* activeKernel();
+
+// Sum of a[i] * b[i]
+float dot(const float* a, const float* b, size_t n);
+
+// Sum of a[i] * a[i]
+float squaredNorm(const float* a, size_t n);
+
+// Dot product and both squared norms in a single pass
+void dotAndNorms(const float* a, const float* b, size_t n, float& dot, float& norm_a, float& norm_b);
+
+// a[i] *= factor
+void scale(float* a, size_t n, float factor);
+
+// y[i] += a * x[i]
+void axpy(float* y, const float* x, size_t n, float a);
+
+// One query against `count` rows: out[r] = dot(query, rows + r * stride)
+void dotBatch(const float* query, const float* rows, size_t count, size_t dims, size_t stride, float* out);
+
+// Dot product of a float query with an IEEE half-precision vector
+float dotF16(const float* query, const uint16_t* half, size_t n);
+
+// Dot product of a float query with a signed 8-bit vector (unscaled)
+float dotI8(const float* query, const int8_t* codes, size_t n);
+
+// Scalar IEEE 754 binary16 conversions (round to nearest even)
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+// One query against `count` rows: out[r] = cosine(query, rows + r * stride).
+// Rows with zero norm score 0.
+void cosineBatch(const float* query, const float* rows, size_t count, size_t dims, size_t stride, float* out);
+
+} // namespace simd
+} // namespace casper
+
+#endif // CASPER_SIMD_KERNELS_H
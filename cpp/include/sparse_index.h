@@ -0,0 +1,87 @@
+#ifndef CASPER_SPARSE_INDEX_H
+#define CASPER_SPARSE_INDEX_H
+
+#include "embeddings.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace casper {
+
+// Non-zero entries of a vector as (dimension, value), dimensions ascending
+using SparseVector = std::vector<std::pair<uint32_t, float>>;
+
+// Inverted index over mostly-zero embeddings, such as the hashed n-gram
+// vectors of LocalEmbeddingProvider at large dimensionalities.
+//
+// Every dimension keeps a posting list of (document, value) in insertion
+// order plus the largest and smallest value in it. search() scores exactly
+// by dot product, document at a time with MaxScore pruning: the query's
+// dimensions are ordered by how much they can add to a score at most, and
+// those that together cannot lift a document into the current top k are
+// only probed for documents the others already found. A query therefore
+// touches only documents that share a dimension with it (others, scoring
+// 0, are never returned), and of those mostly the ones that can still win.
+//
+// Removal leaves the postings in place until dead documents outnumber live
+// ones; the lists are then compacted. Replacing a document re-adds it.
+class SparseIndex {
+public:
+    SparseIndex();
+
+    // Drop everything; dimensions == 0 means "take from first document"
+    void reset(int dimensions = 0);
+
+    // Insert or replace a document. Vectors of another dimensionality are
+    // rejected.
+    bool upsert(const std::string& id, const SparseVector& vector, int dimensions);
+    bool remove(const std::string& id);
+    bool contains(const std::string& id) const { return numbers_.count(id) > 0; }
+
+    // (score, id) of the best k documents scoring at least threshold, best
+    // first. allowed, if given, restricts the search to those ids.
+    std::vector<std::pair<float, std::string>> search(const SparseVector& query, size_t k, float threshold,
+                                                      const std::vector<std::string>* allowed = nullptr) const;
+
+    size_t size() const { return numbers_.size(); }
+    bool empty() const { return numbers_.empty(); }
+    int dimensions() const { return dimensions_; }
+    size_t memoryBytes() const;
+
+    // Non-zero entries of a dense vector
+    static SparseVector fromDense(const float* values, size_t count);
+    // True if a vector with this many non-zero entries out of `dimensions`
+    // is worth storing sparsely (at most a quarter non-zero)
+    static bool worthStoring(size_t non_zero, size_t dimensions) { return non_zero * 4 <= dimensions; }
+
+    // Storage format: a NaN marker (never a valid first float of a dense
+    // embedding), the dimensionality, then every dimension and every value
+    // as 32-bit words
+    static std::string serialize(const SparseVector& vector, int dimensions);
+    static bool isSerialized(const void* data, size_t size);
+    static bool deserialize(const void* data, size_t size, SparseVector& vector, int& dimensions);
+    static Embedding toDense(const SparseVector& vector, int dimensions);
+
+private:
+    struct PostingList {
+        std::vector<uint32_t> docs;    // Ascending
+        std::vector<float> values;
+        float max_value = 0.0f;
+        float min_value = 0.0f;
+    };
+
+    int dimensions_;
+    std::vector<std::string> ids_;     // Document number -> id, empty once removed
+    std::unordered_map<std::string, uint32_t> numbers_;
+    std::unordered_map<uint32_t, PostingList> postings_;
+    size_t entries_;                   // Postings held, dead ones included
+
+    void compact();
+};
+
+} // namespace casper
+
+#endif // CASPER_SPARSE_INDEX_H
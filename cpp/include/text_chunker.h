@@ -0,0 +1,48 @@
+#ifndef CASPER_TEXT_CHUNKER_H
+#define CASPER_TEXT_CHUNKER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+namespace casper {
+
+// Preferred places to end a chunk
+enum class ChunkStrategy {
+    Sentence,   // After . ! or ? followed by whitespace, or a blank line
+    Paragraph,  // After a blank line
+    Line        // After a line break
+};
+
+// Splits text into chunks of at most chunk_size bytes in one forward pass.
+//
+// Chunks are views into the caller's buffer, so nothing is copied. Cuts are
+// only made at the end of a whitespace run, where the run is classified as
+// a word, sentence, line or paragraph break. When a chunk is full it ends at
+// the latest break the strategy prefers. If that break lies in the first
+// half of the chunk, it ends at the latest line or sentence break, then at
+// any word break. Text without whitespace is cut at chunk_size, on a UTF-8
+// character boundary. Consecutive chunks share up to `overlap` bytes,
+// starting at a word boundary. Leading and trailing whitespace is trimmed
+// from every chunk.
+class TextChunker {
+public:
+    TextChunker(size_t chunk_size, size_t overlap, ChunkStrategy strategy = ChunkStrategy::Sentence);
+
+    // "sentence", "paragraph", "line"; unknown names map to Sentence
+    static ChunkStrategy parseStrategy(const std::string& name);
+    static std::string strategyName(ChunkStrategy strategy);
+
+    // Views stay valid as long as the text they point into
+    std::vector<std::string_view> split(std::string_view text) const;
+
+private:
+    size_t chunk_size_;
+    size_t overlap_;
+    ChunkStrategy strategy_;
+};
+
+} // namespace casper
+
+#endif // CASPER_TEXT_CHUNKER_H
@@ -0,0 +1,62 @@
+#ifndef CASPER_TOP_K_H
+#define CASPER_TOP_K_H
+
+#include <vector>
+#include <utility>
+#include <functional>
+#include <cstddef>
+
+namespace casper {
+
+// Bounded top-k selection over (score, index) pairs, where index refers to a
+// candidate the caller can materialize later (matrix row, response position).
+//
+// Keeps at most k entries in a min-heap keyed on score, so the k-th best
+// score is always at the root. Scans compare against bound() first and skip
+// push() for rows that cannot make the cut.
+class TopKSelector {
+public:
+    using Entry = std::pair<float, size_t>;  // (score, index)
+
+    TopKSelector(size_t k, float threshold);
+
+    // Lowest score that can still enter: the threshold until k entries are
+    // held, then the current k-th best score
+    float bound() const { return bound_; }
+
+    // Offer a candidate; returns true if it was kept
+    bool push(float score, size_t index);
+
+    // Offer every entry held by another selector (merging partial results)
+    void merge(const TopKSelector& other);
+
+    size_t size() const { return heap_.size(); }
+    size_t capacity() const { return k_; }
+    bool empty() const { return heap_.empty(); }
+
+    // Entries ordered by descending score (ties by ascending index);
+    // leaves the selector empty
+    std::vector<Entry> take();
+
+private:
+    size_t k_;
+    float threshold_;
+    float bound_;
+    std::vector<Entry> heap_;
+
+    void updateBound();
+};
+
+class WorkerPool;
+
+// Scan candidates [0, count) for the top k. With a pool, the range is split
+// into contiguous partitions, each scanned into its own selector on a worker
+// thread, and the partial heaps are merged. Without one (or with a single
+// partition) `scan` runs once over the whole range on the calling thread.
+using TopKScan = std::function<void(size_t begin, size_t end, TopKSelector& top)>;
+TopKSelector parallelTopK(WorkerPool* pool, size_t count, size_t k, float threshold,
+                          size_t partitions, const TopKScan& scan);
+
+} // namespace casper
+
+#endif // CASPER_TOP_K_H
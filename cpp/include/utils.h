@@ -2,7 +2,9 @@
 #define CASPER_UTILS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <cstddef>
 
 namespace casper {
 namespace utils {
@@ -14,6 +16,10 @@ bool startsWith(const std::string& str, const std::string& prefix);
 bool endsWith(const std::string& str, const std::string& suffix);
 std::string toLower(const std::string& str);
 
+// Hashing: 128-bit FNV-1a, for content addressing (not cryptographic)
+void hash128(const void* data, size_t size, unsigned char out[16]);
+std::string hash128Hex(std::string_view data);  // 32 lowercase hex digits
+
 // File utilities
 bool fileExists(const std::string& path);
 bool dirExists(const std::string& path);
@@ -2,10 +2,19 @@
 #define CASPER_VECTOR_DB_H
 
 #include "embeddings.h"
+#include "hnsw_index.h"
+#include "embedding_matrix.h"
+#include "quantizer.h"
+#include "sparse_index.h"
+#include "worker_pool.h"
 #include <string>
 #include <vector>
 #include <memory>
 #include <functional>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
 
 namespace casper {
 
@@ -17,6 +26,7 @@ struct VectorDocument {
     std::string metadata;     // JSON metadata
     Embedding embedding;
     int64_t timestamp;
+    float norm = 0.0f;        // Length of the embedding before normalization (0 = unknown)
 };
 
 // Search result
@@ -26,6 +36,41 @@ struct VectorSearchResult {
     float distance;           // Raw distance
 };
 
+// Restricts a search to part of the collection; unset fields match everything
+struct SearchFilter {
+    std::string source_prefix;
+    int64_t min_timestamp = 0;    // Inclusive, 0 = no lower bound
+    int64_t max_timestamp = 0;    // Inclusive, 0 = no upper bound
+    // Equality on top-level metadata keys, e.g. {"chunk_index", "3"}.
+    // Numbers and true/false compare by value, anything else as a string.
+    std::map<std::string, std::string> metadata;
+
+    bool empty() const;
+    // timestamp < 0 means "unknown" and is not checked
+    bool matches(const std::string& source, const std::string& metadata_json, int64_t timestamp) const;
+};
+
+// What was indexed for one source file, so re-learning it can skip unchanged
+// files and replace only the chunks that changed
+struct SourceManifest {
+    std::string source;
+    int64_t size = 0;
+    int64_t mtime = 0;                    // Modification time in nanoseconds
+    std::string content_hash;             // utils::hash128Hex of the file
+    std::vector<std::string> chunk_ids;   // Document ids, in chunk order
+    int64_t indexed_at = 0;
+};
+
+// Catalog entry for one source: what was learned from it, without loading
+// any of its chunks
+struct SourceInfo {
+    std::string source;
+    int64_t chunks = 0;
+    int64_t bytes = 0;               // Chunk text; embeddings are not counted
+    int64_t last_indexed = 0;        // Newest chunk timestamp (seconds)
+    std::string embedding_model;     // "provider/model" at the last insert, if known
+};
+
 // Vector database statistics
 struct VectorDBStats {
     int64_t document_count;
@@ -33,6 +78,48 @@ struct VectorDBStats {
     std::string backend;
     std::string path;
     int64_t size_bytes;
+    std::string quantization = "none";  // Representation used by the resident first pass
+    double compression_ratio = 1.0;     // float32 size / resident code size
+    int64_t resident_bytes = 0;         // Memory held by the resident matrix, HNSW graph and sparse index
+    int64_t sparse_documents = 0;       // Stored sparsely, searched through the inverted index
+    std::string embedding_model;        // "provider/model" recorded for new documents, if known
+};
+
+// Vector database tuning options
+struct VectorDBOptions {
+    // HNSW approximate nearest neighbour index (SQLite backend)
+    bool hnsw_enabled = true;
+    int hnsw_m = 16;
+    int hnsw_ef_construction = 200;
+    int hnsw_ef_search = 100;
+    int64_t hnsw_min_documents = 5000;  // Below this, search stays exact (brute force)
+
+    // Resident embedding compression: "none", "fp16", "int8" or "pq".
+    // Quantized scans re-rank top_k * rerank_factor candidates exactly
+    // (four times as many for pq).
+    std::string quantization = "none";
+    int rerank_factor = 4;
+
+    // Embeddings that are at most a quarter non-zero (the local provider's
+    // hashed vectors at large dimensionalities) are stored as (dimension,
+    // value) pairs and searched through an inverted index instead of the
+    // resident matrix and HNSW graph. Turning this off only affects new rows.
+    bool sparse_vectors = true;
+
+    // Brute-force scans are split across this many threads (0 = one per
+    // hardware thread, 1 = no fan-out) once the collection is large enough
+    int search_threads = 0;
+    int64_t parallel_min_documents = 20000;
+
+    // Chroma backend: batch inserts are split into upserts of at most this
+    // many bytes of JSON, up to chroma_concurrency of them in flight
+    int64_t chroma_batch_bytes = 4194304;
+    int chroma_concurrency = 4;
+
+    // SQLite connection tuning (the database always runs in WAL mode)
+    std::string sqlite_synchronous = "normal";  // off, normal, full or extra
+    int sqlite_cache_kb = 65536;                 // Page cache per connection
+    int64_t sqlite_mmap_bytes = 268435456;       // 0 disables memory-mapped reads
 };
 
 // Vector database backend interface
@@ -40,6 +127,9 @@ class VectorDBBackend {
 public:
     virtual ~VectorDBBackend() = default;
 
+    // Tuning (backends ignore options they do not support)
+    virtual void configure(const VectorDBOptions& options) { (void)options; }
+
     // Lifecycle
     virtual bool open(const std::string& path) = 0;
     virtual void close() = 0;
@@ -53,12 +143,24 @@ public:
     virtual bool removeBySource(const std::string& source) = 0;
 
     // Search
-    virtual std::vector<VectorSearchResult> search(const Embedding& query, int top_k = 10, float threshold = 0.0f) = 0;
+    virtual std::vector<VectorSearchResult> search(const Embedding& query, int top_k = 10, float threshold = 0.0f,
+                                                   const SearchFilter& filter = SearchFilter()) = 0;
+    // Keyword search over content, best first (documents come without their
+    // embedding). May run concurrently with search(). Empty if unsupported.
+    virtual bool supportsTextSearch() const { return false; }
+    virtual std::vector<VectorSearchResult> searchText(const std::string& query, int top_k = 10,
+                                                       const SearchFilter& filter = SearchFilter()) {
+        (void)query; (void)top_k; (void)filter;
+        return {};
+    }
 
     // Retrieval
     virtual VectorDocument get(const std::string& id) = 0;
     virtual std::vector<VectorDocument> getBySource(const std::string& source) = 0;
     virtual std::vector<VectorDocument> getAll(int limit = 1000, int offset = 0) = 0;
+    // Visit every document in storage order; stops early if fn returns false.
+    // The default pages through getAll().
+    virtual bool forEach(const std::function<bool(const VectorDocument&)>& fn);
 
     // Metadata
     virtual VectorDBStats getStats() = 0;
@@ -67,6 +169,30 @@ public:
     // Maintenance
     virtual bool optimize() = 0;
     virtual bool clear() = 0;
+
+    // Bulk ingestion: between these calls a backend may defer index
+    // maintenance and batch commits. Calls nest; the outermost end applies.
+    virtual void beginBulkLoad() {}
+    virtual void endBulkLoad() {}
+
+    // Rewrite one document's metadata without touching its embedding.
+    // The default goes through get() and update().
+    virtual bool updateMetadata(const std::string& id, const std::string& metadata);
+
+    // Source manifests (incremental re-indexing). Backends that cannot store
+    // them report false from supportsManifests() and callers re-index fully.
+    virtual bool supportsManifests() const { return false; }
+    virtual bool getManifest(const std::string& source, SourceManifest& manifest) { (void)source; (void)manifest; return false; }
+    virtual bool putManifest(const SourceManifest& manifest) { (void)manifest; return false; }
+    virtual bool removeManifest(const std::string& source) { (void)source; return false; }
+    virtual std::vector<SourceManifest> listManifests(const std::string& prefix = "") { (void)prefix; return {}; }
+
+    // Source catalog, ordered by source. The defaults aggregate forEach(),
+    // so they read every document; backends that can should keep a catalog.
+    virtual std::vector<SourceInfo> listSources(const std::string& prefix = "");
+    virtual bool getSource(const std::string& source, SourceInfo& info);
+    // Model recorded in the catalog for documents inserted from now on
+    virtual void setEmbeddingModel(const std::string& model) { (void)model; }
 };
 
 // SQLite-based vector database (using manual similarity calculation)
@@ -75,6 +201,8 @@ public:
     SQLiteVectorDB();
     ~SQLiteVectorDB() override;
 
+    void configure(const VectorDBOptions& options) override;
+
     bool open(const std::string& path) override;
     void close() override;
     bool isOpen() const override;
@@ -85,11 +213,19 @@ public:
     bool remove(const std::string& id) override;
     bool removeBySource(const std::string& source) override;
 
-    std::vector<VectorSearchResult> search(const Embedding& query, int top_k = 10, float threshold = 0.0f) override;
+    std::vector<VectorSearchResult> search(const Embedding& query, int top_k = 10, float threshold = 0.0f,
+                                           const SearchFilter& filter = SearchFilter()) override;
+    // BM25 over the vectors_fts FTS5 index, queried through a second,
+    // read-only connection so it can overlap a vector search. Query words
+    // are OR-ed; common English words are dropped.
+    bool supportsTextSearch() const override { return text_search_; }
+    std::vector<VectorSearchResult> searchText(const std::string& query, int top_k = 10,
+                                               const SearchFilter& filter = SearchFilter()) override;
 
     VectorDocument get(const std::string& id) override;
     std::vector<VectorDocument> getBySource(const std::string& source) override;
     std::vector<VectorDocument> getAll(int limit = 1000, int offset = 0) override;
+    bool forEach(const std::function<bool(const VectorDocument&)>& fn) override;
 
     VectorDBStats getStats() override;
     std::string getName() const override { return "sqlite"; }
@@ -97,14 +233,88 @@ public:
     bool optimize() override;
     bool clear() override;
 
+    // Holds one transaction open, drops idx_timestamp and keeps new rows out
+    // of the HNSW graph until endBulkLoad(); search stays exact meanwhile
+    void beginBulkLoad() override;
+    void endBulkLoad() override;
+
+    bool updateMetadata(const std::string& id, const std::string& metadata) override;
+
+    // Kept in the source_manifest table, cleared together with the vectors
+    bool supportsManifests() const override { return true; }
+    bool getManifest(const std::string& source, SourceManifest& manifest) override;
+    bool putManifest(const SourceManifest& manifest) override;
+    bool removeManifest(const std::string& source) override;
+    std::vector<SourceManifest> listManifests(const std::string& prefix = "") override;
+
+    // Kept in the sources table by triggers on vectors, so it changes in the
+    // same transaction as the chunks and never reads an embedding
+    std::vector<SourceInfo> listSources(const std::string& prefix = "") override;
+    bool getSource(const std::string& source, SourceInfo& info) override;
+    void setEmbeddingModel(const std::string& model) override;
+
 private:
     void* db_;  // sqlite3*
     std::string db_path_;
     int dimensions_;
-
+    VectorDBOptions options_;
+    std::map<std::string, void*> statements_;  // sqlite3_stmt*, prepared once per connection
+    int bulk_depth_;
+    int64_t bulk_rows_;                         // Rows written since the last bulk commit
+    std::vector<std::string> bulk_pending_;     // Ids waiting to enter the HNSW graph
+    EmbeddingMatrix matrix_;  // Resident copy of all dense embeddings (or their codes), loaded on open
+    SparseIndex sparse_;      // Postings of the sparsely stored embeddings, loaded on open
+    VectorQuantizer quantizer_;
+    HNSWIndex index_;
+    std::unique_ptr<WorkerPool> pool_;  // Scan threads, created on first parallel search
+    bool text_search_;                  // vectors_fts exists (SQLite built with FTS5)
+    void* read_db_;                     // sqlite3*, read-only connection for searchText
+    void* text_stmt_;                   // sqlite3_stmt* on read_db_
+    std::mutex text_mutex_;
+
+    void applyPragmas();
+    void initializeTextIndex();
+    void* statement(const char* sql);  // Cached sqlite3_stmt*, reset and unbound
+    void finalizeStatements();
+    void commitBulkProgress();
     void initializeTables();
+    void migrateSchema(int from_version);
+    void loadResident();
+    void removeResident(const std::string& id);
+    bool prepareCodes(int64_t count);
+    std::string readMeta(const std::string& key);
+    void writeMeta(const std::string& key, const std::string& value);
+    WorkerPool* scanPool(size_t rows);
+    std::vector<std::string> filteredIds(const SearchFilter& filter, const std::vector<std::string>* among = nullptr);
+    bool filterReaches(const SearchFilter& filter, size_t count);
+    std::vector<size_t> filteredRows(const SearchFilter& filter);
+    std::vector<VectorSearchResult> searchDense(const Embedding& query, int top_k, float threshold,
+                                                const SearchFilter& filter);
+    bool searchGraph(const Embedding& query, int top_k, float threshold, const SearchFilter& filter,
+                     std::vector<VectorSearchResult>& results);
+    std::vector<VectorSearchResult> searchCodes(const Embedding& unit_query, int top_k, float threshold,
+                                                const std::vector<size_t>* subset);
+    // Second pass over quantized candidates: first-pass depth and threshold
+    // slack for the current mode, and exact scoring of the candidates with
+    // their stored float embeddings
+    size_t rerankCandidates(int top_k) const;
+    float rerankSlack() const;
+    std::vector<VectorSearchResult> rerankExact(const Embedding& unit_query, const std::vector<std::string>& ids,
+                                                int top_k, float threshold);
+    bool insertRow(const VectorDocument& doc);
+    std::vector<std::string> idsForSource(const std::string& source);
+    VectorDocument getResult(const std::string& id);  // get() without the embedding, for search results
+
+    // HNSW index maintenance (persisted in hnsw_nodes / hnsw_meta)
+    void loadIndex();
+    void rebuildIndex();
+    void persistIndex();
+    void indexDocument(const std::string& id, const Embedding& embedding);
+    bool useIndex() const;
     std::string serializeEmbedding(const Embedding& emb);
+    // Dense floats, or SparseIndex::serialize() output expanded to dense
     Embedding deserializeEmbedding(const std::string& data);
+    static float normalizeInPlace(Embedding& emb);  // Returns the original length
     std::string generateId();
 };
 
@@ -114,6 +324,8 @@ public:
     ChromaDBBackend();
     ~ChromaDBBackend() override;
 
+    void configure(const VectorDBOptions& options) override;
+
     bool open(const std::string& url) override;  // URL format: http://host:port/collection_name
     void close() override;
     bool isOpen() const override;
@@ -124,7 +336,8 @@ public:
     bool remove(const std::string& id) override;
     bool removeBySource(const std::string& source) override;
 
-    std::vector<VectorSearchResult> search(const Embedding& query, int top_k = 10, float threshold = 0.0f) override;
+    std::vector<VectorSearchResult> search(const Embedding& query, int top_k = 10, float threshold = 0.0f,
+                                           const SearchFilter& filter = SearchFilter()) override;
 
     VectorDocument get(const std::string& id) override;
     std::vector<VectorDocument> getBySource(const std::string& source) override;
@@ -136,12 +349,28 @@ public:
     bool optimize() override;
     bool clear() override;
 
+    // Collections on the server, the one open listed as "default" (see
+    // VectorDB::collectionPath)
+    std::vector<std::string> listCollections();
+
 private:
     std::string base_url_;
     std::string collection_name_;
     bool connected_;
+    size_t batch_bytes_;
+    int concurrency_;
+
+    // Handles are kept open so requests reuse the server connection
+    std::mutex mutex_;                 // Guards all handles
+    void* curl_;                       // CURL*, for single requests
+    void* multi_;                      // CURLM*, for concurrent upserts
+    std::vector<void*> handles_;       // CURL*, one per upsert slot
 
     std::string httpRequest(const std::string& method, const std::string& endpoint, const std::string& body = "");
+    // POST every body to endpoint, up to concurrency_ at a time. False if
+    // any of them fails.
+    bool postConcurrent(const std::string& endpoint, const std::vector<std::string>& bodies);
+    std::string collectionPath(const std::string& action) const;
 };
 
 #ifdef HAVE_FAISS
@@ -161,7 +390,8 @@ public:
     bool remove(const std::string& id) override;
     bool removeBySource(const std::string& source) override;
 
-    std::vector<VectorSearchResult> search(const Embedding& query, int top_k = 10, float threshold = 0.0f) override;
+    std::vector<VectorSearchResult> search(const Embedding& query, int top_k = 10, float threshold = 0.0f,
+                                           const SearchFilter& filter = SearchFilter()) override;
 
     VectorDocument get(const std::string& id) override;
     std::vector<VectorDocument> getBySource(const std::string& source) override;
@@ -188,6 +418,8 @@ public:
     ~VectorDB();
 
     // Configuration
+    void setOptions(const VectorDBOptions& options);
+    VectorDBOptions getOptions() const;
     bool open(const std::string& backend, const std::string& path);
     void close();
     bool isOpen() const;
@@ -196,15 +428,47 @@ public:
     std::string getBackend() const;
     std::string getPath() const;
 
-    // Document operations
+    // Named collections. Each collection is a database of its own with its
+    // own dimensions, embedding model and indexes, so searching one never
+    // touches the others. For file-based backends `path` is either a
+    // directory holding <name>.db per collection, or the default
+    // collection's file with the others beside it as <stem>.<name><ext>;
+    // for Chroma the collection replaces the last component of the URL.
+    // Names are 1-64 letters, digits, '-' or '_'.
+    static constexpr const char* kDefaultCollection = "default";
+    static bool isValidCollectionName(const std::string& name);
+    static std::string collectionPath(const std::string& backend, const std::string& path, const std::string& collection);
+    // Collections that exist under path, sorted
+    static std::vector<std::string> listCollections(const std::string& backend, const std::string& path);
+
+    // Document operations. addBatch generates ids unless they are given.
     bool add(const std::string& content, const std::string& source, const Embedding& embedding, const std::string& metadata = "");
-    bool addBatch(const std::vector<std::string>& contents, const std::vector<std::string>& sources, const std::vector<Embedding>& embeddings);
+    bool addBatch(const std::vector<std::string>& contents, const std::vector<std::string>& sources, const std::vector<Embedding>& embeddings,
+                  const std::vector<std::string>& metadata = {}, const std::vector<std::string>& ids = {});
+    bool updateMetadata(const std::string& id, const std::string& metadata);
     bool remove(const std::string& id);
     bool removeBySource(const std::string& source);
 
+    // Source manifests (see SourceManifest)
+    bool supportsManifests() const;
+    bool getManifest(const std::string& source, SourceManifest& manifest);
+    bool putManifest(const SourceManifest& manifest);
+    bool removeManifest(const std::string& source);
+    std::vector<SourceManifest> listManifests(const std::string& prefix = "");
+
+    // Source catalog (see SourceInfo)
+    std::vector<SourceInfo> listSources(const std::string& prefix = "");
+    bool getSource(const std::string& source, SourceInfo& info);
+    void setEmbeddingModel(const std::string& model);
+
     // Search
-    std::vector<VectorSearchResult> search(const Embedding& query, int top_k = 10, float threshold = 0.0f);
-    std::vector<VectorSearchResult> searchByText(const std::string& query, EmbeddingClient& embedder, int top_k = 10, float threshold = 0.0f);
+    std::vector<VectorSearchResult> search(const Embedding& query, int top_k = 10, float threshold = 0.0f,
+                                           const SearchFilter& filter = SearchFilter());
+    bool supportsTextSearch() const;
+    std::vector<VectorSearchResult> searchText(const std::string& query, int top_k = 10,
+                                               const SearchFilter& filter = SearchFilter());
+    std::vector<VectorSearchResult> searchByText(const std::string& query, EmbeddingClient& embedder, int top_k = 10, float threshold = 0.0f,
+                                                 const SearchFilter& filter = SearchFilter());
 
     // Retrieval
     VectorDocument get(const std::string& id);
@@ -213,11 +477,23 @@ public:
     // Statistics
     VectorDBStats getStats();
 
+    // Incremented after every change made through this object (add, remove,
+    // metadata update, clear, import, reopen), so callers can tell whether
+    // results they cached are still current
+    uint64_t getGeneration() const { return generation_.load(); }
+
     // Maintenance
     bool optimize();
     bool clear();
-
-    // Export/Import
+    void beginBulkLoad();
+    void endBulkLoad();
+
+    // Export/Import. Paths ending in .json use the legacy JSON format; anything
+    // else is written as a binary snapshot (see vector_snapshot.h). Import
+    // detects the format from the file contents. A file that is truncated,
+    // fails a checksum or does not parse is rejected before anything is
+    // inserted; a backend error part way through leaves the documents
+    // inserted until then.
     bool exportTo(const std::string& path);
     bool importFrom(const std::string& path);
 
@@ -228,6 +504,8 @@ private:
     std::unique_ptr<VectorDBBackend> backend_;
     std::string backend_name_;
     std::string path_;
+    VectorDBOptions options_;
+    std::atomic<uint64_t> generation_{0};
 };
 
 } // namespace casper
@@ -0,0 +1,80 @@
+#ifndef CASPER_VECTOR_SNAPSHOT_H
+#define CASPER_VECTOR_SNAPSHOT_H
+
+#include "vector_db.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+namespace casper {
+
+// Binary vector database snapshot, written and read as a stream.
+//
+// Layout (little-endian):
+//   header   "CSPRSNAP", u32 version, u32 dimensions (first document),
+//            u64 document count
+//   blocks   u32 documents (0 terminates the file), u32 CRC-32 of the
+//            documents and payload bytes fields followed by the payload
+//            (version 1: of the payload only), u64 payload bytes, payload
+//   payload  u64 embedding block bytes
+//            embedding block: every document's floats back to back
+//            string table: per document u32 embedding length, i64 timestamp,
+//            f32 norm, then id, content, source, metadata as u32 length + bytes
+//
+// A block holds at most kBlockDocuments documents, so memory use does not
+// depend on the size of the database.
+class SnapshotWriter {
+public:
+    static constexpr uint32_t kBlockDocuments = 4096;
+
+    explicit SnapshotWriter(const std::string& path);
+    ~SnapshotWriter();
+
+    bool isOpen() const { return file_.is_open(); }
+    bool add(const VectorDocument& doc);
+    // Flushes the last block, writes the terminator and the final count
+    bool finish();
+
+    uint64_t documentCount() const { return total_; }
+
+private:
+    std::ofstream file_;
+    std::vector<VectorDocument> pending_;
+    uint64_t total_;
+    uint32_t dimensions_;
+    bool finished_;
+
+    bool flush();
+};
+
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const std::string& path);
+
+    // True if the file starts with the snapshot magic
+    static bool isSnapshot(const std::string& path);
+
+    bool isOpen() const { return ok_; }
+    const std::string& error() const { return error_; }
+    uint32_t version() const { return version_; }
+    uint32_t dimensions() const { return dimensions_; }
+    uint64_t documentCount() const { return total_; }
+
+    // Next block of documents; false at the end of the file or on error
+    // (check error() to tell the two apart)
+    bool nextBlock(std::vector<VectorDocument>& docs);
+
+private:
+    std::ifstream file_;
+    bool ok_;
+    bool done_;
+    std::string error_;
+    uint32_t version_;
+    uint32_t dimensions_;
+    uint64_t total_;
+};
+
+} // namespace casper
+
+#endif // CASPER_VECTOR_SNAPSHOT_H
@@ -0,0 +1,52 @@
+#ifndef CASPER_WORKER_POOL_H
+#define CASPER_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace casper {
+
+// Fixed set of threads for data-parallel loops. run() hands out task
+// indices to the workers and the calling thread alike and returns once every
+// task has finished. Calls to run() are serialized.
+class WorkerPool {
+public:
+    // `threads` counts the caller, so WorkerPool(4) starts three workers.
+    // 0 means one per hardware thread.
+    explicit WorkerPool(size_t threads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t size() const { return workers_.size() + 1; }
+
+    void run(size_t tasks, const std::function<void(size_t)>& task);
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex run_mutex_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t)>* task_;
+    size_t task_count_;
+    std::atomic<size_t> next_task_;
+    size_t active_;
+    uint64_t generation_;
+    bool stop_;
+
+    void workerLoop();
+    void drain();
+};
+
+} // namespace casper
+
+#endif // CASPER_WORKER_POOL_H
@@ -332,13 +332,18 @@ Agent AgentRegistry::getLearnerAgent() {
   - source: File path, directory, URL, or "text"
   - content: Text content (if source is "text")
   - pattern: File pattern for directories (e.g., "*.md")
+  - collection: Named collection to learn into, e.g. one per project (optional, default "default")
+  - status: "true" to list what has been learned instead of indexing; source is then not needed (optional)
 
 **Remember** - Query vector database for relevant context
   - query: What to search for
   - max_results: Number of results (default: 5)
+  - source: Only search sources starting with this path or URL (optional)
+  - collection: Named collection to search; other collections are not searched (optional)
 
 **Forget** - Remove content from vector database
-  - source: Source identifier to remove
+  - source: Source identifier to remove, a directory to remove everything learned from it, or "all"
+  - collection: Named collection to remove from; with "all" only it is emptied (optional)
 
 **Read** - Read local files
   - file_path: Path to file
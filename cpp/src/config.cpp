@@ -30,14 +30,48 @@ Config::Config()
     , vector_backend_("sqlite")
     , vector_path_("")  // Will be set to default in initialize()
     , vector_url_("")
+    , vector_hnsw_enabled_(true)
+    , vector_hnsw_m_(16)
+    , vector_hnsw_ef_search_(100)
+    , vector_quantization_("none")
+    , vector_search_threads_(0)
+    , vector_sqlite_synchronous_("normal")
+    , vector_sqlite_cache_kb_(65536)
+    , vector_sqlite_mmap_bytes_(268435456)
+    , vector_sparse_vectors_(true)
+    , vector_chroma_batch_bytes_(4194304)
+    , vector_chroma_concurrency_(4)
     // Embedding settings
     , embedding_provider_("ollama")
     , embedding_model_("nomic-embed-text")
+    , embedding_batch_size_(32)
+    , embedding_concurrency_(4)
+    , embedding_cache_enabled_(true)
+    , embedding_cache_max_mb_(512)
+    , embedding_local_dimensions_(256)
     // RAG settings
     , rag_enabled_(true)
     , rag_auto_context_(true)
     , rag_similarity_threshold_(0.7)
     , rag_max_chunks_(5)
+    , rag_ingest_readers_(2)
+    , rag_ingest_chunkers_(0)
+    , rag_ingest_embedders_(1)
+    , rag_ingest_queue_depth_(8)
+    , rag_hybrid_search_(true)
+    , rag_vector_weight_(1.0)
+    , rag_lexical_weight_(1.0)
+    , rag_fusion_k_(60)
+    , rag_query_cache_size_(256)
+    , rag_watch_directories_(false)
+    , rag_watch_debounce_ms_(500)
+    , rag_max_file_mb_(64)
+    , rag_skip_binary_(true)
+    , rag_skip_extensions_(".png,.jpg,.jpeg,.gif,.ico,.pdf,.zip,.gz,.tar,.jar,.so,.o,.a,.exe,.dll,.pyc,.db,.sqlite")
+    , rag_stream_window_mb_(4)
+    , rag_max_context_tokens_(2000)
+    , rag_mmr_lambda_(0.7)
+    , rag_duplicate_threshold_(0.9)
     // License settings
     , license_server_url_("http://10.19.0.128:5000")
     , license_key_("")
@@ -197,14 +231,48 @@ bool Config::load() {
         else if (key == "vector_backend") vector_backend_ = value;
         else if (key == "vector_path") vector_path_ = value;
         else if (key == "vector_url") vector_url_ = value;
+        else if (key == "vector_hnsw_enabled") vector_hnsw_enabled_ = (value == "true" || value == "1");
+        else if (key == "vector_hnsw_m") vector_hnsw_m_ = std::stoi(value);
+        else if (key == "vector_hnsw_ef_search") vector_hnsw_ef_search_ = std::stoi(value);
+        else if (key == "vector_quantization") vector_quantization_ = value;
+        else if (key == "vector_search_threads") vector_search_threads_ = std::stoi(value);
+        else if (key == "vector_sqlite_synchronous") vector_sqlite_synchronous_ = value;
+        else if (key == "vector_sqlite_cache_kb") vector_sqlite_cache_kb_ = std::stoi(value);
+        else if (key == "vector_sqlite_mmap_bytes") vector_sqlite_mmap_bytes_ = std::stoll(value);
+        else if (key == "vector_sparse_vectors") vector_sparse_vectors_ = (value == "true" || value == "1");
+        else if (key == "vector_chroma_batch_bytes") vector_chroma_batch_bytes_ = std::stoll(value);
+        else if (key == "vector_chroma_concurrency") vector_chroma_concurrency_ = std::stoi(value);
         // Embedding settings
         else if (key == "embedding_provider") embedding_provider_ = value;
         else if (key == "embedding_model") embedding_model_ = value;
+        else if (key == "embedding_batch_size") embedding_batch_size_ = std::stoi(value);
+        else if (key == "embedding_concurrency") embedding_concurrency_ = std::stoi(value);
+        else if (key == "embedding_cache_enabled") embedding_cache_enabled_ = (value == "true" || value == "1");
+        else if (key == "embedding_cache_max_mb") embedding_cache_max_mb_ = std::stoi(value);
+        else if (key == "embedding_local_dimensions") embedding_local_dimensions_ = std::stoi(value);
         // RAG settings
         else if (key == "rag_enabled") rag_enabled_ = (value == "true" || value == "1");
         else if (key == "rag_auto_context") rag_auto_context_ = (value == "true" || value == "1");
         else if (key == "rag_similarity_threshold") rag_similarity_threshold_ = std::stod(value);
         else if (key == "rag_max_chunks") rag_max_chunks_ = std::stoi(value);
+        else if (key == "rag_ingest_readers") rag_ingest_readers_ = std::stoi(value);
+        else if (key == "rag_ingest_chunkers") rag_ingest_chunkers_ = std::stoi(value);
+        else if (key == "rag_ingest_embedders") rag_ingest_embedders_ = std::stoi(value);
+        else if (key == "rag_ingest_queue_depth") rag_ingest_queue_depth_ = std::stoi(value);
+        else if (key == "rag_hybrid_search") rag_hybrid_search_ = (value == "true" || value == "1");
+        else if (key == "rag_vector_weight") rag_vector_weight_ = std::stod(value);
+        else if (key == "rag_lexical_weight") rag_lexical_weight_ = std::stod(value);
+        else if (key == "rag_fusion_k") rag_fusion_k_ = std::stoi(value);
+        else if (key == "rag_query_cache_size") rag_query_cache_size_ = std::stoi(value);
+        else if (key == "rag_watch_directories") rag_watch_directories_ = (value == "true" || value == "1");
+        else if (key == "rag_watch_debounce_ms") rag_watch_debounce_ms_ = std::stoi(value);
+        else if (key == "rag_max_file_mb") rag_max_file_mb_ = std::stoi(value);
+        else if (key == "rag_skip_binary") rag_skip_binary_ = (value == "true" || value == "1");
+        else if (key == "rag_skip_extensions") rag_skip_extensions_ = value;
+        else if (key == "rag_stream_window_mb") rag_stream_window_mb_ = std::stoi(value);
+        else if (key == "rag_max_context_tokens") rag_max_context_tokens_ = std::stoi(value);
+        else if (key == "rag_mmr_lambda") rag_mmr_lambda_ = std::stod(value);
+        else if (key == "rag_duplicate_threshold") rag_duplicate_threshold_ = std::stod(value);
         // License settings
         else if (key == "license_server_url") license_server_url_ = value;
         else if (key == "license_key") license_key_ = value;
@@ -257,16 +325,50 @@ bool Config::save() {
     saveValue("vector_backend", vector_backend_);
     saveValue("vector_path", vector_path_);
     saveValue("vector_url", vector_url_);
+    saveValue("vector_hnsw_enabled", vector_hnsw_enabled_ ? "true" : "false");
+    saveValue("vector_hnsw_m", std::to_string(vector_hnsw_m_));
+    saveValue("vector_hnsw_ef_search", std::to_string(vector_hnsw_ef_search_));
+    saveValue("vector_quantization", vector_quantization_);
+    saveValue("vector_search_threads", std::to_string(vector_search_threads_));
+    saveValue("vector_sqlite_synchronous", vector_sqlite_synchronous_);
+    saveValue("vector_sqlite_cache_kb", std::to_string(vector_sqlite_cache_kb_));
+    saveValue("vector_sqlite_mmap_bytes", std::to_string(vector_sqlite_mmap_bytes_));
+    saveValue("vector_sparse_vectors", vector_sparse_vectors_ ? "true" : "false");
+    saveValue("vector_chroma_batch_bytes", std::to_string(vector_chroma_batch_bytes_));
+    saveValue("vector_chroma_concurrency", std::to_string(vector_chroma_concurrency_));
 
     // Embedding settings
     saveValue("embedding_provider", embedding_provider_);
     saveValue("embedding_model", embedding_model_);
+    saveValue("embedding_batch_size", std::to_string(embedding_batch_size_));
+    saveValue("embedding_concurrency", std::to_string(embedding_concurrency_));
+    saveValue("embedding_cache_enabled", embedding_cache_enabled_ ? "true" : "false");
+    saveValue("embedding_cache_max_mb", std::to_string(embedding_cache_max_mb_));
+    saveValue("embedding_local_dimensions", std::to_string(embedding_local_dimensions_));
 
     // RAG settings
     saveValue("rag_enabled", rag_enabled_ ? "true" : "false");
     saveValue("rag_auto_context", rag_auto_context_ ? "true" : "false");
     saveValue("rag_similarity_threshold", std::to_string(rag_similarity_threshold_));
     saveValue("rag_max_chunks", std::to_string(rag_max_chunks_));
+    saveValue("rag_ingest_readers", std::to_string(rag_ingest_readers_));
+    saveValue("rag_ingest_chunkers", std::to_string(rag_ingest_chunkers_));
+    saveValue("rag_ingest_embedders", std::to_string(rag_ingest_embedders_));
+    saveValue("rag_ingest_queue_depth", std::to_string(rag_ingest_queue_depth_));
+    saveValue("rag_hybrid_search", rag_hybrid_search_ ? "true" : "false");
+    saveValue("rag_vector_weight", std::to_string(rag_vector_weight_));
+    saveValue("rag_lexical_weight", std::to_string(rag_lexical_weight_));
+    saveValue("rag_fusion_k", std::to_string(rag_fusion_k_));
+    saveValue("rag_query_cache_size", std::to_string(rag_query_cache_size_));
+    saveValue("rag_watch_directories", rag_watch_directories_ ? "true" : "false");
+    saveValue("rag_watch_debounce_ms", std::to_string(rag_watch_debounce_ms_));
+    saveValue("rag_max_file_mb", std::to_string(rag_max_file_mb_));
+    saveValue("rag_skip_binary", rag_skip_binary_ ? "true" : "false");
+    saveValue("rag_skip_extensions", rag_skip_extensions_);
+    saveValue("rag_stream_window_mb", std::to_string(rag_stream_window_mb_));
+    saveValue("rag_max_context_tokens", std::to_string(rag_max_context_tokens_));
+    saveValue("rag_mmr_lambda", std::to_string(rag_mmr_lambda_));
+    saveValue("rag_duplicate_threshold", std::to_string(rag_duplicate_threshold_));
 
     // License settings
     saveValue("license_server_url", license_server_url_);
@@ -399,6 +501,61 @@ void Config::setVectorUrl(const std::string& url) {
     save();
 }
 
+void Config::setVectorHNSWEnabled(bool value) {
+    vector_hnsw_enabled_ = value;
+    save();
+}
+
+void Config::setVectorHNSWM(int value) {
+    vector_hnsw_m_ = value;
+    save();
+}
+
+void Config::setVectorHNSWEfSearch(int value) {
+    vector_hnsw_ef_search_ = value;
+    save();
+}
+
+void Config::setVectorQuantization(const std::string& value) {
+    vector_quantization_ = value;
+    save();
+}
+
+void Config::setVectorSearchThreads(int value) {
+    vector_search_threads_ = value;
+    save();
+}
+
+void Config::setVectorSQLiteSynchronous(const std::string& value) {
+    vector_sqlite_synchronous_ = value;
+    save();
+}
+
+void Config::setVectorSQLiteCacheKb(int value) {
+    vector_sqlite_cache_kb_ = value;
+    save();
+}
+
+void Config::setVectorSQLiteMmapBytes(int64_t value) {
+    vector_sqlite_mmap_bytes_ = value;
+    save();
+}
+
+void Config::setVectorSparseVectors(bool value) {
+    vector_sparse_vectors_ = value;
+    save();
+}
+
+void Config::setVectorChromaBatchBytes(int64_t value) {
+    vector_chroma_batch_bytes_ = value;
+    save();
+}
+
+void Config::setVectorChromaConcurrency(int value) {
+    vector_chroma_concurrency_ = value;
+    save();
+}
+
 // Embedding setters
 void Config::setEmbeddingProvider(const std::string& provider) {
     embedding_provider_ = provider;
@@ -410,6 +567,31 @@ void Config::setEmbeddingModel(const std::string& model) {
     save();
 }
 
+void Config::setEmbeddingBatchSize(int value) {
+    embedding_batch_size_ = value;
+    save();
+}
+
+void Config::setEmbeddingConcurrency(int value) {
+    embedding_concurrency_ = value;
+    save();
+}
+
+void Config::setEmbeddingCacheEnabled(bool value) {
+    embedding_cache_enabled_ = value;
+    save();
+}
+
+void Config::setEmbeddingCacheMaxMB(int value) {
+    embedding_cache_max_mb_ = value;
+    save();
+}
+
+void Config::setEmbeddingLocalDimensions(int value) {
+    embedding_local_dimensions_ = value;
+    save();
+}
+
 // RAG setters
 void Config::setRAGEnabled(bool enabled) {
     rag_enabled_ = enabled;
@@ -431,6 +613,96 @@ void Config::setRAGMaxChunks(int chunks) {
     save();
 }
 
+void Config::setRAGIngestReaders(int value) {
+    rag_ingest_readers_ = value;
+    save();
+}
+
+void Config::setRAGIngestChunkers(int value) {
+    rag_ingest_chunkers_ = value;
+    save();
+}
+
+void Config::setRAGIngestEmbedders(int value) {
+    rag_ingest_embedders_ = value;
+    save();
+}
+
+void Config::setRAGIngestQueueDepth(int value) {
+    rag_ingest_queue_depth_ = value;
+    save();
+}
+
+void Config::setRAGHybridSearch(bool value) {
+    rag_hybrid_search_ = value;
+    save();
+}
+
+void Config::setRAGVectorWeight(double value) {
+    rag_vector_weight_ = value;
+    save();
+}
+
+void Config::setRAGLexicalWeight(double value) {
+    rag_lexical_weight_ = value;
+    save();
+}
+
+void Config::setRAGFusionK(int value) {
+    rag_fusion_k_ = value;
+    save();
+}
+
+void Config::setRAGQueryCacheSize(int value) {
+    rag_query_cache_size_ = value;
+    save();
+}
+
+void Config::setRAGWatchDirectories(bool value) {
+    rag_watch_directories_ = value;
+    save();
+}
+
+void Config::setRAGWatchDebounceMs(int value) {
+    rag_watch_debounce_ms_ = value;
+    save();
+}
+
+void Config::setRAGMaxFileMb(int value) {
+    rag_max_file_mb_ = value;
+    save();
+}
+
+void Config::setRAGSkipBinary(bool value) {
+    rag_skip_binary_ = value;
+    save();
+}
+
+void Config::setRAGSkipExtensions(const std::string& value) {
+    rag_skip_extensions_ = value;
+    save();
+}
+
+void Config::setRAGStreamWindowMb(int value) {
+    rag_stream_window_mb_ = value;
+    save();
+}
+
+void Config::setRAGMaxContextTokens(int value) {
+    rag_max_context_tokens_ = value;
+    save();
+}
+
+void Config::setRAGMMRLambda(double value) {
+    rag_mmr_lambda_ = value;
+    save();
+}
+
+void Config::setRAGDuplicateThreshold(double value) {
+    rag_duplicate_threshold_ = value;
+    save();
+}
+
 // License setters
 void Config::setLicenseServerUrl(const std::string& url) {
     license_server_url_ = url;
@@ -573,4 +845,8 @@ std::string Config::getDefaultVectorPath() {
     return utils::joinPath(getConfigDir(), "vectors");
 }
 
+std::string Config::getDefaultEmbeddingCachePath() {
+    return utils::joinPath(getConfigDir(), "embedding_cache.db");
+}
+
 } // namespace casper
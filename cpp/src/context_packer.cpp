@@ -0,0 +1,231 @@
+#include "context_packer.h"
+#include "json.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+using json = nlohmann::json;
+
+namespace casper {
+
+namespace {
+
+// Header line and separators formatContext puts around a passage
+const size_t kHeaderChars = 32;
+
+// Shorter matches between the end of one chunk and the start of the next
+// are taken as coincidence, not overlap
+const size_t kMinOverlap = 8;
+
+// A passage cut to fit the budget keeps at least this much text
+const size_t kMinCutChars = 64;
+
+struct Passage {
+    VectorSearchResult result;
+    double value;                    // Sum of the scores of its chunks
+    int tokens;
+    std::vector<uint64_t> shingles;  // Sorted word bigram hashes
+};
+
+int chunkIndex(const std::string& metadata) {
+    json meta = json::parse(metadata, nullptr, false);
+    if (!meta.is_object()) return -1;
+    auto it = meta.find("chunk_index");
+    if (it == meta.end() || !it->is_number_integer()) return -1;
+    return it->get<int>();
+}
+
+// Appends b to a, keeping the text a ends with and b starts with once
+void appendOverlapping(std::string& a, const std::string& b) {
+    for (size_t k = std::min(a.size(), b.size()); k >= kMinOverlap; k--) {
+        if (a.compare(a.size() - k, k, b, 0, k) == 0) {
+            a.append(b, k, std::string::npos);
+            return;
+        }
+    }
+    a += "\n";
+    a += b;
+}
+
+inline bool isWordChar(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80;
+}
+
+// Hashes of consecutive word pairs, case-insensitive; single words for
+// text of one word
+std::vector<uint64_t> shingles(std::string_view text) {
+    std::vector<uint64_t> words;
+    uint64_t hash = 0;
+    bool in_word = false;
+    for (unsigned char c : text) {
+        if (isWordChar(c)) {
+            if (!in_word) hash = 14695981039346656037ull;
+            hash = (hash ^ static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c + 32 : c)) * 1099511628211ull;
+            in_word = true;
+        } else if (in_word) {
+            words.push_back(hash);
+            in_word = false;
+        }
+    }
+    if (in_word) words.push_back(hash);
+
+    std::vector<uint64_t> result;
+    if (words.size() == 1) result.push_back(words[0]);
+    for (size_t i = 1; i < words.size(); i++) {
+        result.push_back((words[i - 1] * 0x9E3779B97F4A7C15ull) ^ words[i]);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+// Share of the smaller set found in the other, so a passage repeated inside
+// a longer one counts as a duplicate
+double containment(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+    if (a.empty() || b.empty()) return 0.0;
+    size_t common = 0;
+    for (size_t i = 0, j = 0; i < a.size() && j < b.size();) {
+        if (a[i] < b[j]) {
+            i++;
+        } else if (b[j] < a[i]) {
+            j++;
+        } else {
+            common++;
+            i++;
+            j++;
+        }
+    }
+    return static_cast<double>(common) / static_cast<double>(std::min(a.size(), b.size()));
+}
+
+// Chunks of one source with consecutive chunk_index values become one
+// passage; chunks without an index stay on their own
+std::vector<Passage> mergeAdjacent(const std::vector<VectorSearchResult>& results) {
+    std::vector<std::pair<int, size_t>> indexed;  // (chunk_index, position)
+    std::vector<Passage> passages;
+    for (size_t i = 0; i < results.size(); i++) {
+        int index = chunkIndex(results[i].document.metadata);
+        if (index < 0) {
+            passages.push_back({results[i], results[i].score, 0, {}});
+        } else {
+            indexed.emplace_back(index, i);
+        }
+    }
+    std::stable_sort(indexed.begin(), indexed.end(), [&](const auto& a, const auto& b) {
+        const auto& sa = results[a.second].document.source;
+        const auto& sb = results[b.second].document.source;
+        return sa != sb ? sa < sb : a.first < b.first;
+    });
+
+    for (size_t i = 0; i < indexed.size();) {
+        const auto& first = results[indexed[i].second];
+        Passage passage{first, first.score, 0, {}};
+        int last = indexed[i].first;
+
+        size_t j = i + 1;
+        for (; j < indexed.size(); j++) {
+            const auto& next = results[indexed[j].second];
+            if (next.document.source != first.document.source || indexed[j].first > last + 1) break;
+            passage.value += next.score;
+            passage.result.score = std::max(passage.result.score, next.score);
+            passage.result.distance = std::min(passage.result.distance, next.distance);
+            if (indexed[j].first == last) continue;  // The same chunk twice
+            appendOverlapping(passage.result.document.content, next.document.content);
+            last = indexed[j].first;
+        }
+
+        if (last != indexed[i].first) {
+            json meta = json::parse(first.document.metadata, nullptr, false);
+            meta["last_chunk_index"] = last;
+            passage.result.document.metadata = meta.dump();
+        }
+        passages.push_back(std::move(passage));
+        i = j;
+    }
+    return passages;
+}
+
+} // namespace
+
+ContextPacker::ContextPacker(int token_budget, double mmr_lambda, double duplicate_threshold)
+    : token_budget_(token_budget)
+    , mmr_lambda_(std::min(std::max(mmr_lambda, 0.0), 1.0))
+    , duplicate_threshold_(duplicate_threshold) {
+}
+
+int ContextPacker::passageTokens(std::string_view source, std::string_view content) {
+    return static_cast<int>((source.size() + content.size() + kHeaderChars) / 4);
+}
+
+std::vector<VectorSearchResult> ContextPacker::pack(const std::vector<VectorSearchResult>& results) const {
+    std::vector<Passage> passages = mergeAdjacent(results);
+    for (auto& passage : passages) {
+        passage.tokens = std::max(passageTokens(passage.result.document.source, passage.result.document.content), 1);
+        passage.shingles = shingles(passage.result.document.content);
+    }
+
+    // Greedy selection by discounted value per token; similarity to the
+    // picked passages only grows, so it is updated as each one is picked
+    int remaining = token_budget_ > 0 ? token_budget_ : INT_MAX;
+    std::vector<double> similarity(passages.size(), 0.0);
+    std::vector<bool> done(passages.size(), false);
+    std::vector<size_t> picked;
+    for (;;) {
+        size_t best = passages.size();
+        double best_density = 0.0;
+        for (size_t i = 0; i < passages.size(); i++) {
+            if (done[i]) continue;
+            if (similarity[i] >= duplicate_threshold_) {
+                done[i] = true;
+                continue;
+            }
+            if (passages[i].tokens > remaining) continue;
+            double gain = passages[i].value * (1.0 - (1.0 - mmr_lambda_) * similarity[i]);
+            double density = gain / passages[i].tokens;
+            if (best == passages.size() || density > best_density ||
+                (density == best_density && passages[i].result.score > passages[best].result.score)) {
+                best = i;
+                best_density = density;
+            }
+        }
+        if (best == passages.size()) break;
+
+        done[best] = true;
+        picked.push_back(best);
+        remaining -= passages[best].tokens;
+        for (size_t i = 0; i < passages.size(); i++) {
+            if (!done[i]) {
+                similarity[i] = std::max(similarity[i], containment(passages[i].shingles, passages[best].shingles));
+            }
+        }
+    }
+
+    // Nothing fits whole: cut the best passage down to the budget
+    if (picked.empty() && !passages.empty()) {
+        size_t best = 0;
+        for (size_t i = 1; i < passages.size(); i++) {
+            if (passages[i].result.score > passages[best].result.score) best = i;
+        }
+        auto& document = passages[best].result.document;
+        size_t budget_chars = static_cast<size_t>(remaining) * 4;
+        size_t used = document.source.size() + kHeaderChars + 4;  // 4 for the " ..." marker
+        if (budget_chars >= used + kMinCutChars) {
+            size_t cut = budget_chars - used;
+            size_t space = document.content.find_last_of(" \t\n", cut);
+            if (space != std::string::npos && space >= cut / 2) cut = space;
+            document.content.resize(cut);
+            document.content += " ...";
+            picked.push_back(best);
+        }
+    }
+
+    std::stable_sort(picked.begin(), picked.end(), [&](size_t a, size_t b) {
+        return passages[a].result.score > passages[b].result.score;
+    });
+    std::vector<VectorSearchResult> packed;
+    packed.reserve(picked.size());
+    for (size_t i : picked) packed.push_back(std::move(passages[i].result));
+    return packed;
+}
+
+} // namespace casper
@@ -0,0 +1,267 @@
+#include "directory_watcher.h"
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace casper {
+
+DirectoryWatcher::DirectoryWatcher(Callback callback, int debounce_ms)
+    : callback_(std::move(callback))
+    , debounce_ms_(std::max(debounce_ms, 0))
+#ifdef __linux__
+    , inotify_fd_(-1)
+    , wake_fd_{-1, -1}
+#endif
+{
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    stop();
+}
+
+std::vector<std::string> DirectoryWatcher::roots() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::vector<std::string>(roots_.begin(), roots_.end());
+}
+
+#ifdef __linux__
+
+namespace {
+
+const uint32_t kWatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                            IN_DELETE_SELF | IN_ONLYDIR;
+
+bool isDirectory(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool isUnder(const std::string& path, const std::string& dir) {
+    return path == dir || (path.size() > dir.size() && path.compare(0, dir.size(), dir) == 0 &&
+                           (dir.back() == '/' || path[dir.size()] == '/'));
+}
+
+} // namespace
+
+bool DirectoryWatcher::isSupported() {
+    return true;
+}
+
+bool DirectoryWatcher::start() {
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) return false;
+    if (pipe2(wake_fd_, O_NONBLOCK | O_CLOEXEC) != 0) {
+        ::close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread(&DirectoryWatcher::run, this);
+    return true;
+}
+
+bool DirectoryWatcher::watch(const std::string& root) {
+    std::string dir = root;
+    while (dir.size() > 1 && dir.back() == '/') dir.pop_back();
+    if (!isDirectory(dir)) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_ && !start()) return false;
+    roots_.insert(dir);
+    addTree(dir);
+    return wds_.count(dir) > 0;
+}
+
+void DirectoryWatcher::unwatch(const std::string& root) {
+    std::string dir = root;
+    while (dir.size() > 1 && dir.back() == '/') dir.pop_back();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!roots_.erase(dir)) return;
+
+    // Still covered by a root above it: the watches stay
+    for (const auto& other : roots_) {
+        if (isUnder(dir, other)) return;
+    }
+    removeTree(dir);
+    // Roots nested inside it keep theirs
+    for (const auto& other : roots_) {
+        if (isUnder(other, dir)) addTree(other);
+    }
+}
+
+void DirectoryWatcher::stop() {
+    if (!running_.exchange(false)) return;
+
+    char wake = 0;
+    if (write(wake_fd_[1], &wake, 1) < 0) {
+        // The pipe is non-blocking and only ever holds this byte
+    }
+    if (thread_.joinable()) thread_.join();
+
+    ::close(inotify_fd_);
+    ::close(wake_fd_[0]);
+    ::close(wake_fd_[1]);
+    inotify_fd_ = -1;
+    wake_fd_[0] = wake_fd_[1] = -1;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    dirs_.clear();
+    wds_.clear();
+    roots_.clear();
+}
+
+void DirectoryWatcher::addTree(const std::string& dir) {
+    if (wds_.count(dir)) return;
+
+    int wd = inotify_add_watch(inotify_fd_, dir.c_str(), kWatchMask);
+    if (wd < 0) return;
+    // The same directory reached through a symlink shares the descriptor
+    if (dirs_.count(wd)) return;
+    dirs_[wd] = dir;
+    wds_[dir] = wd;
+
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) return;
+    struct dirent* entry;
+    while ((entry = readdir(handle)) != nullptr) {
+        if (entry->d_name[0] == '.') continue;
+        std::string path = dir + "/" + entry->d_name;
+        if (isDirectory(path)) addTree(path);
+    }
+    closedir(handle);
+}
+
+void DirectoryWatcher::removeTree(const std::string& dir) {
+    for (auto it = wds_.lower_bound(dir); it != wds_.end() && it->first.compare(0, dir.size(), dir) == 0;) {
+        if (!isUnder(it->first, dir)) {
+            ++it;
+            continue;
+        }
+        inotify_rm_watch(inotify_fd_, it->second);
+        dirs_.erase(it->second);
+        it = wds_.erase(it);
+    }
+}
+
+void DirectoryWatcher::handleEvents(const char* buffer, size_t length, std::set<std::string>& pending) {
+    for (size_t offset = 0; offset + sizeof(struct inotify_event) <= length;) {
+        const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+        offset += sizeof(struct inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW) {
+            // Events were lost: everything has to be looked at again
+            pending.insert(roots_.begin(), roots_.end());
+            continue;
+        }
+
+        auto it = dirs_.find(event->wd);
+        if (it == dirs_.end()) continue;
+        if (event->mask & IN_IGNORED) {
+            wds_.erase(it->second);
+            dirs_.erase(it);
+            continue;
+        }
+        if (event->len == 0 || event->name[0] == '.' || event->name[0] == '\0') continue;
+
+        std::string path = it->second + "/" + event->name;
+        if (event->mask & IN_ISDIR) {
+            // Reported as a whole; files that landed in a new directory
+            // before its watch was added are found when it is rescanned
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                addTree(path);
+                pending.insert(path);
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                removeTree(path);
+                pending.insert(path);
+            }
+        } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM)) {
+            pending.insert(path);
+        }
+    }
+}
+
+void DirectoryWatcher::run() {
+    // Re-indexing is background work: yield the CPU to the foreground
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+
+    using Clock = std::chrono::steady_clock;
+    const auto debounce = std::chrono::milliseconds(debounce_ms_);
+    // A tree that never settles (a running build) is still reported this often
+    const auto max_delay = debounce * 10;
+
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    std::set<std::string> pending;
+    Clock::time_point first;
+    Clock::time_point last;
+
+    while (running_) {
+        int timeout = -1;
+        if (!pending.empty()) {
+            auto now = Clock::now();
+            auto due = std::min(last + debounce, first + max_delay);
+            timeout = static_cast<int>(std::max<int64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count(), 0));
+        }
+
+        struct pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_[0], POLLIN, 0}};
+        int ready = poll(fds, 2, timeout);
+        if (!running_) break;
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            bool was_empty = pending.empty();
+            ssize_t length;
+            while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                handleEvents(buffer, static_cast<size_t>(length), pending);
+            }
+            last = Clock::now();
+            if (was_empty) first = last;
+        }
+
+        auto now = Clock::now();
+        if (!pending.empty() && (now >= last + debounce || now >= first + max_delay)) {
+            std::vector<std::string> batch(pending.begin(), pending.end());
+            pending.clear();
+            callback_(batch);
+        }
+    }
+}
+
+#else
+
+bool DirectoryWatcher::isSupported() {
+    return false;
+}
+
+bool DirectoryWatcher::watch(const std::string& root) {
+    (void)root;
+    return false;
+}
+
+void DirectoryWatcher::unwatch(const std::string& root) {
+    (void)root;
+}
+
+void DirectoryWatcher::stop() {
+}
+
+#endif
+
+} // namespace casper
@@ -0,0 +1,329 @@
+#include "embedding_cache.h"
+#include "utils.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+namespace casper {
+
+// How long a write waits for another connection (or process) holding the
+// database before giving up
+static const int kBusyTimeoutMs = 5000;
+
+EmbeddingCache::EmbeddingCache()
+    : db_(nullptr)
+    , max_entries_(0)
+    , max_bytes_(0) {
+}
+
+EmbeddingCache::~EmbeddingCache() {
+    close();
+}
+
+std::shared_ptr<EmbeddingCache> EmbeddingCache::shared(const std::string& path) {
+    static std::mutex registry_mutex;
+    static std::map<std::string, std::weak_ptr<EmbeddingCache>> registry;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto it = registry.find(path);
+    if (it != registry.end()) {
+        if (auto cache = it->second.lock()) return cache;
+    }
+
+    auto cache = std::make_shared<EmbeddingCache>();
+    if (!cache->open(path)) return nullptr;
+    registry[path] = cache;
+    return cache;
+}
+
+bool EmbeddingCache::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (db_) {
+        sqlite3_close(static_cast<sqlite3*>(db_));
+        db_ = nullptr;
+    }
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        std::cerr << "Embedding cache error: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return false;
+    }
+
+    sqlite3_busy_timeout(db, kBusyTimeoutMs);
+
+    // Totals are kept by triggers so every process sharing the file sees
+    // the same ones; they are filled in once for caches created without them
+    const char* schema = R"(
+        PRAGMA journal_mode = WAL;
+        PRAGMA synchronous = NORMAL;
+        BEGIN IMMEDIATE;
+        CREATE TABLE IF NOT EXISTS embedding_cache (
+            provider TEXT NOT NULL,
+            model TEXT NOT NULL,
+            hash BLOB NOT NULL,
+            embedding BLOB NOT NULL,
+            last_used INTEGER NOT NULL,
+            PRIMARY KEY (provider, model, hash)
+        );
+        CREATE INDEX IF NOT EXISTS idx_embedding_cache_lru ON embedding_cache(last_used);
+        CREATE TABLE IF NOT EXISTS embedding_cache_totals (
+            id INTEGER PRIMARY KEY CHECK (id = 0),
+            entries INTEGER NOT NULL,
+            bytes INTEGER NOT NULL
+        );
+        INSERT OR IGNORE INTO embedding_cache_totals
+            SELECT 0, COUNT(*), COALESCE(SUM(LENGTH(embedding)), 0) FROM embedding_cache;
+        CREATE TRIGGER IF NOT EXISTS embedding_cache_insert AFTER INSERT ON embedding_cache BEGIN
+            UPDATE embedding_cache_totals SET entries = entries + 1, bytes = bytes + LENGTH(NEW.embedding);
+        END;
+        CREATE TRIGGER IF NOT EXISTS embedding_cache_delete AFTER DELETE ON embedding_cache BEGIN
+            UPDATE embedding_cache_totals SET entries = entries - 1, bytes = bytes - LENGTH(OLD.embedding);
+        END;
+        COMMIT;
+    )";
+
+    char* err_msg = nullptr;
+    sqlite3_exec(db, schema, nullptr, nullptr, &err_msg);
+    if (err_msg) {
+        std::cerr << "Embedding cache init error: " << err_msg << std::endl;
+        sqlite3_free(err_msg);
+        sqlite3_close(db);
+        return false;
+    }
+
+    stats_ = EmbeddingCacheStats();
+    db_ = db;
+    return true;
+}
+
+bool EmbeddingCache::begin() {
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    if (sqlite3_exec(db, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Embedding cache error: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool EmbeddingCache::readTotals(int64_t& entries, int64_t& bytes) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), "SELECT entries, bytes FROM embedding_cache_totals",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
+        entries = sqlite3_column_int64(stmt, 0);
+        bytes = sqlite3_column_int64(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+int64_t EmbeddingCache::lastStamp() {
+    int64_t stamp = 0;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), "SELECT COALESCE(MAX(last_used), 0) FROM embedding_cache",
+                           -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) stamp = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return stamp;
+}
+
+void EmbeddingCache::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (db_) {
+        sqlite3_close(static_cast<sqlite3*>(db_));
+        db_ = nullptr;
+    }
+}
+
+void EmbeddingCache::setLimits(int64_t max_entries, int64_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_entries_ = max_entries;
+    max_bytes_ = max_bytes;
+    if (db_ && begin()) {
+        evict();
+        sqlite3_exec(static_cast<sqlite3*>(db_), "COMMIT", nullptr, nullptr, nullptr);
+    }
+}
+
+std::string EmbeddingCache::normalizeText(const std::string& text) {
+    std::string normalized;
+    normalized.reserve(text.size());
+
+    bool space = false;
+    for (unsigned char c : text) {
+        if (std::isspace(c)) {
+            space = !normalized.empty();
+            continue;
+        }
+        if (space) {
+            normalized += ' ';
+            space = false;
+        }
+        normalized += static_cast<char>(c);
+    }
+    return normalized;
+}
+
+size_t EmbeddingCache::lookup(const std::string& provider, const std::string& model,
+                              const std::vector<std::string>& texts,
+                              std::vector<Embedding>& embeddings, std::vector<bool>& found) {
+    embeddings.resize(texts.size());
+    found.assign(texts.size(), false);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!db_) return 0;
+    sqlite3* db = static_cast<sqlite3*>(db_);
+
+    sqlite3_stmt* select_stmt;
+    const char* select_sql = "SELECT rowid, embedding FROM embedding_cache WHERE provider = ? AND model = ? AND hash = ?";
+    if (sqlite3_prepare_v2(db, select_sql, -1, &select_stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
+
+    // Reads need no write lock; hits are touched afterwards in one transaction
+    std::vector<int64_t> rowids;
+    unsigned char hash[16];
+    for (size_t i = 0; i < texts.size(); i++) {
+        const std::string normalized = normalizeText(texts[i]);
+        utils::hash128(normalized.data(), normalized.size(), hash);
+
+        sqlite3_bind_text(select_stmt, 1, provider.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(select_stmt, 2, model.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_blob(select_stmt, 3, hash, sizeof(hash), SQLITE_TRANSIENT);
+
+        if (sqlite3_step(select_stmt) == SQLITE_ROW) {
+            rowids.push_back(sqlite3_column_int64(select_stmt, 0));
+            const void* blob = sqlite3_column_blob(select_stmt, 1);
+            size_t bytes = static_cast<size_t>(sqlite3_column_bytes(select_stmt, 1));
+
+            embeddings[i].resize(bytes / sizeof(float));
+            if (bytes > 0) std::memcpy(embeddings[i].data(), blob, embeddings[i].size() * sizeof(float));
+            found[i] = true;
+        }
+        sqlite3_reset(select_stmt);
+    }
+    sqlite3_finalize(select_stmt);
+
+    size_t hits = rowids.size();
+    stats_.hits += static_cast<int64_t>(hits);
+    stats_.misses += static_cast<int64_t>(texts.size() - hits);
+
+    sqlite3_stmt* touch_stmt;
+    if (hits == 0 || !begin()) return hits;
+    if (sqlite3_prepare_v2(db, "UPDATE embedding_cache SET last_used = ? WHERE rowid = ?", -1, &touch_stmt, nullptr) == SQLITE_OK) {
+        int64_t stamp = lastStamp();
+        for (int64_t rowid : rowids) {
+            sqlite3_bind_int64(touch_stmt, 1, ++stamp);
+            sqlite3_bind_int64(touch_stmt, 2, rowid);
+            sqlite3_step(touch_stmt);
+            sqlite3_reset(touch_stmt);
+        }
+        sqlite3_finalize(touch_stmt);
+    }
+    sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+    return hits;
+}
+
+void EmbeddingCache::store(const std::string& provider, const std::string& model,
+                           const std::vector<std::string>& texts, const std::vector<Embedding>& embeddings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!db_) return;
+    sqlite3* db = static_cast<sqlite3*>(db_);
+
+    sqlite3_stmt* stmt;
+    const char* sql = "INSERT OR IGNORE INTO embedding_cache (provider, model, hash, embedding, last_used) VALUES (?, ?, ?, ?, ?)";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+    if (!begin()) {
+        sqlite3_finalize(stmt);
+        return;
+    }
+
+    int64_t stamp = lastStamp();
+    unsigned char hash[16];
+    size_t count = std::min(texts.size(), embeddings.size());
+    for (size_t i = 0; i < count; i++) {
+        if (embeddings[i].empty()) continue;
+        const std::string normalized = normalizeText(texts[i]);
+        utils::hash128(normalized.data(), normalized.size(), hash);
+        int bytes = static_cast<int>(embeddings[i].size() * sizeof(float));
+
+        sqlite3_bind_text(stmt, 1, provider.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, model.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_blob(stmt, 3, hash, sizeof(hash), SQLITE_TRANSIENT);
+        sqlite3_bind_blob(stmt, 4, embeddings[i].data(), bytes, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 5, ++stamp);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+
+    sqlite3_finalize(stmt);
+    evict();
+    if (sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Embedding cache error: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+    }
+}
+
+void EmbeddingCache::evict() {
+    int64_t entries = 0;
+    int64_t bytes = 0;
+    if (!readTotals(entries, bytes)) return;
+
+    bool over = (max_entries_ > 0 && entries > max_entries_) ||
+                (max_bytes_ > 0 && bytes > max_bytes_);
+    if (!over) return;
+
+    // Trim to 90% of the limits so eviction does not run on every store
+    int64_t target_entries = max_entries_ > 0 ? max_entries_ * 9 / 10 : entries;
+    int64_t target_bytes = max_bytes_ > 0 ? max_bytes_ * 9 / 10 : bytes;
+
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT last_used, LENGTH(embedding) FROM embedding_cache ORDER BY last_used", -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+
+    // Walk the oldest entries until enough would be gone, then drop them in one statement
+    int64_t cutoff = -1;
+    while ((entries > target_entries || bytes > target_bytes) && sqlite3_step(stmt) == SQLITE_ROW) {
+        cutoff = sqlite3_column_int64(stmt, 0);
+        entries--;
+        bytes -= sqlite3_column_int64(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+
+    if (cutoff < 0) return;
+
+    if (sqlite3_prepare_v2(db, "DELETE FROM embedding_cache WHERE last_used <= ?", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, cutoff);
+        if (sqlite3_step(stmt) == SQLITE_DONE) {
+            stats_.evictions += sqlite3_changes(db);
+        }
+        sqlite3_finalize(stmt);
+    }
+}
+
+void EmbeddingCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!db_ || !begin()) return;
+    sqlite3_exec(static_cast<sqlite3*>(db_), "DELETE FROM embedding_cache; COMMIT", nullptr, nullptr, nullptr);
+}
+
+EmbeddingCacheStats EmbeddingCache::getStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EmbeddingCacheStats stats = stats_;
+    if (db_) readTotals(stats.entries, stats.bytes);
+    return stats;
+}
+
+} // namespace casper
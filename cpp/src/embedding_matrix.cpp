@@ -0,0 +1,143 @@
+#include "embedding_matrix.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace casper {
+
+namespace {
+
+uint8_t* allocateAligned(size_t bytes) {
+    if (bytes == 0) return nullptr;
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, EmbeddingMatrix::kAlignment, bytes) != 0) {
+        throw std::bad_alloc();
+    }
+    return static_cast<uint8_t*>(ptr);
+}
+
+} // namespace
+
+EmbeddingMatrix::EmbeddingMatrix()
+    : dimensions_(0)
+    , codes_(false)
+    , row_bytes_(0)
+    , stride_bytes_(0)
+    , capacity_(0)
+    , data_(nullptr) {
+}
+
+EmbeddingMatrix::~EmbeddingMatrix() {
+    std::free(data_);
+}
+
+void EmbeddingMatrix::clear() {
+    std::free(data_);
+    data_ = nullptr;
+    capacity_ = 0;
+    ids_.clear();
+    rows_.clear();
+}
+
+void EmbeddingMatrix::setRowBytes(size_t bytes) {
+    row_bytes_ = bytes;
+    stride_bytes_ = (bytes + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+void EmbeddingMatrix::reset(int dimensions) {
+    clear();
+    dimensions_ = dimensions;
+    codes_ = false;
+    setRowBytes(static_cast<size_t>(dimensions) * sizeof(float));
+}
+
+void EmbeddingMatrix::resetCodes(int dimensions, size_t code_bytes) {
+    clear();
+    dimensions_ = dimensions;
+    codes_ = true;
+    setRowBytes(code_bytes);
+}
+
+void EmbeddingMatrix::reserve(size_t rows) {
+    if (rows > capacity_ && stride_bytes_ > 0) {
+        grow(rows);
+    }
+}
+
+void EmbeddingMatrix::grow(size_t min_rows) {
+    size_t new_capacity = capacity_ == 0 ? 1024 : capacity_ * 2;
+    if (new_capacity < min_rows) new_capacity = min_rows;
+
+    uint8_t* block = allocateAligned(new_capacity * stride_bytes_);
+    if (data_) {
+        std::memcpy(block, data_, ids_.size() * stride_bytes_);
+        std::free(data_);
+    }
+    data_ = block;
+    capacity_ = new_capacity;
+}
+
+int64_t EmbeddingMatrix::rowOf(const std::string& id) const {
+    auto it = rows_.find(id);
+    return it == rows_.end() ? -1 : static_cast<int64_t>(it->second);
+}
+
+bool EmbeddingMatrix::upsert(const std::string& id, const Embedding& embedding) {
+    return upsert(id, embedding.data(), embedding.size());
+}
+
+bool EmbeddingMatrix::upsert(const std::string& id, const float* data, size_t count) {
+    if (codes_ || count == 0) return false;
+    if (dimensions_ == 0) reset(static_cast<int>(count));
+    if (count != static_cast<size_t>(dimensions_)) {
+        remove(id);
+        return false;
+    }
+    return store(id, data, count * sizeof(float));
+}
+
+bool EmbeddingMatrix::upsertCode(const std::string& id, const uint8_t* code, size_t bytes) {
+    if (!codes_) return false;
+    if (bytes != row_bytes_) {
+        remove(id);
+        return false;
+    }
+    return store(id, code, bytes);
+}
+
+bool EmbeddingMatrix::store(const std::string& id, const void* data, size_t bytes) {
+    size_t row;
+    auto it = rows_.find(id);
+    if (it != rows_.end()) {
+        row = it->second;
+    } else {
+        if (ids_.size() == capacity_) grow(ids_.size() + 1);
+        row = ids_.size();
+        ids_.push_back(id);
+        rows_[id] = row;
+    }
+
+    uint8_t* dst = data_ + row * stride_bytes_;
+    std::memcpy(dst, data, bytes);
+    std::memset(dst + bytes, 0, stride_bytes_ - bytes);
+    return true;
+}
+
+bool EmbeddingMatrix::remove(const std::string& id) {
+    auto it = rows_.find(id);
+    if (it == rows_.end()) return false;
+
+    size_t row = it->second;
+    size_t last = ids_.size() - 1;
+    rows_.erase(it);
+
+    if (row != last) {
+        std::memcpy(data_ + row * stride_bytes_, data_ + last * stride_bytes_, stride_bytes_);
+        ids_[row] = std::move(ids_[last]);
+        rows_[ids_[row]] = row;
+    }
+    ids_.pop_back();
+    return true;
+}
+
+} // namespace casper
@@ -1,10 +1,12 @@
 #include "embeddings.h"
+#include "embedding_cache.h"
+#include "simd_kernels.h"
+#include "worker_pool.h"
 #include "json.hpp"
 #include <curl/curl.h>
 #include <cmath>
 #include <algorithm>
 #include <sstream>
-#include <cctype>
 #include <iostream>
 
 using json = nlohmann::json;
@@ -25,18 +27,54 @@ static size_t writeCallback(void* contents, size_t size, size_t nmemb, std::stri
 OllamaEmbeddingProvider::OllamaEmbeddingProvider(const std::string& host, const std::string& model)
     : host_(host)
     , model_(model)
-    , dimensions_(0) {
+    , dimensions_(0)
+    , batch_size_(32)
+    , concurrency_(4)
+    , legacy_api_(false)
+    , multi_(nullptr) {
+}
+
+OllamaEmbeddingProvider::~OllamaEmbeddingProvider() {
+    for (void* curl : handles_) {
+        if (curl) curl_easy_cleanup(static_cast<CURL*>(curl));
+    }
+    if (multi_) {
+        curl_multi_cleanup(static_cast<CURLM*>(multi_));
+    }
 }
 
 void OllamaEmbeddingProvider::setHost(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex_);
     host_ = host;
+    legacy_api_ = false;
 }
 
 void OllamaEmbeddingProvider::setModel(const std::string& model) {
+    std::lock_guard<std::mutex> lock(mutex_);
     model_ = model;
     dimensions_ = 0;  // Reset to detect on next embed
 }
 
+void OllamaEmbeddingProvider::setBatchSize(int batch_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch_size_ = std::max(1, batch_size);
+}
+
+void OllamaEmbeddingProvider::setConcurrency(int concurrency) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    concurrency_ = std::max(1, concurrency);
+}
+
+void* OllamaEmbeddingProvider::handle(size_t slot) {
+    if (slot >= handles_.size()) {
+        handles_.resize(slot + 1, nullptr);
+    }
+    if (!handles_[slot]) {
+        handles_[slot] = curl_easy_init();
+    }
+    return handles_[slot];
+}
+
 void OllamaEmbeddingProvider::detectDimensions(const Embedding& emb) {
     if (!emb.empty() && dimensions_ == 0) {
         dimensions_ = static_cast<int>(emb.size());
@@ -105,79 +143,246 @@ EmbeddingResult OllamaEmbeddingProvider::embed(const std::string& text) {
     result.success = false;
     result.dimensions = 0;
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        result.error = "Failed to initialize CURL";
+    auto batch = embedBatch({text});
+    if (!batch.success) {
+        result.error = batch.error;
         return result;
     }
 
-    std::string url = host_ + "/api/embeddings";
+    result.embedding = std::move(batch.embeddings[0]);
+    result.dimensions = static_cast<int>(result.embedding.size());
+    result.success = true;
+    return result;
+}
+
+namespace {
+
+// One /api/embed request covering texts [begin, end)
+struct EmbedRequest {
+    size_t begin;
+    size_t end;
+    std::string payload;
     std::string response;
+    CURLcode code = CURLE_OK;
+    long status = 0;
+};
 
-    json request;
-    request["model"] = model_;
-    request["prompt"] = text;
+} // namespace
 
-    std::string payload = request.dump();
+BatchEmbeddingResult OllamaEmbeddingProvider::embedBatch(const std::vector<std::string>& texts) {
+    BatchEmbeddingResult result;
+    result.success = false;
+    result.dimensions = 0;
 
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
+    if (texts.empty()) {
+        result.success = true;
+        return result;
+    }
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payload.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (legacy_api_) {
+        return embedLegacy(texts);
+    }
 
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+    if (!multi_) {
+        multi_ = curl_multi_init();
+        if (!multi_) {
+            result.error = "Failed to initialize CURL";
+            return result;
+        }
+    }
+    CURLM* multi = static_cast<CURLM*>(multi_);
+
+    size_t batch_size = static_cast<size_t>(batch_size_);
+    std::vector<EmbedRequest> requests((texts.size() + batch_size - 1) / batch_size);
+    for (size_t r = 0; r < requests.size(); r++) {
+        auto& req = requests[r];
+        req.begin = r * batch_size;
+        req.end = std::min(texts.size(), req.begin + batch_size);
+
+        json request;
+        request["model"] = model_;
+        request["input"] = std::vector<std::string>(texts.begin() + req.begin, texts.begin() + req.end);
+        req.payload = request.dump();
+    }
 
-    if (res != CURLE_OK) {
-        result.error = curl_easy_strerror(res);
-        return result;
+    std::string url = host_ + "/api/embed";
+    struct curl_slist* headers = nullptr;
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+    headers = curl_slist_append(headers, "Expect:");  // Batch bodies are large; skip the 100-continue round trip
+
+    // Each slot owns one easy handle; a finished slot picks up the next request
+    size_t slots = std::min(requests.size(), static_cast<size_t>(concurrency_));
+    size_t next = 0;
+    size_t in_flight = 0;
+    bool failed = false;
+
+    auto start = [&](size_t slot) {
+        CURL* curl = static_cast<CURL*>(handle(slot));
+        if (!curl) {
+            failed = true;
+            return;
+        }
+        auto& req = requests[next++];
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, req.payload.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(req.payload.size()));
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &req.response);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 300L);
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, static_cast<void*>(&req));
+        curl_multi_add_handle(multi, curl);
+        in_flight++;
+    };
+
+    for (size_t slot = 0; slot < slots; slot++) {
+        start(slot);
     }
 
-    try {
-        json data = json::parse(response);
+    while (in_flight > 0) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* msg;
+        int queued;
+        while ((msg = curl_multi_info_read(multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            CURL* curl = msg->easy_handle;
+            EmbedRequest* req = nullptr;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, reinterpret_cast<char**>(&req));
+            req->code = msg->data.result;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &req->status);
+            curl_multi_remove_handle(multi, curl);
+            in_flight--;
+
+            if (req->code != CURLE_OK || req->status != 200) {
+                failed = true;
+            }
+            if (!failed && next < requests.size()) {
+                size_t slot = std::find(handles_.begin(), handles_.end(), curl) - handles_.begin();
+                start(slot);
+            }
+        }
+
+        if (in_flight > 0) {
+            curl_multi_wait(multi, nullptr, 0, 1000, nullptr);
+        }
+    }
+    curl_slist_free_all(headers);
 
-        if (data.contains("error")) {
-            result.error = data["error"].get<std::string>();
+    result.embeddings.resize(texts.size());
+    for (const auto& req : requests) {
+        if (req.status == 404) {
+            // Ollama before 0.3 only has the single-text endpoint. A JSON
+            // error body is a real 404 from /api/embed (e.g. unknown model).
+            json data = json::parse(req.response, nullptr, false);
+            if (!data.is_object() || !data.contains("error")) {
+                legacy_api_ = true;
+                return embedLegacy(texts);
+            }
+        }
+        if (req.code != CURLE_OK) {
+            result.error = curl_easy_strerror(req.code);
+            return result;
+        }
+        if (req.response.empty()) {
+            result.error = "Embedding request was not sent";
             return result;
         }
 
-        if (data.contains("embedding")) {
-            result.embedding = data["embedding"].get<std::vector<float>>();
-            detectDimensions(result.embedding);
-            result.dimensions = static_cast<int>(result.embedding.size());
-            result.success = true;
-        } else {
-            result.error = "No embedding in response";
+        try {
+            json data = json::parse(req.response);
+
+            if (data.contains("error")) {
+                result.error = data["error"].get<std::string>();
+                return result;
+            }
+            if (!data.contains("embeddings") || data["embeddings"].size() != req.end - req.begin) {
+                result.error = "Unexpected embedding count in response";
+                return result;
+            }
+
+            auto& embeddings = data["embeddings"];
+            for (size_t i = req.begin; i < req.end; i++) {
+                result.embeddings[i] = embeddings[i - req.begin].get<Embedding>();
+            }
+        } catch (const std::exception& e) {
+            result.error = std::string("Parse error: ") + e.what();
+            return result;
         }
-    } catch (const std::exception& e) {
-        result.error = std::string("Parse error: ") + e.what();
     }
 
+    detectDimensions(result.embeddings[0]);
+    result.dimensions = static_cast<int>(result.embeddings[0].size());
+    result.success = true;
     return result;
 }
 
-BatchEmbeddingResult OllamaEmbeddingProvider::embedBatch(const std::vector<std::string>& texts) {
+BatchEmbeddingResult OllamaEmbeddingProvider::embedLegacy(const std::vector<std::string>& texts) {
     BatchEmbeddingResult result;
-    result.success = true;
+    result.success = false;
     result.dimensions = 0;
 
+    CURL* curl = static_cast<CURL*>(handle(0));
+    if (!curl) {
+        result.error = "Failed to initialize CURL";
+        return result;
+    }
+
+    std::string url = host_ + "/api/embeddings";
+    struct curl_slist* headers = nullptr;
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+
     for (const auto& text : texts) {
-        auto single = embed(text);
-        if (!single.success) {
-            result.success = false;
-            result.error = single.error;
-            return result;
+        json request;
+        request["model"] = model_;
+        request["prompt"] = text;
+        std::string payload = request.dump();
+        std::string response;
+
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payload.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(payload.size()));
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
+
+        CURLcode res = curl_easy_perform(curl);
+        if (res != CURLE_OK) {
+            result.error = curl_easy_strerror(res);
+            break;
+        }
+
+        try {
+            json data = json::parse(response);
+
+            if (data.contains("error")) {
+                result.error = data["error"].get<std::string>();
+                break;
+            }
+            if (!data.contains("embedding")) {
+                result.error = "No embedding in response";
+                break;
+            }
+            result.embeddings.push_back(data["embedding"].get<Embedding>());
+        } catch (const std::exception& e) {
+            result.error = std::string("Parse error: ") + e.what();
+            break;
         }
-        result.embeddings.push_back(single.embedding);
-        result.dimensions = single.dimensions;
+    }
+    curl_slist_free_all(headers);
+
+    if (result.embeddings.size() != texts.size()) {
+        result.embeddings.clear();
+        return result;
     }
 
+    detectDimensions(result.embeddings[0]);
+    result.dimensions = static_cast<int>(result.embeddings[0].size());
+    result.success = true;
     return result;
 }
 
@@ -185,71 +390,78 @@ BatchEmbeddingResult OllamaEmbeddingProvider::embedBatch(const std::vector<std::
 // LocalEmbeddingProvider Implementation
 // ============================================================================
 
-LocalEmbeddingProvider::LocalEmbeddingProvider() : dimensions_(256) {
+namespace {
+
+const uint32_t kFnvOffset = 2166136261u;
+const uint32_t kFnvPrime = 16777619u;
+
+// Total text bytes in a batch below which the worker pool is not worth waking
+const size_t kParallelMinBytes = 64 * 1024;
+
+// Tokens are runs of ASCII letters and digits, as std::isalnum classifies
+// bytes in the C locale
+inline bool isTokenChar(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
 }
 
-std::vector<std::string> LocalEmbeddingProvider::tokenize(const std::string& text) {
-    std::vector<std::string> tokens;
-    std::string current;
+inline uint32_t lowerByte(char c) {
+    return static_cast<uint32_t>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+}
 
-    for (char c : text) {
-        if (std::isalnum(c)) {
-            current += std::tolower(c);
-        } else if (!current.empty()) {
-            if (current.length() >= 2) {  // Skip very short tokens
-                tokens.push_back(current);
-            }
-            current.clear();
-        }
-    }
+// One FNV-1a step
+inline uint32_t fnv(uint32_t h, char c) {
+    return (h ^ lowerByte(c)) * kFnvPrime;
+}
 
-    if (!current.empty() && current.length() >= 2) {
-        tokens.push_back(current);
-    }
+} // namespace
 
-    return tokens;
+LocalEmbeddingProvider::LocalEmbeddingProvider(int dimensions)
+    : dimensions_(std::max(dimensions, 1)) {
 }
 
-uint32_t LocalEmbeddingProvider::hash(const std::string& token) {
-    // Simple FNV-1a hash
-    uint32_t h = 2166136261u;
-    for (char c : token) {
-        h ^= static_cast<uint32_t>(c);
-        h *= 16777619u;
-    }
-    return h;
+LocalEmbeddingProvider::~LocalEmbeddingProvider() = default;
+
+void LocalEmbeddingProvider::setDimensions(int dimensions) {
+    dimensions_ = std::max(dimensions, 1);
 }
 
-Embedding LocalEmbeddingProvider::hashEmbed(const std::string& text) {
+Embedding LocalEmbeddingProvider::hashEmbed(std::string_view text) const {
+    const uint32_t dims = static_cast<uint32_t>(dimensions_);
     Embedding emb(dimensions_, 0.0f);
+    float* out = emb.data();
+
+    const char* data = text.data();
+    const size_t size = text.size();
+    size_t pos = 0;
+    while (pos < size) {
+        if (!isTokenChar(data[pos])) {
+            pos++;
+            continue;
+        }
 
-    auto tokens = tokenize(text);
-    if (tokens.empty()) return emb;
-
-    // Create TF (term frequency) based embedding
-    for (const auto& token : tokens) {
-        uint32_t h = hash(token);
+        // The token's own hash is built while scanning it
+        const char* token = data + pos;
+        uint32_t h = kFnvOffset;
+        while (pos < size && isTokenChar(data[pos])) {
+            h = fnv(h, data[pos]);
+            pos++;
+        }
+        const size_t length = static_cast<size_t>(data + pos - token);
+        if (length < 2) continue;  // Skip very short tokens
 
         // Use multiple hash positions for better distribution
-        for (int i = 0; i < 4; i++) {
-            uint32_t pos = (h + i * 0x9E3779B9) % dimensions_;
-            float sign = ((h >> (i * 8)) & 1) ? 1.0f : -1.0f;
-            emb[pos] += sign;
+        for (uint32_t i = 0; i < 4; i++) {
+            out[(h + i * 0x9E3779B9u) % dims] += ((h >> (i * 8)) & 1) ? 1.0f : -1.0f;
         }
 
-        // Also add character n-grams (2-grams and 3-grams)
-        for (size_t j = 0; j + 1 < token.length(); j++) {
-            std::string bigram = token.substr(j, 2);
-            uint32_t bh = hash(bigram);
-            uint32_t bpos = bh % dimensions_;
-            emb[bpos] += 0.5f;
+        // Character n-grams, all bigrams before all trigrams so every
+        // dimension sums in the same order as always. A trigram's hash
+        // continues its leading bigram's.
+        for (size_t j = 0; j + 1 < length; j++) {
+            out[fnv(fnv(kFnvOffset, token[j]), token[j + 1]) % dims] += 0.5f;
         }
-
-        for (size_t j = 0; j + 2 < token.length(); j++) {
-            std::string trigram = token.substr(j, 3);
-            uint32_t th = hash(trigram);
-            uint32_t tpos = th % dimensions_;
-            emb[tpos] += 0.3f;
+        for (size_t j = 0; j + 2 < length; j++) {
+            out[fnv(fnv(fnv(kFnvOffset, token[j]), token[j + 1]), token[j + 2]) % dims] += 0.3f;
         }
     }
 
@@ -281,11 +493,33 @@ BatchEmbeddingResult LocalEmbeddingProvider::embedBatch(const std::vector<std::s
     BatchEmbeddingResult result;
     result.success = true;
     result.dimensions = dimensions_;
+    result.embeddings.resize(texts.size());
 
-    for (const auto& text : texts) {
-        result.embeddings.push_back(hashEmbed(text));
+    size_t bytes = 0;
+    for (const auto& text : texts) bytes += text.size();
+
+    WorkerPool* pool = nullptr;
+    if (texts.size() > 1 && bytes >= kParallelMinBytes) {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (!pool_) pool_ = std::make_unique<WorkerPool>();
+        if (pool_->size() > 1) pool = pool_.get();
+    }
+
+    if (!pool) {
+        for (size_t i = 0; i < texts.size(); i++) {
+            result.embeddings[i] = hashEmbed(texts[i]);
+        }
+        return result;
     }
 
+    // Contiguous slices, a few per thread so uneven texts even out
+    size_t tasks = std::min(texts.size(), pool->size() * 4);
+    pool->run(tasks, [&](size_t task) {
+        size_t end = (task + 1) * texts.size() / tasks;
+        for (size_t i = task * texts.size() / tasks; i < end; i++) {
+            result.embeddings[i] = hashEmbed(texts[i]);
+        }
+    });
     return result;
 }
 
@@ -293,11 +527,13 @@ BatchEmbeddingResult LocalEmbeddingProvider::embedBatch(const std::vector<std::s
 // EmbeddingClient Implementation
 // ============================================================================
 
-EmbeddingClient::EmbeddingClient() : current_provider_("ollama") {
+EmbeddingClient::EmbeddingClient() : current_provider_("ollama"), cache_max_bytes_(0) {
     ollama_ = std::make_unique<OllamaEmbeddingProvider>();
     local_ = std::make_unique<LocalEmbeddingProvider>();
 }
 
+EmbeddingClient::~EmbeddingClient() = default;
+
 void EmbeddingClient::setProvider(const std::string& provider) {
     current_provider_ = provider;
 }
@@ -310,6 +546,51 @@ void EmbeddingClient::setOllamaModel(const std::string& model) {
     ollama_->setModel(model);
 }
 
+void EmbeddingClient::setBatchSize(int batch_size) {
+    ollama_->setBatchSize(batch_size);
+}
+
+void EmbeddingClient::setConcurrency(int concurrency) {
+    ollama_->setConcurrency(concurrency);
+}
+
+void EmbeddingClient::setLocalDimensions(int dimensions) {
+    local_->setDimensions(dimensions);
+}
+
+bool EmbeddingClient::enableCache(const std::string& path, int64_t max_bytes) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (cache_ && cache_path_ == path) {
+        if (cache_max_bytes_ != max_bytes) {
+            cache_->setLimits(0, max_bytes);
+            cache_max_bytes_ = max_bytes;
+        }
+        return true;
+    }
+
+    // Every client with the same path shares one instance
+    auto cache = EmbeddingCache::shared(path);
+    if (!cache) {
+        return false;
+    }
+    cache->setLimits(0, max_bytes);
+    cache_ = std::move(cache);
+    cache_path_ = path;
+    cache_max_bytes_ = max_bytes;
+    return true;
+}
+
+void EmbeddingClient::disableCache() {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    cache_.reset();
+    cache_path_.clear();
+}
+
+std::shared_ptr<EmbeddingCache> EmbeddingClient::getCache() const {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return cache_;
+}
+
 std::string EmbeddingClient::getProvider() const {
     return current_provider_;
 }
@@ -336,26 +617,86 @@ EmbeddingProvider* EmbeddingClient::getActiveProvider() {
 }
 
 EmbeddingResult EmbeddingClient::embed(const std::string& text) {
-    auto result = getActiveProvider()->embed(text);
+    EmbeddingProvider* provider = getActiveProvider();
+    std::shared_ptr<EmbeddingCache> cache = getCache();
+
+    if (cache) {
+        std::vector<Embedding> cached;
+        std::vector<bool> found;
+        if (cache->lookup(provider->getName(), provider->getModel(), {text}, cached, found) == 1) {
+            EmbeddingResult result;
+            result.success = true;
+            result.embedding = std::move(cached[0]);
+            result.dimensions = static_cast<int>(result.embedding.size());
+            return result;
+        }
+    }
+
+    auto result = provider->embed(text);
 
-    // Fallback to local if Ollama fails
+    // Fallback to local if Ollama fails (not cached, the local model is cheap)
     if (!result.success && current_provider_ == "ollama") {
         std::cerr << "Ollama embedding failed, falling back to local: " << result.error << std::endl;
         return local_->embed(text);
     }
 
+    if (result.success && cache) {
+        cache->store(provider->getName(), provider->getModel(), {text}, {result.embedding});
+    }
     return result;
 }
 
 BatchEmbeddingResult EmbeddingClient::embedBatch(const std::vector<std::string>& texts) {
-    auto result = getActiveProvider()->embedBatch(texts);
+    EmbeddingProvider* provider = getActiveProvider();
+    std::shared_ptr<EmbeddingCache> cache = getCache();
+
+    std::vector<Embedding> embeddings;
+    std::vector<bool> found;
+    size_t hits = 0;
+    if (cache) {
+        hits = cache->lookup(provider->getName(), provider->getModel(), texts, embeddings, found);
+    }
 
-    // Fallback to local if Ollama fails
-    if (!result.success && current_provider_ == "ollama") {
-        std::cerr << "Ollama embedding failed, falling back to local: " << result.error << std::endl;
-        return local_->embedBatch(texts);
+    // Only the cache misses go to the model
+    std::vector<std::string> missing;
+    if (hits > 0) {
+        missing.reserve(texts.size() - hits);
+        for (size_t i = 0; i < texts.size(); i++) {
+            if (!found[i]) missing.push_back(texts[i]);
+        }
+    }
+    const std::vector<std::string>& pending = hits > 0 ? missing : texts;
+
+    BatchEmbeddingResult result;
+    result.success = true;
+    result.dimensions = 0;
+    if (!pending.empty()) {
+        result = provider->embedBatch(pending);
+
+        // Fallback to local if Ollama fails, for the whole batch so the
+        // embeddings stay comparable
+        if (!result.success && current_provider_ == "ollama") {
+            std::cerr << "Ollama embedding failed, falling back to local: " << result.error << std::endl;
+            return local_->embedBatch(texts);
+        }
+        if (!result.success) {
+            return result;
+        }
+        if (cache) {
+            cache->store(provider->getName(), provider->getModel(), pending, result.embeddings);
+        }
+        if (hits == 0) {
+            return result;
+        }
     }
 
+    // Merge fresh embeddings into the cached ones
+    size_t next = 0;
+    for (size_t i = 0; i < texts.size(); i++) {
+        if (!found[i]) embeddings[i] = std::move(result.embeddings[next++]);
+    }
+    result.embeddings = std::move(embeddings);
+    result.dimensions = result.embeddings.empty() ? 0 : static_cast<int>(result.embeddings[0].size());
     return result;
 }
 
@@ -369,15 +710,8 @@ bool EmbeddingClient::isAvailable() {
 float EmbeddingClient::cosineSimilarity(const Embedding& a, const Embedding& b) {
     if (a.size() != b.size() || a.empty()) return 0.0f;
 
-    float dot = 0.0f;
-    float norm_a = 0.0f;
-    float norm_b = 0.0f;
-
-    for (size_t i = 0; i < a.size(); i++) {
-        dot += a[i] * b[i];
-        norm_a += a[i] * a[i];
-        norm_b += b[i] * b[i];
-    }
+    float dot, norm_a, norm_b;
+    simd::dotAndNorms(a.data(), b.data(), a.size(), dot, norm_a, norm_b);
 
     float denom = std::sqrt(norm_a) * std::sqrt(norm_b);
     if (denom == 0.0f) return 0.0f;
@@ -387,30 +721,26 @@ float EmbeddingClient::cosineSimilarity(const Embedding& a, const Embedding& b)
 
 float EmbeddingClient::dotProduct(const Embedding& a, const Embedding& b) {
     if (a.size() != b.size()) return 0.0f;
-
-    float dot = 0.0f;
-    for (size_t i = 0; i < a.size(); i++) {
-        dot += a[i] * b[i];
-    }
-    return dot;
+    return simd::dot(a.data(), b.data(), a.size());
 }
 
 Embedding EmbeddingClient::normalize(const Embedding& emb) {
     Embedding result = emb;
-    float norm = 0.0f;
-
-    for (float v : emb) {
-        norm += v * v;
-    }
-    norm = std::sqrt(norm);
+    float norm = std::sqrt(simd::squaredNorm(emb.data(), emb.size()));
 
     if (norm > 0) {
-        for (float& v : result) {
-            v /= norm;
-        }
+        simd::scale(result.data(), result.size(), 1.0f / norm);
     }
 
     return result;
 }
 
+void EmbeddingClient::dotProductBatch(const Embedding& query, const float* rows, size_t count, size_t stride, float* scores) {
+    simd::dotBatch(query.data(), rows, count, query.size(), stride, scores);
+}
+
+void EmbeddingClient::cosineSimilarityBatch(const Embedding& query, const float* rows, size_t count, size_t stride, float* scores) {
+    simd::cosineBatch(query.data(), rows, count, query.size(), stride, scores);
+}
+
 } // namespace casper
@@ -0,0 +1,519 @@
+#include "hnsw_index.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+
+namespace casper {
+
+HNSWIndex::HNSWIndex() : HNSWIndex(HNSWParams()) {
+}
+
+HNSWIndex::HNSWIndex(const HNSWParams& params)
+    : params_(params)
+    , dimensions_(0)
+    , matrix_(nullptr)
+    , quantizer_(nullptr)
+    , row_bytes_(0)
+    , entry_point_(-1)
+    , max_level_(-1)
+    , deleted_count_(0)
+    , rng_(42) {
+    setParams(params);
+}
+
+void HNSWIndex::setParams(const HNSWParams& params) {
+    params_ = params;
+    if (params_.M < 2) params_.M = 2;
+    if (params_.ef_construction < params_.M) params_.ef_construction = params_.M;
+    if (params_.ef_search < 1) params_.ef_search = 1;
+    level_mult_ = 1.0 / std::log(static_cast<double>(params_.M));
+}
+
+void HNSWIndex::reset(const EmbeddingMatrix* matrix, const VectorQuantizer* quantizer) {
+    matrix_ = matrix;
+    quantizer_ = quantizer && quantizer->ready() ? quantizer : nullptr;
+    setDimensions(quantizer_ ? quantizer_->dimensions() : 0);
+    nodes_.clear();
+    rows_.clear();
+    rows_.shrink_to_fit();
+    copies_.clear();
+    copies_.shrink_to_fit();
+    labels_.clear();
+    dirty_.clear();
+    entry_point_ = -1;
+    max_level_ = -1;
+    deleted_count_ = 0;
+}
+
+float HNSWIndex::distance(const float* a, const float* b) const {
+    return 1.0f - simd::dot(a, b, static_cast<size_t>(dimensions_));
+}
+
+int HNSWIndex::randomLevel() {
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    double r = dist(rng_);
+    if (r <= 0.0) r = 1e-12;
+    return static_cast<int>(-std::log(r) * level_mult_);
+}
+
+size_t HNSWIndex::maxLinks(int layer) const {
+    return static_cast<size_t>(layer == 0 ? params_.M * 2 : params_.M);
+}
+
+void HNSWIndex::setDimensions(int dimensions) {
+    dimensions_ = dimensions;
+    row_bytes_ = quantizer_ ? quantizer_->codeSize() : static_cast<size_t>(dimensions) * sizeof(float);
+    zeros_.assign(row_bytes_, 0);
+}
+
+bool HNSWIndex::rowFits(int64_t row, const std::string& id) const {
+    return matrix_ && row >= 0 && static_cast<size_t>(row) < matrix_->size() &&
+           matrix_->holdsCodes() == (quantizer_ != nullptr) && matrix_->rowBytes() == row_bytes_ &&
+           matrix_->idAt(static_cast<size_t>(row)) == id;
+}
+
+void HNSWIndex::setRow(uint32_t label, int64_t row) {
+    if (rows_.size() <= label) {
+        rows_.resize(static_cast<size_t>(label) + 1, kNoRow);
+    }
+    rows_[label] = row;
+}
+
+void HNSWIndex::copyRow(uint32_t label, const uint8_t* data) {
+    size_t copy = copies_.size() / std::max<size_t>(row_bytes_, 1);
+    copies_.insert(copies_.end(), data, data + row_bytes_);
+    setRow(label, kCopied - static_cast<int64_t>(copy));
+}
+
+uint32_t HNSWIndex::greedyClosest(const float* query, uint32_t entry, int from_layer, int to_layer) const {
+    auto buffer = scratch();
+    uint32_t current = entry;
+    float current_dist = distance(query, vectorAt(current, buffer.data()));
+
+    for (int layer = from_layer; layer >= to_layer; layer--) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (uint32_t neighbor : nodes_[current].links[layer]) {
+                float d = distance(query, vectorAt(neighbor, buffer.data()));
+                if (d < current_dist) {
+                    current_dist = d;
+                    current = neighbor;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    return current;
+}
+
+std::vector<HNSWIndex::Candidate> HNSWIndex::searchLayer(const float* query, uint32_t entry, size_t ef, int layer) const {
+    // candidates: closest first; found: furthest first (bounded by ef)
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+    std::priority_queue<Candidate> found;
+    std::unordered_set<uint32_t> visited;
+    auto buffer = scratch();
+
+    float d = distance(query, vectorAt(entry, buffer.data()));
+    candidates.emplace(d, entry);
+    found.emplace(d, entry);
+    visited.insert(entry);
+
+    while (!candidates.empty()) {
+        Candidate current = candidates.top();
+        if (current.first > found.top().first && found.size() >= ef) {
+            break;
+        }
+        candidates.pop();
+
+        for (uint32_t neighbor : nodes_[current.second].links[layer]) {
+            if (!visited.insert(neighbor).second) continue;
+
+            float nd = distance(query, vectorAt(neighbor, buffer.data()));
+            if (found.size() < ef || nd < found.top().first) {
+                candidates.emplace(nd, neighbor);
+                found.emplace(nd, neighbor);
+                if (found.size() > ef) {
+                    found.pop();
+                }
+            }
+        }
+    }
+
+    std::vector<Candidate> result;
+    result.reserve(found.size());
+    while (!found.empty()) {
+        result.push_back(found.top());
+        found.pop();
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+std::vector<uint32_t> HNSWIndex::selectNeighbors(std::vector<Candidate> candidates, size_t m) const {
+    std::sort(candidates.begin(), candidates.end());
+
+    // Heuristic from the HNSW paper: keep a candidate only if it is closer to
+    // the base than to any neighbour already selected. This keeps links
+    // spread out instead of clustering in one direction.
+    std::vector<uint32_t> selected;
+    auto cand_buffer = scratch();
+    auto buffer = scratch();
+    for (const auto& cand : candidates) {
+        if (selected.size() >= m) break;
+
+        bool keep = true;
+        const float* vec = vectorAt(cand.second, cand_buffer.data());
+        for (uint32_t s : selected) {
+            if (distance(vec, vectorAt(s, buffer.data())) < cand.first) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) {
+            selected.push_back(cand.second);
+        }
+    }
+
+    return selected;
+}
+
+uint32_t HNSWIndex::add(const std::string& id, const Embedding& embedding) {
+    if (dimensions_ == 0) {
+        setDimensions(static_cast<int>(embedding.size()));
+    }
+
+    // Re-adding an id replaces the previous vector
+    markDeleted(id);
+
+    uint32_t label = static_cast<uint32_t>(nodes_.size());
+    int level = randomLevel();
+
+    Node node;
+    node.id = id;
+    node.level = level;
+    node.deleted = false;
+    node.links.resize(level + 1);
+    nodes_.push_back(std::move(node));
+    Embedding normalized = EmbeddingClient::normalize(embedding);
+    int64_t row = matrix_ ? matrix_->rowOf(id) : kNoRow;
+    if (rowFits(row, id)) {
+        setRow(label, row);
+    } else if (quantizer_) {
+        std::vector<uint8_t> code(row_bytes_);
+        quantizer_->encode(normalized.data(), code.data());
+        copyRow(label, code.data());
+    } else {
+        copyRow(label, reinterpret_cast<const uint8_t*>(normalized.data()));
+    }
+    labels_[id] = label;
+    dirty_.insert(label);
+
+    if (entry_point_ < 0) {
+        entry_point_ = label;
+        max_level_ = level;
+        return label;
+    }
+
+    // The new node is searched for with its exact vector, codes or not
+    const float* query = normalized.data();
+    auto base_buffer = scratch();
+    auto buffer = scratch();
+    uint32_t current = static_cast<uint32_t>(entry_point_);
+
+    if (max_level_ > level) {
+        current = greedyClosest(query, current, max_level_, level + 1);
+    }
+
+    for (int layer = std::min(level, max_level_); layer >= 0; layer--) {
+        auto found = searchLayer(query, current, static_cast<size_t>(params_.ef_construction), layer);
+
+        std::vector<Candidate> live;
+        live.reserve(found.size());
+        for (const auto& cand : found) {
+            if (!nodes_[cand.second].deleted && cand.second != label) {
+                live.push_back(cand);
+            }
+        }
+
+        auto neighbors = selectNeighbors(live, static_cast<size_t>(params_.M));
+        nodes_[label].links[layer] = neighbors;
+
+        // Add reverse links, shrinking neighbour lists that overflow
+        for (uint32_t neighbor : neighbors) {
+            auto& links = nodes_[neighbor].links[layer];
+            links.push_back(label);
+
+            if (links.size() > maxLinks(layer)) {
+                const float* base = vectorAt(neighbor, base_buffer.data());
+                std::vector<Candidate> cands;
+                cands.reserve(links.size());
+                for (uint32_t l : links) {
+                    cands.emplace_back(distance(base, vectorAt(l, buffer.data())), l);
+                }
+                links = selectNeighbors(cands, maxLinks(layer));
+            }
+            dirty_.insert(neighbor);
+        }
+
+        if (!found.empty()) {
+            current = found.front().second;
+        }
+    }
+
+    if (level > max_level_) {
+        entry_point_ = label;
+        max_level_ = level;
+    }
+
+    return label;
+}
+
+bool HNSWIndex::markDeleted(const std::string& id) {
+    auto it = labels_.find(id);
+    if (it == labels_.end()) return false;
+
+    // The matrix row is about to be removed or overwritten: the tombstone
+    // routes with a copy from now on
+    int64_t row = rows_[it->second];
+    if (row >= 0) {
+        if (rowFits(row, id)) {
+            copyRow(it->second, matrix_->codeAt(static_cast<size_t>(row)));
+        } else {
+            rows_[it->second] = kNoRow;
+        }
+    }
+
+    nodes_[it->second].deleted = true;
+    dirty_.insert(it->second);
+    labels_.erase(it);
+    deleted_count_++;
+    return true;
+}
+
+bool HNSWIndex::contains(const std::string& id) const {
+    return labels_.count(id) > 0;
+}
+
+void HNSWIndex::rowMoved(const std::string& id, size_t row) {
+    auto it = labels_.find(id);
+    if (it != labels_.end() && rows_[it->second] >= 0) {
+        rows_[it->second] = static_cast<int64_t>(row);
+    }
+}
+
+void HNSWIndex::remapRows() {
+    for (const auto& entry : labels_) {
+        int64_t& row = rows_[entry.second];
+        if (row < 0) continue;  // Nodes on a copy keep it
+        int64_t moved = matrix_ ? matrix_->rowOf(entry.first) : kNoRow;
+        row = rowFits(moved, entry.first) ? moved : kNoRow;
+    }
+}
+
+std::vector<std::pair<std::string, float>> HNSWIndex::search(const Embedding& query, int k, int ef) const {
+    std::vector<std::pair<std::string, float>> results;
+    if (entry_point_ < 0 || k <= 0 || static_cast<int>(query.size()) != dimensions_) {
+        return results;
+    }
+
+    Embedding q = EmbeddingClient::normalize(query);
+    size_t search_ef = static_cast<size_t>(std::max({ef > 0 ? ef : params_.ef_search, k, 1}));
+
+    uint32_t entry = greedyClosest(q.data(), static_cast<uint32_t>(entry_point_), max_level_, 1);
+    auto found = searchLayer(q.data(), entry, search_ef, 0);
+
+    for (const auto& cand : found) {
+        if (nodes_[cand.second].deleted) continue;
+        results.emplace_back(nodes_[cand.second].id, 1.0f - cand.first);
+        if (static_cast<int>(results.size()) >= k) break;
+    }
+
+    return results;
+}
+
+std::vector<uint32_t> HNSWIndex::takeDirty() {
+    std::vector<uint32_t> dirty(dirty_.begin(), dirty_.end());
+    dirty_.clear();
+    std::sort(dirty.begin(), dirty.end());
+    return dirty;
+}
+
+void HNSWIndex::restoreNode(uint32_t label, const std::string& id, int level, bool deleted,
+                            std::vector<std::vector<uint32_t>> links, int64_t row) {
+    if (dimensions_ == 0 && matrix_) {
+        setDimensions(matrix_->dimensions());
+    }
+    if (nodes_.size() <= label) {
+        nodes_.resize(static_cast<size_t>(label) + 1, Node{"", 0, true, {{}}});
+    }
+
+    links.resize(level + 1);
+    nodes_[label] = Node{id, level, deleted, std::move(links)};
+    // Tombstones restored without a vector read zeros
+    rows_.resize(std::max(rows_.size(), nodes_.size()), kNoRow);
+    rows_[label] = rowFits(row, id) ? row : kNoRow;
+
+    if (!deleted) {
+        labels_[id] = label;
+    }
+
+    deleted_count_ = nodes_.size() - labels_.size();
+}
+
+void HNSWIndex::restoreEntryPoint(int64_t entry_point, int max_level) {
+    entry_point_ = entry_point;
+    max_level_ = max_level;
+}
+
+bool HNSWIndex::linksConsistent() const {
+    if (entry_point_ < 0) return liveCount() == 0 && max_level_ < 0;
+    if (static_cast<size_t>(entry_point_) >= nodes_.size() || nodes_[entry_point_].level < max_level_) {
+        return false;
+    }
+
+    for (const auto& node : nodes_) {
+        for (int layer = 0; layer < static_cast<int>(node.links.size()); layer++) {
+            for (uint32_t neighbor : node.links[layer]) {
+                if (neighbor >= nodes_.size() || nodes_[neighbor].level < layer) return false;
+            }
+        }
+    }
+    return true;
+}
+
+size_t HNSWIndex::memoryBytes() const {
+    size_t bytes = rows_.capacity() * sizeof(int64_t) + copies_.capacity() + nodes_.capacity() * sizeof(Node);
+    for (const auto& node : nodes_) {
+        bytes += node.id.capacity();
+        for (const auto& layer : node.links) bytes += sizeof(layer) + layer.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+void HNSWIndex::detachDeleted() {
+    if (deleted_count_ == 0) return;
+
+    auto gone = [this](uint32_t l) { return l >= nodes_.size() || nodes_[l].deleted; };
+
+    // A live node that linked to tombstones is relinked among its remaining
+    // neighbours and the live nodes those tombstones led to (through chains
+    // of tombstones too), with the insertion heuristic, so the graph keeps
+    // its connectivity. Tombstone links are only cleared afterwards.
+    auto base_buffer = scratch();
+    auto buffer = scratch();
+    std::vector<uint32_t> pending;
+    std::unordered_set<uint32_t> seen;
+    for (uint32_t label = 0; label < nodes_.size(); label++) {
+        Node& node = nodes_[label];
+        if (node.deleted) continue;
+
+        for (int layer = 0; layer < static_cast<int>(node.links.size()); layer++) {
+            auto& links = node.links[layer];
+            if (std::none_of(links.begin(), links.end(), gone)) continue;
+
+            std::vector<uint32_t> cands;
+            seen.clear();
+            seen.insert(label);
+            pending.clear();
+            for (uint32_t l : links) {
+                if (l >= nodes_.size() || !seen.insert(l).second) continue;
+                if (nodes_[l].deleted) {
+                    pending.push_back(l);
+                } else {
+                    cands.push_back(l);
+                }
+            }
+            while (!pending.empty() && cands.size() < static_cast<size_t>(params_.ef_construction)) {
+                uint32_t dead = pending.back();
+                pending.pop_back();
+                if (static_cast<int>(nodes_[dead].links.size()) <= layer) continue;
+                for (uint32_t l : nodes_[dead].links[layer]) {
+                    if (l >= nodes_.size() || !seen.insert(l).second) continue;
+                    if (nodes_[l].deleted) {
+                        pending.push_back(l);
+                    } else {
+                        cands.push_back(l);
+                    }
+                }
+            }
+
+            const float* base = vectorAt(label, base_buffer.data());
+            std::vector<Candidate> scored;
+            scored.reserve(cands.size());
+            for (uint32_t l : cands) {
+                scored.emplace_back(distance(base, vectorAt(l, buffer.data())), l);
+            }
+            // The heuristic alone prunes most of this small, local candidate
+            // set; top up to the previous degree with the closest of the rest
+            size_t degree = std::min(links.size(), maxLinks(layer));
+            auto selected = selectNeighbors(scored, maxLinks(layer));
+            std::sort(scored.begin(), scored.end());
+            for (const auto& cand : scored) {
+                if (selected.size() >= degree) break;
+                if (std::find(selected.begin(), selected.end(), cand.second) == selected.end()) {
+                    selected.push_back(cand.second);
+                }
+            }
+            links = std::move(selected);
+            dirty_.insert(label);
+        }
+    }
+
+    for (auto& node : nodes_) {
+        if (node.deleted) {
+            for (auto& layer : node.links) layer.clear();
+        }
+    }
+
+    if (entry_point_ >= 0 && static_cast<size_t>(entry_point_) < nodes_.size() &&
+        !nodes_[entry_point_].deleted) {
+        return;
+    }
+
+    entry_point_ = -1;
+    max_level_ = -1;
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        if (!nodes_[i].deleted && nodes_[i].level > max_level_) {
+            entry_point_ = static_cast<int64_t>(i);
+            max_level_ = nodes_[i].level;
+        }
+    }
+}
+
+std::string HNSWIndex::serializeLinks(const std::vector<std::vector<uint32_t>>& links) {
+    std::string data;
+    for (const auto& layer : links) {
+        uint32_t count = static_cast<uint32_t>(layer.size());
+        data.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        data.append(reinterpret_cast<const char*>(layer.data()), layer.size() * sizeof(uint32_t));
+    }
+    return data;
+}
+
+std::vector<std::vector<uint32_t>> HNSWIndex::deserializeLinks(const void* data, size_t size) {
+    std::vector<std::vector<uint32_t>> links;
+    const char* p = static_cast<const char*>(data);
+    const char* end = p + size;
+
+    while (p + sizeof(uint32_t) <= end) {
+        uint32_t count;
+        std::memcpy(&count, p, sizeof(count));
+        p += sizeof(count);
+
+        size_t bytes = static_cast<size_t>(count) * sizeof(uint32_t);
+        if (p + bytes > end) break;
+
+        std::vector<uint32_t> layer(count);
+        if (bytes > 0) std::memcpy(layer.data(), p, bytes);
+        p += bytes;
+        links.push_back(std::move(layer));
+    }
+
+    return links;
+}
+
+} // namespace casper
@@ -0,0 +1,212 @@
+#include "mapped_file.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+namespace casper {
+
+namespace {
+
+// Address ranges of the open mappings, readable from the SIGBUS handler.
+// A slot is free while its begin is 0.
+struct GuardSlot {
+    std::atomic<uintptr_t> begin{0};
+    std::atomic<uintptr_t> end{0};
+    std::atomic<bool> faulted{false};
+};
+
+const int kGuardSlots = 64;
+GuardSlot g_slots[kGuardSlots];
+struct sigaction g_previous_action;
+uintptr_t g_page_size = 4096;
+
+// A fault inside a guarded mapping means the file shrank under it: the
+// page is replaced by a zero page so the read can complete, and the slot
+// remembers it. Any other fault goes to the previous handler, which runs
+// when the faulting instruction is retried.
+void onBusError(int, siginfo_t* info, void*) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(info->si_addr);
+    for (GuardSlot& slot : g_slots) {
+        uintptr_t begin = slot.begin.load();
+        if (begin == 0 || address < begin || address >= slot.end.load()) continue;
+
+        void* page = reinterpret_cast<void*>(address & ~(g_page_size - 1));
+        if (mmap(page, g_page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED) {
+            slot.faulted.store(true);
+            return;
+        }
+        break;
+    }
+    sigaction(SIGBUS, &g_previous_action, nullptr);
+}
+
+void installBusHandler() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        g_page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        struct sigaction action = {};
+        action.sa_sigaction = onBusError;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGBUS, &action, &g_previous_action);
+    });
+}
+
+int claimSlot(const void* data, size_t size) {
+    installBusHandler();
+    for (int i = 0; i < kGuardSlots; i++) {
+        uintptr_t expected = 0;
+        uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+        if (g_slots[i].begin.compare_exchange_strong(expected, begin)) {
+            g_slots[i].faulted.store(false);
+            g_slots[i].end.store(begin + size);
+            return i;
+        }
+    }
+    return -1;
+}
+
+void releaseSlot(int slot) {
+    g_slots[slot].end.store(0);
+    g_slots[slot].begin.store(0);
+}
+
+} // namespace
+
+MappedFile::MappedFile()
+    : data_(nullptr)
+    , size_(0)
+    , open_(false)
+    , slot_(-1) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0))
+    , open_(std::exchange(other.open_, false))
+    , slot_(std::exchange(other.slot_, -1))
+    , buffer_(std::move(other.buffer_)) {
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        open_ = std::exchange(other.open_, false);
+        slot_ = std::exchange(other.slot_, -1);
+        buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path, size_t map_from) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size > 0 && size >= map_from) {
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        slot_ = claimSlot(data, size);
+        if (slot_ < 0) {
+            // No guard left for it: read the file instead
+            munmap(data, size);
+        } else {
+            // Ingestion reads front to back: read ahead aggressively
+            madvise(data, size, MADV_SEQUENTIAL);
+            data_ = data;
+        }
+    }
+
+    if (size > 0 && !data_) {
+        // Plain read; a file that shrank since fstat is just shorter
+        buffer_.reset(new char[size]);
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = ::read(fd, buffer_.get() + done, size - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+                ::close(fd);
+                buffer_.reset();
+                return false;
+            }
+            if (n == 0) break;
+            done += static_cast<size_t>(n);
+        }
+        size = done;
+        data_ = buffer_.get();
+    }
+    // The mapping keeps the file contents reachable
+    ::close(fd);
+
+    size_ = size;
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (slot_ >= 0) {
+        munmap(data_, size_);
+        releaseSlot(slot_);
+    }
+    buffer_.reset();
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    slot_ = -1;
+}
+
+bool MappedFile::changed() const {
+    return slot_ >= 0 && g_slots[slot_].faulted.load();
+}
+
+void MappedFile::release(size_t offset, size_t length) {
+    if (slot_ < 0 || offset >= size_) return;
+    length = std::min(length, size_ - offset);
+
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = (offset + page - 1) / page * page;
+    size_t end = (offset + length) / page * page;
+    if (offset + length == size_) end = size_;  // The tail page holds nothing else
+    if (end <= begin) return;
+
+    madvise(static_cast<char*>(data_) + begin, end - begin, MADV_DONTNEED);
+}
+
+bool MappedFile::looksBinary(std::string_view sample) {
+    size_t control = 0;
+    for (unsigned char c : sample) {
+        if (c == 0) return true;
+        if ((c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != '\v' && c != '\b' && c != 0x1b) ||
+            c == 0x7f) {
+            control++;
+        }
+    }
+    return control * 10 > sample.size();
+}
+
+} // namespace casper
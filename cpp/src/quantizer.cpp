@@ -0,0 +1,347 @@
+#include "quantizer.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <random>
+
+namespace casper {
+
+namespace {
+
+const int kTrainingIterations = 8;
+
+} // namespace
+
+VectorQuantizer::VectorQuantizer()
+    : mode_(QuantizationMode::None)
+    , dimensions_(0)
+    , sub_dims_(0)
+    , subspaces_(0) {
+}
+
+QuantizationMode VectorQuantizer::parseMode(const std::string& name) {
+    if (name == "fp16" || name == "float16") return QuantizationMode::FP16;
+    if (name == "int8") return QuantizationMode::Int8;
+    if (name == "pq") return QuantizationMode::PQ;
+    return QuantizationMode::None;
+}
+
+std::string VectorQuantizer::modeName(QuantizationMode mode) {
+    switch (mode) {
+        case QuantizationMode::FP16: return "fp16";
+        case QuantizationMode::Int8: return "int8";
+        case QuantizationMode::PQ: return "pq";
+        default: return "none";
+    }
+}
+
+void VectorQuantizer::configure(QuantizationMode mode, int dimensions) {
+    mode_ = mode;
+    dimensions_ = std::max(dimensions, 0);
+    centroids_.clear();
+    columns_.clear();
+    centroid_norms_.clear();
+
+    // Subspaces of 8 floats when possible (96 bytes for 768 dims)
+    sub_dims_ = 0;
+    subspaces_ = 0;
+    if (dimensions_ > 0) {
+        for (size_t candidate : {8, 4, 2, 1}) {
+            if (dimensions_ % candidate == 0) {
+                sub_dims_ = candidate;
+                break;
+            }
+        }
+        subspaces_ = dimensions_ / sub_dims_;
+    }
+}
+
+bool VectorQuantizer::ready() const {
+    if (mode_ == QuantizationMode::None || dimensions_ <= 0) return false;
+    return !needsTraining();
+}
+
+size_t VectorQuantizer::codeSize() const {
+    switch (mode_) {
+        case QuantizationMode::FP16: return dimensions_ * sizeof(uint16_t);
+        case QuantizationMode::Int8: return sizeof(float) + dimensions_;
+        case QuantizationMode::PQ: return subspaces_;
+        default: return dimensions_ * sizeof(float);
+    }
+}
+
+double VectorQuantizer::compressionRatio() const {
+    size_t bytes = codeSize();
+    if (bytes == 0) return 1.0;
+    return static_cast<double>(dimensions_ * sizeof(float)) / bytes;
+}
+
+// ----------------------------------------------------------------------------
+// Product quantization codebook
+// ----------------------------------------------------------------------------
+
+// Cache the column layout and squared norms used by dotCentroids()
+void VectorQuantizer::refreshSubspace(size_t subspace) {
+    float* columns = columns_.data() + subspace * sub_dims_ * kCentroids;
+    for (size_t c = 0; c < kCentroids; c++) {
+        const float* cent = centroid(subspace, c);
+        for (size_t d = 0; d < sub_dims_; d++) {
+            columns[d * kCentroids + c] = cent[d];
+        }
+        centroid_norms_[subspace * kCentroids + c] = simd::squaredNorm(cent, sub_dims_);
+    }
+}
+
+// out[c] += scale * dot(sub, centroid c), for all centroids of a subspace.
+// Subspaces are only a few floats wide, so this runs along the centroids.
+void VectorQuantizer::dotCentroids(size_t subspace, const float* sub, float scale, float* out) const {
+    const float* columns = columns_.data() + subspace * sub_dims_ * kCentroids;
+    for (size_t d = 0; d < sub_dims_; d++) {
+        simd::axpy(out, columns + d * kCentroids, kCentroids, scale * sub[d]);
+    }
+}
+
+// Nearest by L2: |x - c|^2 = |x|^2 - 2 x.c + |c|^2, and |x|^2 is the same for every c
+size_t VectorQuantizer::nearestCentroid(size_t subspace, const float* sub) const {
+    float dist[kCentroids];
+    std::memcpy(dist, centroid_norms_.data() + subspace * kCentroids, sizeof(dist));
+    dotCentroids(subspace, sub, -2.0f, dist);
+
+    // Four independent running minima keep the compare chain short
+    size_t best[4] = {0, 1, 2, 3};
+    float best_dist[4] = {dist[0], dist[1], dist[2], dist[3]};
+    for (size_t c = 4; c < kCentroids; c += 4) {
+        for (size_t lane = 0; lane < 4; lane++) {
+            if (dist[c + lane] < best_dist[lane]) {
+                best_dist[lane] = dist[c + lane];
+                best[lane] = c + lane;
+            }
+        }
+    }
+
+    size_t winner = 0;
+    for (size_t lane = 1; lane < 4; lane++) {
+        if (best_dist[lane] < best_dist[winner]) winner = lane;
+    }
+    return best[winner];
+}
+
+bool VectorQuantizer::train(const float* rows, size_t count, size_t stride) {
+    if (mode_ != QuantizationMode::PQ || dimensions_ <= 0 || count < kMinTrainingRows) {
+        return false;
+    }
+
+    // Evenly spaced sample of the corpus
+    size_t dims = static_cast<size_t>(dimensions_);
+    size_t samples = std::min(count, kMaxTrainingRows);
+    std::vector<float> data(samples * dims);
+    for (size_t i = 0; i < samples; i++) {
+        std::memcpy(data.data() + i * dims, rows + (i * count / samples) * stride, dims * sizeof(float));
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> pick(0, samples - 1);
+    std::vector<size_t> order(samples);
+    std::vector<float> sums(kCentroids * sub_dims_);
+    std::vector<size_t> counts(kCentroids);
+
+    centroids_.assign(subspaces_ * kCentroids * sub_dims_, 0.0f);
+    columns_.assign(centroids_.size(), 0.0f);
+    centroid_norms_.assign(subspaces_ * kCentroids, 0.0f);
+
+    for (size_t s = 0; s < subspaces_; s++) {
+        size_t offset = s * sub_dims_;
+
+        // Seed with distinct samples
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+        for (size_t c = 0; c < kCentroids; c++) {
+            std::memcpy(centroids_.data() + (s * kCentroids + c) * sub_dims_,
+                        data.data() + order[c] * dims + offset, sub_dims_ * sizeof(float));
+        }
+        refreshSubspace(s);
+
+        for (int iter = 0; iter < kTrainingIterations; iter++) {
+            std::fill(sums.begin(), sums.end(), 0.0f);
+            std::fill(counts.begin(), counts.end(), 0);
+
+            for (size_t i = 0; i < samples; i++) {
+                const float* sub = data.data() + i * dims + offset;
+                size_t c = nearestCentroid(s, sub);
+                counts[c]++;
+                for (size_t d = 0; d < sub_dims_; d++) {
+                    sums[c * sub_dims_ + d] += sub[d];
+                }
+            }
+
+            for (size_t c = 0; c < kCentroids; c++) {
+                float* cent = centroids_.data() + (s * kCentroids + c) * sub_dims_;
+                if (counts[c] == 0) {
+                    // Reseed empty clusters from a random sample
+                    std::memcpy(cent, data.data() + pick(rng) * dims + offset, sub_dims_ * sizeof(float));
+                    continue;
+                }
+                for (size_t d = 0; d < sub_dims_; d++) {
+                    cent[d] = sums[c * sub_dims_ + d] / counts[c];
+                }
+            }
+            refreshSubspace(s);
+        }
+    }
+
+    return true;
+}
+
+std::string VectorQuantizer::serializeCodebook() const {
+    uint32_t header[2] = {static_cast<uint32_t>(dimensions_), static_cast<uint32_t>(sub_dims_)};
+    std::string out(reinterpret_cast<const char*>(header), sizeof(header));
+    out.append(reinterpret_cast<const char*>(centroids_.data()), centroids_.size() * sizeof(float));
+    return out;
+}
+
+bool VectorQuantizer::loadCodebook(const void* data, size_t size) {
+    uint32_t header[2];
+    if (mode_ != QuantizationMode::PQ || !data || size < sizeof(header)) return false;
+    std::memcpy(header, data, sizeof(header));
+
+    size_t expected = sizeof(header) + subspaces_ * kCentroids * sub_dims_ * sizeof(float);
+    if (header[0] != static_cast<uint32_t>(dimensions_) || header[1] != sub_dims_ || size != expected) {
+        return false;
+    }
+
+    centroids_.resize(subspaces_ * kCentroids * sub_dims_);
+    std::memcpy(centroids_.data(), static_cast<const char*>(data) + sizeof(header),
+                centroids_.size() * sizeof(float));
+
+    columns_.resize(centroids_.size());
+    centroid_norms_.resize(subspaces_ * kCentroids);
+    for (size_t s = 0; s < subspaces_; s++) refreshSubspace(s);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Encoding and scoring
+// ----------------------------------------------------------------------------
+
+void VectorQuantizer::encode(const float* vector, uint8_t* code) const {
+    size_t dims = static_cast<size_t>(dimensions_);
+
+    switch (mode_) {
+        case QuantizationMode::FP16: {
+            for (size_t i = 0; i < dims; i++) {
+                uint16_t half = simd::floatToHalf(vector[i]);
+                std::memcpy(code + i * sizeof(half), &half, sizeof(half));
+            }
+            break;
+        }
+        case QuantizationMode::Int8: {
+            float max_abs = 0.0f;
+            for (size_t i = 0; i < dims; i++) max_abs = std::max(max_abs, std::fabs(vector[i]));
+            float scale = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+            std::memcpy(code, &scale, sizeof(scale));
+
+            int8_t* values = reinterpret_cast<int8_t*>(code + sizeof(scale));
+            for (size_t i = 0; i < dims; i++) {
+                float q = std::nearbyint(vector[i] / scale);
+                values[i] = static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, q)));
+            }
+            break;
+        }
+        case QuantizationMode::PQ: {
+            for (size_t s = 0; s < subspaces_; s++) {
+                code[s] = static_cast<uint8_t>(nearestCentroid(s, vector + s * sub_dims_));
+            }
+            break;
+        }
+        default:
+            std::memcpy(code, vector, dims * sizeof(float));
+            break;
+    }
+}
+
+void VectorQuantizer::decode(const uint8_t* code, float* vector) const {
+    size_t dims = static_cast<size_t>(dimensions_);
+
+    switch (mode_) {
+        case QuantizationMode::FP16: {
+            for (size_t i = 0; i < dims; i++) {
+                uint16_t half;
+                std::memcpy(&half, code + i * sizeof(half), sizeof(half));
+                vector[i] = simd::halfToFloat(half);
+            }
+            break;
+        }
+        case QuantizationMode::Int8: {
+            float scale;
+            std::memcpy(&scale, code, sizeof(scale));
+            const int8_t* values = reinterpret_cast<const int8_t*>(code + sizeof(scale));
+            for (size_t i = 0; i < dims; i++) vector[i] = scale * values[i];
+            break;
+        }
+        case QuantizationMode::PQ: {
+            for (size_t s = 0; s < subspaces_; s++) {
+                std::memcpy(vector + s * sub_dims_, centroid(s, code[s]), sub_dims_ * sizeof(float));
+            }
+            break;
+        }
+        default:
+            std::memcpy(vector, code, dims * sizeof(float));
+            break;
+    }
+}
+
+VectorQuantizer::PreparedQuery VectorQuantizer::prepare(const float* query) const {
+    PreparedQuery prepared;
+    prepared.query.assign(query, query + dimensions_);
+
+    if (mode_ == QuantizationMode::PQ) {
+        // Dot product of each query subvector with every centroid
+        prepared.table.assign(subspaces_ * kCentroids, 0.0f);
+        for (size_t s = 0; s < subspaces_; s++) {
+            dotCentroids(s, query + s * sub_dims_, 1.0f, prepared.table.data() + s * kCentroids);
+        }
+    }
+    return prepared;
+}
+
+void VectorQuantizer::scoreBatch(const PreparedQuery& query, const uint8_t* codes, size_t count,
+                                 size_t stride_bytes, float* out) const {
+    size_t dims = static_cast<size_t>(dimensions_);
+    const float* q = query.query.data();
+
+    switch (mode_) {
+        case QuantizationMode::FP16:
+            for (size_t r = 0; r < count; r++) {
+                out[r] = simd::dotF16(q, reinterpret_cast<const uint16_t*>(codes + r * stride_bytes), dims);
+            }
+            break;
+        case QuantizationMode::Int8:
+            for (size_t r = 0; r < count; r++) {
+                const uint8_t* code = codes + r * stride_bytes;
+                float scale;
+                std::memcpy(&scale, code, sizeof(scale));
+                out[r] = scale * simd::dotI8(q, reinterpret_cast<const int8_t*>(code + sizeof(scale)), dims);
+            }
+            break;
+        case QuantizationMode::PQ: {
+            const float* table = query.table.data();
+            for (size_t r = 0; r < count; r++) {
+                const uint8_t* code = codes + r * stride_bytes;
+                float sum = 0.0f;
+                for (size_t s = 0; s < subspaces_; s++) {
+                    sum += table[s * kCentroids + code[s]];
+                }
+                out[r] = sum;
+            }
+            break;
+        }
+        default:
+            simd::dotBatch(q, reinterpret_cast<const float*>(codes), count, dims,
+                           stride_bytes / sizeof(float), out);
+            break;
+    }
+}
+
+} // namespace casper
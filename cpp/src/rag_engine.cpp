@@ -1,35 +1,272 @@
 #include "rag_engine.h"
 #include "search_client.h"
-#include <fstream>
+#include "config.h"
+#include "utils.h"
+#include "bounded_queue.h"
+#include "text_chunker.h"
+#include "mapped_file.h"
+#include "context_packer.h"
 #include <sstream>
 #include <algorithm>
-#include <regex>
+#include <map>
+#include <set>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <future>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <iostream>
+#include <cstdlib>
 #include <fnmatch.h>
 
 namespace casper {
 
-RAGEngine::RAGEngine() : initialized_(false) {
+// True if path is dir or lies below it
+static bool pathUnder(const std::string& path, const std::string& dir) {
+    if (path.compare(0, dir.size(), dir) != 0) return false;
+    return path.size() == dir.size() || dir.back() == '/' || path[dir.size()] == '/';
+}
+
+// Size and modification time (nanoseconds) of a regular file
+static bool statFile(const std::string& path, int64_t& size, int64_t& mtime) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    size = static_cast<int64_t>(st.st_size);
+#ifdef __APPLE__
+    mtime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+static std::string chunkMetadata(int chunk_index, int total_chunks) {
+    return "{\"chunk_index\":" + std::to_string(chunk_index) +
+           ",\"total_chunks\":" + std::to_string(total_chunks) + "}";
+}
+
+static std::string chunkMetadata(const DocumentChunk& chunk) {
+    return chunkMetadata(chunk.chunk_index, chunk.total_chunks);
+}
+
+// Deterministic chunk ids: a chunk whose text did not change keeps its id
+// (and its stored embedding) across re-indexing. Repeated text within one
+// file gets a numbered suffix, counted in seen.
+static std::string chunkId(const std::string& source, std::string_view content, std::map<std::string, int>& seen) {
+    std::string key = source;
+    key += '\0';
+    key.append(content.data(), content.size());
+    std::string id = utils::hash128Hex(key);
+    int repeat = seen[id]++;
+    if (repeat > 0) id += "-" + std::to_string(repeat);
+    return id;
+}
+
+static TextChunker makeChunker(const RAGConfig& config) {
+    return TextChunker(static_cast<size_t>(std::max(config.chunk_size, 1)),
+                       static_cast<size_t>(std::max(config.chunk_overlap, 0)),
+                       TextChunker::parseStrategy(config.chunk_strategy));
+}
+
+static bool hasExtension(const std::string& path, const std::string& extensions) {
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return false;
+
+    std::string extension = utils::toLower(path.substr(dot));
+    for (const auto& listed : utils::split(extensions, ',')) {
+        if (utils::toLower(utils::trim(listed)) == extension) return true;
+    }
+    return false;
+}
+
+// Leading bytes inspected for binary content
+static const size_t kSniffBytes = 8192;
+
+// One file on its way through the ingestion stages
+struct RAGEngine::IngestItem {
+    Collection* collection;            // Where the file is learned into
+    const RAGConfig& config;           // Settings of the run
+    SourceFile file;
+    const SourceManifest* previous;
+    LearnResult result;
+    bool done = false;                 // Nothing left to embed or store
+    bool touched = false;              // Same content, new stat data: rewrite the manifest only
+    bool streamed = false;             // Over the stream window: chunks stay views into data
+    MappedFile data;
+    std::string_view content;          // All of data, until chunked
+    SourceManifest manifest;
+    std::vector<DocumentChunk> chunks;
+    std::vector<std::string_view> views;  // Chunk text of a streamed file
+    std::vector<size_t> fresh;         // Chunks to embed and store
+    std::vector<size_t> moved;         // Kept chunks at a new position
+    std::vector<std::string> stale;    // Previous chunk ids that are gone
+    std::vector<Embedding> embeddings; // One per fresh chunk
+
+    IngestItem(Collection* target, const RAGConfig& run_config, const SourceFile& source_file,
+               const SourceManifest* previous_manifest)
+        : collection(target)
+        , config(run_config)
+        , file(source_file)
+        , previous(previous_manifest) {
+        result.success = false;
+        result.documents_added = 0;
+        result.chunks_created = 0;
+        result.source = file.path;
+    }
+
+    void fail(const std::string& error) {
+        result.error = error;
+        done = true;
+    }
+
+    void skip(const std::string& reason) {
+        result.files_skipped = 1;
+        fail(reason);
+    }
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsBetween(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// True if path's manifest no longer is the one a file was planned against
+// (previous, nullptr if it was not learned yet)
+bool relearned(VectorDB& db, const std::string& path, const SourceManifest* previous) {
+    SourceManifest current;
+    bool known = db.getManifest(path, current);
+    return known != (previous != nullptr) || (known && current.content_hash != previous->content_hash);
+}
+
+// Worker threads of one pipeline stage. Each pulls a group of items (up to
+// `gather`, without waiting for more than the first), processes the group
+// and pushes it downstream. The downstream queue is closed once the last
+// worker runs out of input.
+template <typename Item>
+class PipelineStage {
+public:
+    using ItemPtr = std::unique_ptr<Item>;
+    using Group = std::vector<ItemPtr>;
+
+    PipelineStage(const std::string& name, const std::string& unit, int workers, size_t gather = 1)
+        : gather_(std::max<size_t>(gather, 1)) {
+        stats_.name = name;
+        stats_.unit = unit;
+        stats_.workers = std::max(1, workers);
+    }
+
+    ~PipelineStage() {
+        join();
+    }
+
+    // pull(item, wait) fetches the next item, blocking only if wait is set;
+    // work(group) returns the units processed
+    template <typename Pull, typename Work>
+    void start(Pull pull, Work work, BoundedQueue<ItemPtr>& out) {
+        remaining_ = stats_.workers;
+        for (int i = 0; i < stats_.workers; i++) {
+            threads_.emplace_back([this, pull, work, &out] {
+                IngestStageStats local;
+                Group group;
+                ItemPtr item;
+                while (pull(item, true)) {
+                    group.push_back(std::move(item));
+                    while (group.size() < gather_ && pull(item, false)) {
+                        group.push_back(std::move(item));
+                    }
+
+                    auto started = Clock::now();
+                    try {
+                        local.units += work(group);
+                    } catch (const std::exception& e) {
+                        for (auto& failed : group) {
+                            failed->fail(std::string("Ingestion failed: ") + e.what());
+                        }
+                    }
+                    auto finished = Clock::now();
+                    local.busy_seconds += secondsBetween(started, finished);
+                    local.files += static_cast<int64_t>(group.size());
+
+                    for (auto& done : group) {
+                        out.push(std::move(done));
+                    }
+                    group.clear();
+                    local.stall_seconds += secondsBetween(finished, Clock::now());
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stats_.files += local.files;
+                    stats_.units += local.units;
+                    stats_.busy_seconds += local.busy_seconds;
+                    stats_.stall_seconds += local.stall_seconds;
+                }
+                if (--remaining_ == 0) out.close();
+            });
+        }
+    }
+
+    void join() {
+        for (auto& thread : threads_) thread.join();
+        threads_.clear();
+    }
+
+    const IngestStageStats& stats() const { return stats_; }
+
+private:
+    size_t gather_;
+    IngestStageStats stats_;
+    std::vector<std::thread> threads_;
+    std::atomic<int> remaining_{0};
+    std::mutex mutex_;
+};
+
+} // namespace
+
+RAGEngine::RAGEngine()
+    : initialized_(false)
+    , query_embeddings_(static_cast<size_t>(config_.query_cache_size))
+    , query_results_(static_cast<size_t>(config_.query_cache_size)) {
 }
 
 RAGEngine::~RAGEngine() {
+    if (watcher_) watcher_->stop();
 }
 
 bool RAGEngine::initialize(const std::string& vector_backend, const std::string& vector_path,
                           const std::string& embedding_provider, const std::string& ollama_host,
                           const std::string& embedding_model) {
+    // The watcher feeds the old database; it is stopped before taking the
+    // lock because its callback may be waiting for it
+    if (watcher_) watcher_->stop();
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    {
+        std::lock_guard<std::mutex> watch_lock(watch_mutex_);
+        watch_patterns_.clear();
+    }
+    collections_.clear();
+    initialized_ = false;
+
     // Initialize embedding client
     embedder_ = std::make_unique<EmbeddingClient>();
     embedder_->setProvider(embedding_provider);
     embedder_->setOllamaHost(ollama_host);
     embedder_->setOllamaModel(embedding_model);
-
-    // Initialize vector database
-    vector_db_ = std::make_unique<VectorDB>();
-    if (!vector_db_->open(vector_backend, vector_path)) {
-        std::cerr << "Failed to open vector database at: " << vector_path << std::endl;
+    applyEmbedderConfig(*embedder_);
+    query_embeddings_.clear();
+    query_results_.clear();
+
+    // Initialize vector database; other collections open on first use
+    vector_backend_ = vector_backend;
+    vector_path_ = vector_path;
+    ollama_host_ = ollama_host;
+    if (!openCollection("")) {
         return false;
     }
 
@@ -37,14 +274,156 @@ bool RAGEngine::initialize(const std::string& vector_backend, const std::string&
     return true;
 }
 
+RAGEngine::Collection* RAGEngine::openCollection(const std::string& name) {
+    std::string key = name.empty() ? VectorDB::kDefaultCollection : name;
+    auto it = collections_.find(key);
+    if (it != collections_.end()) return it->second.get();
+
+    if (!VectorDB::isValidCollectionName(key)) {
+        std::cerr << "Invalid collection name: " << key << std::endl;
+        return nullptr;
+    }
+
+    auto collection = std::make_unique<Collection>();
+    collection->name = key;
+    collection->db = std::make_unique<VectorDB>();
+    collection->db->setOptions(vector_options_);
+    std::string path = VectorDB::collectionPath(vector_backend_, vector_path_, key);
+    if (!collection->db->open(vector_backend_, path)) {
+        std::cerr << "Failed to open vector database at: " << path << std::endl;
+        return nullptr;
+    }
+    assignEmbedder(*collection);
+
+    Collection* opened = collection.get();
+    collections_[key] = std::move(collection);
+    return opened;
+}
+
+void RAGEngine::assignEmbedder(Collection& collection) {
+    // A collection holding chunks of another model keeps embedding with it;
+    // an empty one (or one that never recorded its model) takes the current
+    std::string current = embedder_->getProvider() + "/" + embedder_->getModel();
+    VectorDBStats stats = collection.db->getStats();
+    if (stats.document_count > 0 && !stats.embedding_model.empty() && stats.embedding_model != current) {
+        pinEmbedder(collection, stats.embedding_model);
+        return;
+    }
+
+    // An own embedder is kept; a retrieval may still be using it
+    collection.embedder = embedder_.get();
+    collection.db->setEmbeddingModel(current);
+}
+
+void RAGEngine::pinEmbedder(Collection& collection, const std::string& model) {
+    if (!collection.own_embedder || collection.own_model != model) {
+        collection.own_embedder = std::make_unique<EmbeddingClient>();
+        collection.own_embedder->setOllamaHost(ollama_host_);
+        collection.own_model = model;
+        applyEmbedderConfig(*collection.own_embedder, collection.own_model);
+    }
+    collection.embedder = collection.own_embedder.get();
+}
+
+std::vector<std::string> RAGEngine::listCollections() {
+    if (!initialized_) return {};
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    std::vector<std::string> names = VectorDB::listCollections(vector_backend_, vector_path_);
+    for (const auto& kv : collections_) {
+        names.push_back(kv.first);
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
 void RAGEngine::setConfig(const RAGConfig& config) {
+    if (!config.watch_directories && watcher_) {
+        watcher_->stop();
+        std::lock_guard<std::mutex> watch_lock(watch_mutex_);
+        watch_patterns_.clear();
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
     config_ = config;
+
+    // Thresholds, weights and strategy all shape the results, so cached
+    // ones are dropped; cached query embeddings stay valid
+    size_t capacity = static_cast<size_t>(std::max(config_.query_cache_size, 0));
+    query_embeddings_.setCapacity(capacity);
+    query_results_.setCapacity(capacity);
+    query_results_.clear();
+
+    if (!embedder_) return;
+
+    // Collections filled through the shared embedder keep the model they
+    // were filled with: the ones on it get an embedder of their own when
+    // the new settings change its model or dimensions
+    std::string previous = embedder_->getProvider() + "/" + embedder_->getModel();
+    applyEmbedderConfig(*embedder_);
+    std::string current = embedder_->getProvider() + "/" + embedder_->getModel();
+    for (auto& kv : collections_) {
+        Collection& collection = *kv.second;
+        if (collection.own_embedder) {
+            applyEmbedderConfig(*collection.own_embedder, collection.own_model);
+        }
+        if (collection.embedder != embedder_.get() || current == previous) continue;
+        if (collection.db->getStats().document_count > 0) {
+            pinEmbedder(collection, previous);
+        } else {
+            collection.db->setEmbeddingModel(current);
+        }
+    }
+}
+
+void RAGEngine::applyEmbedderConfig(EmbeddingClient& embedder, const std::string& model) {
+    embedder.setBatchSize(config_.embedding_batch_size);
+    embedder.setConcurrency(config_.embedding_concurrency);
+    embedder.setLocalDimensions(config_.local_embedding_dimensions);
+
+    // "ollama/<model>" or "local/tfidf-<dimensions>", as recorded by the
+    // vector DB
+    if (!model.empty()) {
+        size_t slash = model.find('/');
+        std::string provider = model.substr(0, slash);
+        std::string name = slash == std::string::npos ? "" : model.substr(slash + 1);
+        embedder.setProvider(provider);
+        if (provider == "local") {
+            if (utils::startsWith(name, "tfidf-")) {
+                int dimensions = std::atoi(name.c_str() + 6);
+                if (dimensions > 0) embedder.setLocalDimensions(dimensions);
+            }
+        } else {
+            embedder.setOllamaModel(name);
+        }
+    }
+
+    if (!config_.embedding_cache) {
+        embedder.disableCache();
+        return;
+    }
+
+    std::string path = config_.embedding_cache_path.empty() ?
+        Config::getDefaultEmbeddingCachePath() : config_.embedding_cache_path;
+    int64_t max_bytes = static_cast<int64_t>(config_.embedding_cache_max_mb) * 1024 * 1024;
+    if (!embedder.enableCache(path, max_bytes)) {
+        std::cerr << "Embedding cache disabled: cannot open " << path << std::endl;
+    }
 }
 
 RAGConfig RAGEngine::getConfig() const {
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
     return config_;
 }
 
+void RAGEngine::setVectorDBOptions(const VectorDBOptions& options) {
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    vector_options_ = options;
+    for (auto& kv : collections_) {
+        kv.second->db->setOptions(options);
+    }
+}
+
 bool RAGEngine::isInitialized() const {
     return initialized_;
 }
@@ -62,90 +441,23 @@ std::vector<DocumentChunk> RAGEngine::chunkText(const std::string& text, const s
 
     if (text.empty()) return chunks;
 
-    int chunk_size = config_.chunk_size;
-    int overlap = config_.chunk_overlap;
-
-    // Split into sentences first for better chunk boundaries
-    std::vector<std::string> sentences;
-    std::regex sentence_regex(R"([.!?]+\s+)");
-    std::sregex_token_iterator iter(text.begin(), text.end(), sentence_regex, -1);
-    std::sregex_token_iterator end;
-
-    for (; iter != end; ++iter) {
-        std::string s = iter->str();
-        if (!s.empty()) {
-            sentences.push_back(s);
-        }
-    }
-
-    // If no sentences found, split by newlines
-    if (sentences.empty()) {
-        std::istringstream iss(text);
-        std::string line;
-        while (std::getline(iss, line)) {
-            if (!line.empty()) {
-                sentences.push_back(line);
-            }
-        }
-    }
-
-    // Build chunks from sentences
-    std::string current_chunk;
-    int chunk_index = 0;
-
-    for (const auto& sentence : sentences) {
-        if (current_chunk.length() + sentence.length() > static_cast<size_t>(chunk_size) && !current_chunk.empty()) {
-            // Save current chunk
-            DocumentChunk chunk;
-            chunk.content = current_chunk;
-            chunk.source = source;
-            chunk.chunk_index = chunk_index++;
-            chunks.push_back(chunk);
-
-            // Start new chunk with overlap
-            if (overlap > 0 && current_chunk.length() > static_cast<size_t>(overlap)) {
-                current_chunk = current_chunk.substr(current_chunk.length() - overlap);
-            } else {
-                current_chunk.clear();
-            }
-        }
-
-        if (!current_chunk.empty() && !sentence.empty()) {
-            current_chunk += " ";
-        }
-        current_chunk += sentence;
-    }
+    auto views = makeChunker(config_).split(text);
 
-    // Don't forget the last chunk
-    if (!current_chunk.empty()) {
+    chunks.reserve(views.size());
+    for (size_t i = 0; i < views.size(); i++) {
         DocumentChunk chunk;
-        chunk.content = current_chunk;
+        chunk.content.assign(views[i].data(), views[i].size());
         chunk.source = source;
-        chunk.chunk_index = chunk_index;
-        chunks.push_back(chunk);
-    }
-
-    // Set total chunks count
-    for (auto& chunk : chunks) {
-        chunk.total_chunks = static_cast<int>(chunks.size());
+        chunk.chunk_index = static_cast<int>(i);
+        chunk.total_chunks = static_cast<int>(views.size());
+        chunks.push_back(std::move(chunk));
     }
 
     return chunks;
 }
 
-std::string RAGEngine::readFile(const std::string& path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        return "";
-    }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
-}
-
-std::vector<std::string> RAGEngine::listFiles(const std::string& dir_path, const std::string& pattern) {
-    std::vector<std::string> files;
+std::vector<RAGEngine::SourceFile> RAGEngine::listFiles(const std::string& dir_path, const std::string& pattern) {
+    std::vector<SourceFile> files;
 
     DIR* dir = opendir(dir_path.c_str());
     if (!dir) return files;
@@ -168,7 +480,9 @@ std::vector<std::string> RAGEngine::listFiles(const std::string& dir_path, const
         } else if (S_ISREG(st.st_mode)) {
             // Check pattern match
             if (pattern == "*" || fnmatch(pattern.c_str(), name.c_str(), 0) == 0) {
-                files.push_back(full_path);
+                SourceFile file{full_path, 0, 0};
+                statFile(full_path, file.size, file.mtime);
+                files.push_back(file);
             }
         }
     }
@@ -182,11 +496,14 @@ int RAGEngine::estimateTokens(const std::string& text) {
     return static_cast<int>(text.length() / 4);
 }
 
+static const char* const kContextHeader = "=== Relevant Context ===\n\n";
+static const char* const kContextFooter = "========================\n\n";
+
 std::string RAGEngine::formatContext(const std::vector<VectorSearchResult>& results) {
     if (results.empty()) return "";
 
     std::stringstream ss;
-    ss << "=== Relevant Context ===\n\n";
+    ss << kContextHeader;
 
     for (size_t i = 0; i < results.size(); i++) {
         const auto& res = results[i];
@@ -195,11 +512,11 @@ std::string RAGEngine::formatContext(const std::vector<VectorSearchResult>& resu
         ss << res.document.content << "\n\n";
     }
 
-    ss << "========================\n\n";
+    ss << kContextFooter;
     return ss.str();
 }
 
-LearnResult RAGEngine::learnFile(const std::string& file_path) {
+LearnResult RAGEngine::learnFile(const std::string& file_path, const std::string& collection) {
     LearnResult result;
     result.success = false;
     result.documents_added = 0;
@@ -211,50 +528,334 @@ LearnResult RAGEngine::learnFile(const std::string& file_path) {
         return result;
     }
 
-    // Read file content
-    std::string content = readFile(file_path);
-    if (content.empty()) {
+    SourceFile file{file_path, 0, 0};
+    if (!statFile(file_path, file.size, file.mtime)) {
         result.error = "Could not read file: " + file_path;
         return result;
     }
 
-    // Chunk the content
-    auto chunks = chunkText(content, file_path);
-    if (chunks.empty()) {
-        result.error = "No chunks created from file";
+    std::unique_lock<std::recursive_mutex> lock(index_mutex_);
+    Collection* target = openCollection(collection);
+    if (!target) {
+        result.error = "Cannot open collection: " + collection;
         return result;
     }
+    SourceManifest previous;
+    bool known = target->db->getManifest(file_path, previous);
+    const RAGConfig config = config_;
+    IngestItem item(target, config, file, known ? &previous : nullptr);
+
+    // Reading, chunking and embedding leave the vector DB alone; retrieval
+    // goes on meanwhile, and the file is learned with the settings it
+    // started with
+    lock.unlock();
+    readSource(item);
+    planChunks(item);
+    embedChunks({&item});
+    lock.lock();
+
+    if ((!item.done || item.touched) && relearned(*target->db, file_path, item.previous)) {
+        // The watcher got to it in the meantime: theirs stands
+        item.result.success = true;
+        item.result.files_unchanged = 1;
+        return item.result;
+    }
+    commitSource(item);
+    return item.result;
+}
 
-    // Generate embeddings and store
-    int added = 0;
-    for (size_t i = 0; i < chunks.size(); i++) {
-        const auto& chunk = chunks[i];
+int64_t RAGEngine::readSource(IngestItem& item) {
+    const SourceManifest* previous = item.previous;
 
-        if (progress_callback_) {
-            progress_callback_(file_path, static_cast<int>(i + 1), static_cast<int>(chunks.size()));
+    // Same size and modification time as last run: not even read again
+    if (previous && previous->size == item.file.size && previous->mtime == item.file.mtime) {
+        item.result.success = true;
+        item.result.files_unchanged = 1;
+        item.result.chunks_unchanged = static_cast<int>(previous->chunk_ids.size());
+        item.done = true;
+        return 0;
+    }
+
+    // Policy checks that need no reading
+    const std::string& path = item.file.path;
+    int64_t max_bytes = static_cast<int64_t>(item.config.max_file_mb) * 1024 * 1024;
+    if (max_bytes > 0 && item.file.size > max_bytes) {
+        item.skip("File too large (" + std::to_string(item.file.size / (1024 * 1024)) + " MB): " + path);
+    } else if (hasExtension(path, item.config.skip_extensions)) {
+        item.skip("Excluded file type: " + path);
+    }
+    if (item.done) return 0;
+
+    // Files up to one stream window are read; larger ones are mapped and
+    // their pages read as they are hashed and chunked
+    const size_t window = static_cast<size_t>(std::max(item.config.stream_window_mb, 1)) * 1024 * 1024;
+    if (!item.data.open(path, window + 1) || item.data.size() == 0) {
+        item.fail("Could not read file: " + path);
+        return 0;
+    }
+    item.content = item.data.view();
+    int64_t bytes = static_cast<int64_t>(item.content.size());
+
+    if (item.config.skip_binary && MappedFile::looksBinary(item.content.substr(0, kSniffBytes))) {
+        item.skip("Binary file: " + path);
+        return bytes;
+    }
+    item.streamed = item.data.isMapped();
+
+    SourceManifest& manifest = item.manifest;
+    manifest.source = item.file.path;
+    manifest.size = item.file.size;
+    manifest.mtime = item.file.mtime;
+    manifest.content_hash = utils::hash128Hex(item.content);
+    if (item.data.changed()) {
+        item.fail("File changed while reading: " + path);
+        return bytes;
+    }
+    if (item.streamed) item.data.release(0, item.data.size());
+    manifest.indexed_at = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+
+    // Touched but identical: only the stat data is refreshed
+    if (previous && previous->content_hash == manifest.content_hash) {
+        manifest.chunk_ids = previous->chunk_ids;
+        manifest.indexed_at = previous->indexed_at;
+        item.content = {};
+        item.data.close();
+        item.touched = true;
+        item.done = true;
+        item.result.success = true;
+        item.result.files_unchanged = 1;
+        item.result.chunks_unchanged = static_cast<int>(previous->chunk_ids.size());
+    }
+    return bytes;
+}
+
+int64_t RAGEngine::planChunks(IngestItem& item) {
+    if (item.done) return 0;
+
+    // Chunk the content. Small files are copied out and unmapped; streamed
+    // ones keep views, and the writer copies one window at a time.
+    auto views = makeChunker(item.config).split(item.content);
+    if (item.data.changed()) {
+        item.fail("File changed while reading: " + item.file.path);
+        return 0;
+    }
+    if (views.empty()) {
+        item.fail("No chunks created from file");
+        return 0;
+    }
+
+    std::map<std::string, int> seen;
+    item.manifest.chunk_ids.reserve(views.size());
+    for (const auto& view : views) {
+        item.manifest.chunk_ids.push_back(chunkId(item.file.path, view, seen));
+    }
+
+    if (item.streamed) {
+        item.views = std::move(views);
+        item.data.release(0, item.data.size());
+    } else {
+        item.chunks.reserve(views.size());
+        for (size_t i = 0; i < views.size(); i++) {
+            DocumentChunk chunk;
+            chunk.content.assign(views[i].data(), views[i].size());
+            chunk.source = item.file.path;
+            chunk.chunk_index = static_cast<int>(i);
+            chunk.total_chunks = static_cast<int>(views.size());
+            item.chunks.push_back(std::move(chunk));
         }
+        item.content = {};
+        item.data.close();
+    }
+    size_t total = item.manifest.chunk_ids.size();
 
-        auto emb_result = embedder_->embed(chunk.content);
-        if (!emb_result.success) {
-            std::cerr << "Embedding failed for chunk " << i << ": " << emb_result.error << std::endl;
+    if (!item.collection->db->supportsManifests()) {
+        // No record of what is stored: every chunk is replaced
+        for (size_t i = 0; i < total; i++) {
+            item.fresh.push_back(i);
+        }
+        return static_cast<int64_t>(total);
+    }
+
+    // Previous chunk id -> position
+    std::map<std::string, size_t> stale;
+    size_t previous_total = item.previous ? item.previous->chunk_ids.size() : 0;
+    for (size_t i = 0; i < previous_total; i++) {
+        stale[item.previous->chunk_ids[i]] = i;
+    }
+
+    for (size_t i = 0; i < total; i++) {
+        auto it = stale.find(item.manifest.chunk_ids[i]);
+        if (it == stale.end()) {
+            item.fresh.push_back(i);
             continue;
         }
+        if (it->second != i || previous_total != total) {
+            item.moved.push_back(i);
+        }
+        stale.erase(it);
+        item.result.chunks_unchanged++;
+    }
 
-        std::string metadata = "{\"chunk_index\":" + std::to_string(chunk.chunk_index) +
-                              ",\"total_chunks\":" + std::to_string(chunk.total_chunks) + "}";
+    for (const auto& kv : stale) {
+        item.stale.push_back(kv.first);
+    }
+    return static_cast<int64_t>(total);
+}
 
-        if (vector_db_->add(chunk.content, chunk.source, emb_result.embedding, metadata)) {
-            added++;
+int64_t RAGEngine::embedChunks(const std::vector<IngestItem*>& items) {
+    // One embedBatch across all files, so small files still fill whole
+    // batches and keep several requests in flight
+    std::vector<std::string> texts;
+    for (const IngestItem* item : items) {
+        if (item->done || item->streamed) continue;
+        for (size_t i : item->fresh) {
+            texts.push_back(item->chunks[i].content);
+        }
+    }
+    if (texts.empty()) return 0;
+
+    // A batch comes from one run, so from one collection
+    auto emb_result = items.front()->collection->embedder->embedBatch(texts);
+    if (!emb_result.success || emb_result.embeddings.size() != texts.size()) {
+        std::string error = "Embedding failed: " + emb_result.error;
+        std::cerr << error << std::endl;
+        for (IngestItem* item : items) {
+            if (!item->done && !item->streamed && !item->fresh.empty()) item->fail(error);
         }
+        return 0;
     }
 
-    result.success = added > 0;
-    result.documents_added = 1;
-    result.chunks_created = added;
-    return result;
+    size_t next = 0;
+    for (IngestItem* item : items) {
+        if (item->done || item->streamed) continue;
+        for (size_t k = 0; k < item->fresh.size(); k++) {
+            item->embeddings.push_back(std::move(emb_result.embeddings[next++]));
+        }
+    }
+    return static_cast<int64_t>(texts.size());
+}
+
+int64_t RAGEngine::commitSource(IngestItem& item) {
+    VectorDB& db = *item.collection->db;
+    if (item.touched) {
+        db.putManifest(item.manifest);
+    }
+    // Learned before, excluded by policy now: the old text must not linger
+    if (item.result.files_skipped && item.previous) {
+        forget(item.file.path, item.collection->name);
+    }
+    if (item.done) return 0;
+
+    bool manifests = db.supportsManifests();
+    if (!manifests || !item.previous) {
+        // Without a manifest, stored chunks (older databases, learnText, other
+        // backends) have random ids and cannot be matched
+        db.removeBySource(item.file.path);
+    }
+
+    // Store the new chunks. On failure the previous version stays indexed as
+    // it was (where manifests are supported).
+    int added = 0;
+    if (item.streamed) {
+        added = streamChunks(item, manifests);
+        if (added < 0) return 0;
+    } else if (!item.fresh.empty()) {
+        std::vector<std::string> contents;
+        std::vector<std::string> sources;
+        std::vector<std::string> metadata;
+        std::vector<std::string> ids;
+        for (size_t i : item.fresh) {
+            contents.push_back(item.chunks[i].content);
+            sources.push_back(item.chunks[i].source);
+            metadata.push_back(chunkMetadata(item.chunks[i]));
+            if (manifests) ids.push_back(item.manifest.chunk_ids[i]);
+        }
+        if (!db.addBatch(contents, sources, item.embeddings, metadata, ids)) {
+            item.fail("Failed to store chunks");
+            return 0;
+        }
+        added = static_cast<int>(item.fresh.size());
+    }
+    if (progress_callback_ && !item.streamed) {
+        progress_callback_(item.file.path, added, static_cast<int>(item.fresh.size()));
+    }
+
+    if (manifests) {
+        int total = static_cast<int>(item.manifest.chunk_ids.size());
+        for (size_t i : item.moved) {
+            db.updateMetadata(item.manifest.chunk_ids[i], chunkMetadata(static_cast<int>(i), total));
+        }
+        for (const auto& id : item.stale) {
+            db.remove(id);
+        }
+        db.putManifest(item.manifest);
+    }
+
+    item.result.success = true;
+    item.result.documents_added = 1;
+    item.result.chunks_created = added;
+    return added;
+}
+
+int RAGEngine::streamChunks(IngestItem& item, bool manifests) {
+    const size_t window = static_cast<size_t>(std::max(item.config.stream_window_mb, 1)) * 1024 * 1024;
+    const int total = static_cast<int>(item.views.size());
+    const char* base = item.content.data();
+    VectorDB& db = *item.collection->db;
+
+    std::vector<std::string> stored;
+    int added = 0;
+    size_t next = 0;
+    while (next < item.fresh.size()) {
+        std::vector<std::string> contents;
+        std::vector<std::string> sources;
+        std::vector<std::string> metadata;
+        std::vector<std::string> ids;
+        size_t bytes = 0;
+        size_t end = 0;
+        for (; next < item.fresh.size() && (contents.empty() || bytes < window); next++) {
+            size_t i = item.fresh[next];
+            contents.emplace_back(item.views[i]);
+            sources.push_back(item.file.path);
+            metadata.push_back(chunkMetadata(static_cast<int>(i), total));
+            if (manifests) ids.push_back(item.manifest.chunk_ids[i]);
+            bytes += item.views[i].size();
+            end = static_cast<size_t>(item.views[i].data() + item.views[i].size() - base);
+        }
+
+        // A file that shrank since it was hashed is not stored half old,
+        // half new; the next change event learns it again
+        bool changed = item.data.changed();
+        BatchEmbeddingResult emb_result;
+        emb_result.success = false;
+        if (!changed) emb_result = item.collection->embedder->embedBatch(contents);
+        bool ok = !changed && emb_result.success && emb_result.embeddings.size() == contents.size() &&
+                  db.addBatch(contents, sources, emb_result.embeddings, metadata, ids);
+        if (!ok) {
+            // Take back this run's windows; the previous version stays as it was
+            for (const auto& id : stored) {
+                db.remove(id);
+            }
+            item.fail(changed ? "File changed while reading: " + item.file.path :
+                      emb_result.success ? "Failed to store chunks" : "Embedding failed: " + emb_result.error);
+            return -1;
+        }
+
+        stored.insert(stored.end(), ids.begin(), ids.end());
+        added += static_cast<int>(contents.size());
+        // Nothing before this window is read again
+        item.data.release(0, end);
+        if (progress_callback_) {
+            progress_callback_(item.file.path, added, static_cast<int>(item.fresh.size()));
+        }
+    }
+    return added;
 }
 
-LearnResult RAGEngine::learnDirectory(const std::string& dir_path, const std::string& pattern) {
+LearnResult RAGEngine::learnDirectory(const std::string& dir_path, const std::string& pattern,
+                                      const std::string& collection) {
     LearnResult result;
     result.success = false;
     result.documents_added = 0;
@@ -266,29 +867,153 @@ LearnResult RAGEngine::learnDirectory(const std::string& dir_path, const std::st
         return result;
     }
 
-    auto files = listFiles(dir_path, pattern);
-    if (files.empty()) {
+    // index_mutex_ is only held to read the manifests, for each file's
+    // write and at the end; reading, chunking and embedding run without it,
+    // on the settings the run started with
+    std::unique_lock<std::recursive_mutex> lock(index_mutex_);
+    auto wall_start = Clock::now();
+    Collection* target = openCollection(collection);
+    if (!target) {
+        result.error = "Cannot open collection: " + collection;
+        return result;
+    }
+    VectorDB& db = *target->db;
+    const RAGConfig config = config_;
+
+    std::string root = dir_path;
+    while (root.size() > 1 && root.back() == '/') root.pop_back();
+
+    // Files learned from this directory on earlier runs
+    std::map<std::string, SourceManifest> known;
+    for (auto& manifest : db.listManifests(root == "/" ? root : root + "/")) {
+        known[manifest.source] = std::move(manifest);
+    }
+    lock.unlock();
+
+    auto files = listFiles(root, pattern);
+    if (files.empty() && known.empty()) {
         result.error = "No matching files found in directory";
         return result;
     }
 
-    for (size_t i = 0; i < files.size(); i++) {
-        if (progress_callback_) {
-            progress_callback_(files[i], static_cast<int>(i + 1), static_cast<int>(files.size()));
+    // Reader, chunker and embedder threads hand files along bounded queues,
+    // so at most a few queue depths of files are in memory at once. The
+    // writer runs here, on the only thread that touches the vector DB or
+    // calls the progress callback.
+    using ItemPtr = std::unique_ptr<IngestItem>;
+    size_t depth = static_cast<size_t>(std::max(1, config.ingest_queue_depth));
+    BoundedQueue<ItemPtr> to_chunk(depth);
+    BoundedQueue<ItemPtr> to_embed(depth);
+    BoundedQueue<ItemPtr> to_write(depth);
+
+    int max_workers = static_cast<int>(std::max<size_t>(files.size(), 1));
+    int chunkers = config.ingest_chunkers > 0 ? config.ingest_chunkers :
+        static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    PipelineStage<IngestItem> reader("reader", "bytes", std::min(config.ingest_readers, max_workers));
+    PipelineStage<IngestItem> chunker("chunker", "chunks", std::min(chunkers, max_workers));
+    // The embedder takes whatever files are queued, up to a queue's worth
+    PipelineStage<IngestItem> embedder("embedder", "chunks", std::min(config.ingest_embedders, max_workers), depth);
+
+    std::atomic<size_t> next_file{0};
+    reader.start([&](ItemPtr& item, bool) {
+        size_t i = next_file++;
+        if (i >= files.size()) return false;
+        auto it = known.find(files[i].path);
+        item = std::make_unique<IngestItem>(target, config, files[i], it != known.end() ? &it->second : nullptr);
+        return true;
+    }, [this](std::vector<ItemPtr>& group) {
+        int64_t units = 0;
+        for (auto& item : group) units += readSource(*item);
+        return units;
+    }, to_chunk);
+    chunker.start([&](ItemPtr& item, bool wait) { return wait ? to_chunk.pop(item) : to_chunk.tryPop(item); },
+                  [this](std::vector<ItemPtr>& group) {
+        int64_t units = 0;
+        for (auto& item : group) units += planChunks(*item);
+        return units;
+    }, to_embed);
+    embedder.start([&](ItemPtr& item, bool wait) { return wait ? to_embed.pop(item) : to_embed.tryPop(item); },
+                   [this](std::vector<ItemPtr>& group) {
+        std::vector<IngestItem*> items;
+        for (auto& item : group) items.push_back(item.get());
+        return embedChunks(items);
+    }, to_write);
+
+    IngestStageStats writer;
+    writer.name = "writer";
+    writer.unit = "chunks";
+    writer.workers = 1;
+
+    // One bulk load for the whole directory instead of a commit and an index
+    // update per chunk
+    lock.lock();
+    db.beginBulkLoad();
+    lock.unlock();
+    ItemPtr item;
+    while (to_write.pop(item)) {
+        auto started = Clock::now();
+        lock.lock();
+        try {
+            if ((!item->done || item->touched) && relearned(db, item->file.path, item->previous)) {
+                // The watcher got to it since it was planned: theirs stands
+                item->result.success = true;
+                item->result.files_unchanged = 1;
+            } else {
+                writer.units += commitSource(*item);
+            }
+        } catch (const std::exception& e) {
+            item->fail(std::string("Ingestion failed: ") + e.what());
         }
+        lock.unlock();
+        writer.busy_seconds += secondsBetween(started, Clock::now());
+        writer.files++;
 
-        auto file_result = learnFile(files[i]);
+        const LearnResult& file_result = item->result;
         if (file_result.success) {
-            result.documents_added++;
+            result.documents_added += file_result.documents_added;
             result.chunks_created += file_result.chunks_created;
+            result.chunks_unchanged += file_result.chunks_unchanged;
+            result.files_unchanged += file_result.files_unchanged;
+        }
+        result.files_skipped += file_result.files_skipped;
+        if (progress_callback_) {
+            progress_callback_(item->file.path, static_cast<int>(writer.files), static_cast<int>(files.size()));
         }
+        item.reset();
     }
+    reader.join();
+    chunker.join();
+    embedder.join();
+
+    lock.lock();
+    // Learned before but not found now. Files that still exist (hidden, or
+    // outside this run's pattern) are kept.
+    std::set<std::string> listed;
+    for (const auto& file : files) {
+        listed.insert(file.path);
+    }
+    for (const auto& kv : known) {
+        if (listed.count(kv.first) || utils::fileExists(kv.first)) continue;
+        if (forget(kv.first, target->name)) result.files_removed++;
+    }
+    db.endBulkLoad();
+
+    ingest_stats_.wall_seconds = secondsBetween(wall_start, Clock::now());
+    ingest_stats_.stages = {reader.stats(), chunker.stats(), embedder.stats(), writer};
+
+    result.success = result.documents_added > 0 || result.files_unchanged > 0 || result.files_removed > 0;
+    if (!result.success) {
+        result.error = "No files could be indexed";
+    }
+    lock.unlock();
 
-    result.success = result.documents_added > 0;
+    if (result.success && config.watch_directories) {
+        watchDirectory(root, pattern, collection);
+    }
     return result;
 }
 
-LearnResult RAGEngine::learnText(const std::string& text, const std::string& source) {
+LearnResult RAGEngine::learnText(const std::string& text, const std::string& source, const std::string& collection) {
     LearnResult result;
     result.success = false;
     result.documents_added = 0;
@@ -300,21 +1025,19 @@ LearnResult RAGEngine::learnText(const std::string& text, const std::string& sou
         return result;
     }
 
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    Collection* target = openCollection(collection);
+    if (!target) {
+        result.error = "Cannot open collection: " + collection;
+        return result;
+    }
     auto chunks = chunkText(text, source);
     if (chunks.empty()) {
         result.error = "No chunks created from text";
         return result;
     }
 
-    int added = 0;
-    for (const auto& chunk : chunks) {
-        auto emb_result = embedder_->embed(chunk.content);
-        if (!emb_result.success) continue;
-
-        if (vector_db_->add(chunk.content, chunk.source, emb_result.embedding)) {
-            added++;
-        }
-    }
+    int added = storeChunks(*target, chunks, {}, false, result.error);
 
     result.success = added > 0;
     result.documents_added = 1;
@@ -322,7 +1045,38 @@ LearnResult RAGEngine::learnText(const std::string& text, const std::string& sou
     return result;
 }
 
-LearnResult RAGEngine::learnUrl(const std::string& url) {
+// Embed all chunks of one document through embedBatch (batched, pipelined
+// requests) and store them with a single insertBatch
+int RAGEngine::storeChunks(Collection& collection, const std::vector<DocumentChunk>& chunks,
+                           const std::vector<std::string>& ids, bool chunk_metadata, std::string& error) {
+    std::vector<std::string> contents;
+    std::vector<std::string> sources;
+    std::vector<std::string> metadata;
+    contents.reserve(chunks.size());
+    sources.reserve(chunks.size());
+    for (const auto& chunk : chunks) {
+        contents.push_back(chunk.content);
+        sources.push_back(chunk.source);
+        if (chunk_metadata) {
+            metadata.push_back(chunkMetadata(chunk));
+        }
+    }
+
+    auto emb_result = collection.embedder->embedBatch(contents);
+    if (!emb_result.success) {
+        error = "Embedding failed: " + emb_result.error;
+        std::cerr << error << std::endl;
+        return 0;
+    }
+
+    if (!collection.db->addBatch(contents, sources, emb_result.embeddings, metadata, ids)) {
+        error = "Failed to store chunks";
+        return 0;
+    }
+    return static_cast<int>(chunks.size());
+}
+
+LearnResult RAGEngine::learnUrl(const std::string& url, const std::string& collection) {
     LearnResult result;
     result.success = false;
     result.documents_added = 0;
@@ -344,20 +1098,35 @@ LearnResult RAGEngine::learnUrl(const std::string& url) {
     }
 
     // Learn the page content
-    return learnText(page.content, url);
+    return learnText(page.content, url, collection);
 }
 
-bool RAGEngine::forget(const std::string& source) {
+bool RAGEngine::forget(const std::string& source, const std::string& collection) {
     if (!initialized_) return false;
-    return vector_db_->removeBySource(source);
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    Collection* target = openCollection(collection);
+    if (!target) return false;
+    target->db->removeManifest(source);
+    return target->db->removeBySource(source);
 }
 
-bool RAGEngine::forgetAll() {
+bool RAGEngine::forgetAll(const std::string& collection) {
     if (!initialized_) return false;
-    return vector_db_->clear();
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    Collection* target = openCollection(collection);
+    if (!target || !target->db->clear()) return false;
+    // Empty now, so free to take the configured model again
+    assignEmbedder(*target);
+    return true;
 }
 
-RAGContext RAGEngine::retrieve(const std::string& query, int max_results) {
+RAGContext RAGEngine::retrieve(const std::string& query, int max_results, const SearchFilter& filter,
+                               const std::string& collection) {
+    return retrieveContext(query, max_results, filter, collection, true);
+}
+
+RAGContext RAGEngine::retrieveContext(const std::string& query, int max_results, const SearchFilter& filter,
+                                      const std::string& collection, bool keyword_hits) {
     RAGContext context;
     context.total_tokens_estimate = 0;
 
@@ -365,66 +1134,329 @@ RAGContext RAGEngine::retrieve(const std::string& query, int max_results) {
         return context;
     }
 
+    // Collections stay open once opened, so the pointer outlives the lock
+    Collection* target;
+    {
+        std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+        target = openCollection(collection);
+    }
+    if (!target) return context;
+
     int k = max_results > 0 ? max_results : config_.max_chunks;
 
-    // Generate query embedding
-    auto emb_result = embedder_->embed(query);
-    if (!emb_result.success) {
-        return context;
+    // A repeated query is answered from the cache as long as nothing was
+    // added or removed since; the generation is read before searching so a
+    // change made during the search invalidates what it returns
+    std::string normalized = EmbeddingCache::normalizeText(query);
+    std::ostringstream key;
+    key << target->name << '\x1f' << normalized << '\x1f' << k << '\x1f' << keyword_hits << '\x1f'
+        << filter.source_prefix << '\x1f' << filter.min_timestamp << '\x1f' << filter.max_timestamp;
+    for (const auto& [name, value] : filter.metadata) {
+        key << '\x1f' << name << '\x1e' << value;
     }
 
-    // Search vector database
-    context.results = vector_db_->search(emb_result.embedding, k, static_cast<float>(config_.similarity_threshold));
+    uint64_t generation = target->db->getGeneration();
+    CachedResults cached;
+    if (query_results_.get(key.str(), cached) && cached.generation == generation) {
+        context.results = std::move(cached.results);
+    } else {
+        if (searchIndex(*target, query, k, filter, keyword_hits, context.results)) {
+            query_results_.put(key.str(), CachedResults{generation, context.results});
+        } else if (context.results.empty()) {
+            return context;
+        }
+    }
 
-    // Format context
-    context.formatted_context = formatContext(context.results);
+    // Format the packed passages; the header and footer come out of the budget
+    int budget = 0;
+    if (config_.max_context_tokens > 0) {
+        int frame = estimateTokens(std::string(kContextHeader) + kContextFooter);
+        budget = std::max(config_.max_context_tokens - frame, 1);
+    }
+    ContextPacker packer(budget, config_.mmr_lambda, config_.duplicate_threshold);
+    context.formatted_context = formatContext(packer.pack(context.results));
     context.total_tokens_estimate = estimateTokens(context.formatted_context);
 
     return context;
 }
 
+// Vector search, fused with keyword search when hybrid retrieval is on.
+// Returns false if the query could not be embedded; hybrid results then
+// hold the keyword hits alone and are not worth caching.
+bool RAGEngine::searchIndex(Collection& collection, const std::string& query, int top_k, const SearchFilter& filter,
+                            bool keyword_hits, std::vector<VectorSearchResult>& results) {
+    VectorDB& db = *collection.db;
+
+    // The keyword query runs on its own thread (and connection) while the
+    // query is embedded and searched; each list is fetched deeper than top_k
+    // so fusion can promote documents both of them found
+    bool hybrid = config_.hybrid_search && config_.lexical_weight > 0.0 && db.supportsTextSearch();
+    int depth = hybrid ? std::max(top_k * 4, 20) : top_k;
+    std::future<std::vector<VectorSearchResult>> lexical;
+    if (hybrid) {
+        lexical = std::async(std::launch::async, [&db, &query, depth, &filter] {
+            return db.searchText(query, depth, filter);
+        });
+    }
+
+    // Generate (or reuse) the query embedding and search the vector database.
+    // Collections may embed with different models, so the model is part of
+    // the key.
+    EmbeddingClient* embedder;
+    {
+        std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+        embedder = collection.embedder;
+    }
+    std::string key = embedder->getProvider() + "/" + embedder->getModel() + '\x1f' +
+                      EmbeddingCache::normalizeText(query);
+    Embedding embedding;
+    bool embedded = query_embeddings_.get(key, embedding);
+    if (!embedded) {
+        auto emb_result = embedder->embed(query);
+        embedded = emb_result.success;
+        if (embedded) {
+            embedding = std::move(emb_result.embedding);
+            query_embeddings_.put(key, embedding);
+        }
+    }
+
+    std::vector<VectorSearchResult> semantic;
+    if (embedded) {
+        std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+        semantic = db.search(embedding, depth, static_cast<float>(config_.similarity_threshold), filter);
+    }
+
+    if (hybrid) {
+        results = fuseResults(semantic, lexical.get(), top_k, keyword_hits);
+    } else {
+        results = std::move(semantic);
+    }
+    return embedded;
+}
+
+// Reciprocal rank fusion. Ranks are 1-based, so a document first in both
+// lists scores (vector_weight + lexical_weight) / (fusion_k + 1); scores are
+// divided by that maximum to stay in 0..1. Without keyword_hits, lexical
+// ranks only add to documents the vector search found.
+std::vector<VectorSearchResult> RAGEngine::fuseResults(const std::vector<VectorSearchResult>& semantic,
+                                                       const std::vector<VectorSearchResult>& lexical, int top_k,
+                                                       bool keyword_hits) const {
+    double k = std::max(config_.fusion_k, 0);
+    double vector_weight = std::max(config_.vector_weight, 0.0);
+    double lexical_weight = std::max(config_.lexical_weight, 0.0);
+
+    std::vector<VectorSearchResult> fused;
+    std::vector<double> scores;
+    std::map<std::string, size_t> positions;
+
+    auto add = [&](const std::vector<VectorSearchResult>& list, double weight, bool new_hits) {
+        for (size_t rank = 0; rank < list.size(); rank++) {
+            double score = weight / (k + static_cast<double>(rank + 1));
+            auto it = positions.find(list[rank].document.id);
+            if (it != positions.end()) {
+                scores[it->second] += score;
+                continue;
+            }
+            if (!new_hits) continue;
+            positions[list[rank].document.id] = fused.size();
+            fused.push_back(list[rank]);
+            scores.push_back(score);
+        }
+    };
+    add(semantic, vector_weight, true);
+    add(lexical, lexical_weight, keyword_hits);
+
+    std::vector<size_t> order(fused.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return scores[a] > scores[b]; });
+
+    double best = (vector_weight + lexical_weight) / (k + 1.0);
+    std::vector<VectorSearchResult> results;
+    for (size_t i = 0; i < order.size() && static_cast<int>(results.size()) < top_k; i++) {
+        VectorSearchResult res = std::move(fused[order[i]]);
+        res.score = best > 0.0 ? static_cast<float>(scores[order[i]] / best) : 0.0f;
+        res.distance = 1.0f - res.score;
+        results.push_back(std::move(res));
+    }
+    return results;
+}
+
 std::string RAGEngine::injectContext(const std::string& user_message) {
     if (!config_.auto_context || !initialized_ || !config_.enabled) {
         return user_message;
     }
 
-    auto context = retrieve(user_message);
+    auto context = retrieveContext(user_message, -1, SearchFilter(), "", false);
 
     if (context.results.empty() || context.formatted_context.empty()) {
         return user_message;
     }
 
-    // Limit context size
-    std::string formatted = context.formatted_context;
-    if (context.total_tokens_estimate > config_.max_context_tokens) {
-        // Truncate context
-        int target_chars = config_.max_context_tokens * 4;  // Rough char estimate
-        if (formatted.length() > static_cast<size_t>(target_chars)) {
-            formatted = formatted.substr(0, target_chars) + "\n...(truncated)\n";
-        }
-    }
-
-    return formatted + user_message;
+    // Already packed within max_context_tokens
+    return context.formatted_context + user_message;
 }
 
-std::vector<std::string> RAGEngine::getSources() {
+std::vector<std::string> RAGEngine::getSources(const std::string& collection) {
     std::vector<std::string> sources;
 
     if (!initialized_) return sources;
 
-    auto docs = vector_db_->getStats();
-    // Get all documents and extract unique sources
-    // This is a simplified implementation - could be optimized with a separate sources table
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    Collection* target = openCollection(collection);
+    if (!target) return sources;
+    for (const auto& info : target->db->listSources()) {
+        sources.push_back(info.source);
+    }
+    return sources;
+}
 
-    auto all_docs = vector_db_->getBySource("");  // This won't work, need different approach
+std::vector<SourceInfo> RAGEngine::getSourceInfo(const std::string& prefix, const std::string& collection) {
+    if (!initialized_) return {};
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    Collection* target = openCollection(collection);
+    if (!target) return {};
+    return target->db->listSources(prefix);
+}
 
-    // For now, return empty - would need to implement a sources query in vector_db
-    return sources;
+bool RAGEngine::getSource(const std::string& source, SourceInfo& info, const std::string& collection) {
+    if (!initialized_) return false;
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    Collection* target = openCollection(collection);
+    return target && target->db->getSource(source, info);
 }
 
-VectorDBStats RAGEngine::getStats() {
+VectorDBStats RAGEngine::getStats(const std::string& collection) {
     if (!initialized_) return {};
-    return vector_db_->getStats();
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    Collection* target = openCollection(collection);
+    if (!target) return {};
+    return target->db->getStats();
+}
+
+EmbeddingCacheStats RAGEngine::getEmbeddingCacheStats() {
+    if (!embedder_) return {};
+    std::shared_ptr<EmbeddingCache> cache = embedder_->getCache();
+    return cache ? cache->getStats() : EmbeddingCacheStats();
+}
+
+IngestStats RAGEngine::getIngestStats() const {
+    std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+    return ingest_stats_;
+}
+
+bool RAGEngine::watchDirectory(const std::string& dir_path, const std::string& pattern, const std::string& collection) {
+    if (!initialized_ || !DirectoryWatcher::isSupported()) return false;
+
+    std::string root = dir_path;
+    while (root.size() > 1 && root.back() == '/') root.pop_back();
+    std::string name = collection.empty() ? VectorDB::kDefaultCollection : collection;
+
+    std::lock_guard<std::mutex> watch_lock(watch_mutex_);
+    // Rescans of subdirectories land here too; the enclosing root covers them
+    for (const auto& kv : watch_patterns_) {
+        if (kv.first.first == name && pathUnder(root, kv.first.second)) return true;
+    }
+
+    if (!watcher_) {
+        watcher_ = std::make_unique<DirectoryWatcher>([this](const std::vector<std::string>& paths) {
+            refreshPaths(paths);
+        }, config_.watch_debounce_ms);
+    }
+    if (!watcher_->watch(root)) return false;
+    watch_patterns_[{name, root}] = pattern;
+    return true;
+}
+
+void RAGEngine::unwatchDirectory(const std::string& dir_path, const std::string& collection) {
+    std::string root = dir_path;
+    while (root.size() > 1 && root.back() == '/') root.pop_back();
+    std::string name = collection.empty() ? VectorDB::kDefaultCollection : collection;
+
+    std::lock_guard<std::mutex> watch_lock(watch_mutex_);
+    if (!watch_patterns_.erase({name, root}) || !watcher_) return;
+    // Another collection may still be kept up to date from the same root
+    for (const auto& kv : watch_patterns_) {
+        if (kv.first.second == root) return;
+    }
+    watcher_->unwatch(root);
+}
+
+std::vector<std::string> RAGEngine::getWatchedDirectories() {
+    std::set<std::string> roots;
+    std::lock_guard<std::mutex> watch_lock(watch_mutex_);
+    for (const auto& kv : watch_patterns_) {
+        roots.insert(kv.first.second);
+    }
+    return std::vector<std::string>(roots.begin(), roots.end());
+}
+
+void RAGEngine::refreshPaths(const std::vector<std::string>& paths) {
+    for (const auto& path : paths) {
+        // Per collection, the pattern of the innermost watched root holding
+        // the path (roots sort before the directories below them)
+        std::map<std::string, std::string> patterns;
+        {
+            std::lock_guard<std::mutex> watch_lock(watch_mutex_);
+            for (const auto& kv : watch_patterns_) {
+                if (pathUnder(path, kv.first.second)) {
+                    patterns[kv.first.first] = kv.second;
+                }
+            }
+        }
+
+        for (const auto& [name, pattern] : patterns) {
+            struct stat st;
+            if (stat(path.c_str(), &st) == 0) {
+                if (S_ISDIR(st.st_mode)) {
+                    // New or moved-in directory, or a root after lost events
+                    learnDirectory(path, pattern, name);
+                } else if (S_ISREG(st.st_mode)) {
+                    std::string file = path.substr(path.find_last_of('/') + 1);
+                    if (pattern == "*" || fnmatch(pattern.c_str(), file.c_str(), 0) == 0) {
+                        std::unique_lock<std::recursive_mutex> lock(index_mutex_);
+                        Collection* target = openCollection(name);
+                        lock.unlock();
+                        if (target) refreshFile(*target, path);
+                    }
+                }
+                continue;
+            }
+
+            // Gone: the file itself, or everything learned under a directory
+            std::lock_guard<std::recursive_mutex> lock(index_mutex_);
+            Collection* target = openCollection(name);
+            if (!target) continue;
+            SourceManifest manifest;
+            if (target->db->getManifest(path, manifest)) {
+                forget(path, name);
+            }
+            for (const auto& known : target->db->listManifests(path + "/")) {
+                forget(known.source, name);
+            }
+        }
+    }
+}
+
+void RAGEngine::refreshFile(Collection& collection, const std::string& path) {
+    SourceFile file{path, 0, 0};
+    if (!statFile(path, file.size, file.mtime)) return;
+
+    std::unique_lock<std::recursive_mutex> lock(index_mutex_);
+    SourceManifest previous;
+    bool known = collection.db->getManifest(path, previous);
+    IngestItem item(&collection, config_, file, known ? &previous : nullptr);
+    readSource(item);
+    planChunks(item);
+
+    // Embedding is the slow part; retrieval goes on meanwhile
+    lock.unlock();
+    embedChunks({&item});
+    lock.lock();
+
+    // Re-learned by someone else in the meantime: theirs stands
+    if (relearned(*collection.db, path, known ? &previous : nullptr)) return;
+
+    commitSource(item);
 }
 
 } // namespace casper
@@ -0,0 +1,701 @@
+#include "simd_kernels.h"
+#include <cmath>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CASPER_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define CASPER_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace casper {
+namespace simd {
+
+namespace {
+
+// ============================================================================
+// Scalar reference kernels
+// ============================================================================
+
+float dotScalar(const float* a, const float* b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+float squaredNormScalar(const float* a, size_t n) {
+    return dotScalar(a, a, n);
+}
+
+void dotAndNormsScalar(const float* a, const float* b, size_t n, float& dot, float& norm_a, float& norm_b) {
+    float d = 0.0f, na = 0.0f, nb = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        d += a[i] * b[i];
+        na += a[i] * a[i];
+        nb += b[i] * b[i];
+    }
+    dot = d;
+    norm_a = na;
+    norm_b = nb;
+}
+
+void scaleScalar(float* a, size_t n, float factor) {
+    for (size_t i = 0; i < n; i++) {
+        a[i] *= factor;
+    }
+}
+
+void axpyScalar(float* y, const float* x, size_t n, float a) {
+    for (size_t i = 0; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+float dotF16Scalar(const float* query, const uint16_t* half, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        sum += query[i] * halfToFloat(half[i]);
+    }
+    return sum;
+}
+
+float dotI8Scalar(const float* query, const int8_t* codes, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        sum += query[i] * static_cast<float>(codes[i]);
+    }
+    return sum;
+}
+
+// Kernel table selected at startup
+struct Kernels {
+    const char* name;
+    float (*dot)(const float*, const float*, size_t);
+    float (*squaredNorm)(const float*, size_t);
+    void (*dotAndNorms)(const float*, const float*, size_t, float&, float&, float&);
+    void (*scale)(float*, size_t, float);
+    void (*axpy)(float*, const float*, size_t, float);
+    void (*dotBatch)(const float*, const float*, size_t, size_t, size_t, float*);
+    float (*dotF16)(const float*, const uint16_t*, size_t);
+    float (*dotI8)(const float*, const int8_t*, size_t);
+};
+
+template <float (*Dot)(const float*, const float*, size_t)>
+void dotBatchGeneric(const float* query, const float* rows, size_t count, size_t dims, size_t stride, float* out) {
+    for (size_t r = 0; r < count; r++) {
+        out[r] = Dot(query, rows + r * stride, dims);
+    }
+}
+
+#ifdef CASPER_SIMD_X86
+
+// ============================================================================
+// SSE4.2
+// ============================================================================
+
+__attribute__((target("sse4.2")))
+inline float hsum128(__m128 v) {
+    __m128 shuf = _mm_movehdup_ps(v);
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+__attribute__((target("sse4.2")))
+float dotSSE(const float* a, const float* b, size_t n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float sum = hsum128(_mm_add_ps(acc0, acc1));
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+__attribute__((target("sse4.2")))
+float squaredNormSSE(const float* a, size_t n) {
+    return dotSSE(a, a, n);
+}
+
+__attribute__((target("sse4.2")))
+void dotAndNormsSSE(const float* a, const float* b, size_t n, float& dot, float& norm_a, float& norm_b) {
+    __m128 d = _mm_setzero_ps();
+    __m128 na = _mm_setzero_ps();
+    __m128 nb = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        d = _mm_add_ps(d, _mm_mul_ps(va, vb));
+        na = _mm_add_ps(na, _mm_mul_ps(va, va));
+        nb = _mm_add_ps(nb, _mm_mul_ps(vb, vb));
+    }
+    dot = hsum128(d);
+    norm_a = hsum128(na);
+    norm_b = hsum128(nb);
+    for (; i < n; i++) {
+        dot += a[i] * b[i];
+        norm_a += a[i] * a[i];
+        norm_b += b[i] * b[i];
+    }
+}
+
+__attribute__((target("sse4.2")))
+void scaleSSE(float* a, size_t n, float factor) {
+    __m128 f = _mm_set1_ps(factor);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(a + i, _mm_mul_ps(_mm_loadu_ps(a + i), f));
+    }
+    for (; i < n; i++) {
+        a[i] *= factor;
+    }
+}
+
+__attribute__((target("sse4.2")))
+void axpySSE(float* y, const float* x, size_t n, float a) {
+    __m128 f = _mm_set1_ps(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(x + i), f)));
+    }
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+// ============================================================================
+// AVX2 + FMA
+// ============================================================================
+
+__attribute__((target("avx2,fma")))
+inline float hsum256(__m256 v) {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    __m128 shuf = _mm_movehdup_ps(lo);
+    __m128 sums = _mm_add_ps(lo, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+__attribute__((target("avx2,fma")))
+float dotAVX2(const float* a, const float* b, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    float sum = hsum256(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+float squaredNormAVX2(const float* a, size_t n) {
+    return dotAVX2(a, a, n);
+}
+
+__attribute__((target("avx2,fma")))
+void dotAndNormsAVX2(const float* a, const float* b, size_t n, float& dot, float& norm_a, float& norm_b) {
+    __m256 d = _mm256_setzero_ps();
+    __m256 na = _mm256_setzero_ps();
+    __m256 nb = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 va = _mm256_loadu_ps(a + i);
+        __m256 vb = _mm256_loadu_ps(b + i);
+        d = _mm256_fmadd_ps(va, vb, d);
+        na = _mm256_fmadd_ps(va, va, na);
+        nb = _mm256_fmadd_ps(vb, vb, nb);
+    }
+    dot = hsum256(d);
+    norm_a = hsum256(na);
+    norm_b = hsum256(nb);
+    for (; i < n; i++) {
+        dot += a[i] * b[i];
+        norm_a += a[i] * a[i];
+        norm_b += b[i] * b[i];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void scaleAVX2(float* a, size_t n, float factor) {
+    __m256 f = _mm256_set1_ps(factor);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(a + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), f));
+    }
+    for (; i < n; i++) {
+        a[i] *= factor;
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void axpyAVX2(float* y, const float* x, size_t n, float a) {
+    __m256 f = _mm256_set1_ps(a);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(_mm256_loadu_ps(x + i), f, _mm256_loadu_ps(y + i)));
+    }
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+// Four rows per pass so each query load is reused four times
+__attribute__((target("avx2,fma")))
+void dotBatchAVX2(const float* query, const float* rows, size_t count, size_t dims, size_t stride, float* out) {
+    size_t r = 0;
+    for (; r + 4 <= count; r += 4) {
+        const float* r0 = rows + r * stride;
+        const float* r1 = r0 + stride;
+        const float* r2 = r1 + stride;
+        const float* r3 = r2 + stride;
+
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= dims; i += 8) {
+            __m256 q = _mm256_loadu_ps(query + i);
+            acc0 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r0 + i), acc0);
+            acc1 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r1 + i), acc1);
+            acc2 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r2 + i), acc2);
+            acc3 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r3 + i), acc3);
+        }
+        float s0 = hsum256(acc0), s1 = hsum256(acc1), s2 = hsum256(acc2), s3 = hsum256(acc3);
+        for (; i < dims; i++) {
+            s0 += query[i] * r0[i];
+            s1 += query[i] * r1[i];
+            s2 += query[i] * r2[i];
+            s3 += query[i] * r3[i];
+        }
+        out[r] = s0;
+        out[r + 1] = s1;
+        out[r + 2] = s2;
+        out[r + 3] = s3;
+    }
+    for (; r < count; r++) {
+        out[r] = dotAVX2(query, rows + r * stride, dims);
+    }
+}
+
+__attribute__((target("avx2,fma,f16c")))
+float dotF16AVX2(const float* query, const uint16_t* half, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 h0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(half + i)));
+        __m256 h1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(half + i + 8)));
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), h0, acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i + 8), h1, acc1);
+    }
+    if (i < n) {
+        // Zero-padded tail, converted in-register as well
+        alignas(32) uint16_t half_tail[16] = {0};
+        alignas(32) float query_tail[16] = {0};
+        std::memcpy(half_tail, half + i, (n - i) * sizeof(uint16_t));
+        std::memcpy(query_tail, query + i, (n - i) * sizeof(float));
+        __m256 h0 = _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(half_tail)));
+        __m256 h1 = _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(half_tail + 8)));
+        acc0 = _mm256_fmadd_ps(_mm256_load_ps(query_tail), h0, acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_load_ps(query_tail + 8), h1, acc1);
+    }
+    return hsum256(_mm256_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx2,fma")))
+float dotI8AVX2(const float* query, const int8_t* codes, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+        __m256 c0 = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(bytes));
+        __m256 c1 = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(bytes, 8)));
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), c0, acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i + 8), c1, acc1);
+    }
+    float sum = hsum256(_mm256_add_ps(acc0, acc1));
+    for (; i < n; i++) {
+        sum += query[i] * static_cast<float>(codes[i]);
+    }
+    return sum;
+}
+
+// ============================================================================
+// AVX-512F
+// ============================================================================
+
+// Horizontal sum through memory; GCC's _mm512_reduce_add_ps trips
+// -Wuninitialized inside its own header
+__attribute__((target("avx512f")))
+inline float hsum512(__m512 v) {
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, v);
+    float sum = 0.0f;
+    for (float lane : lanes) sum += lane;
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+float dotAVX512(const float* a, const float* b, size_t n) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+    }
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+    }
+    if (i < n) {
+        __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), acc1);
+    }
+    return hsum512(_mm512_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+float squaredNormAVX512(const float* a, size_t n) {
+    return dotAVX512(a, a, n);
+}
+
+__attribute__((target("avx512f")))
+void dotAndNormsAVX512(const float* a, const float* b, size_t n, float& dot, float& norm_a, float& norm_b) {
+    __m512 d = _mm512_setzero_ps();
+    __m512 na = _mm512_setzero_ps();
+    __m512 nb = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 va = _mm512_loadu_ps(a + i);
+        __m512 vb = _mm512_loadu_ps(b + i);
+        d = _mm512_fmadd_ps(va, vb, d);
+        na = _mm512_fmadd_ps(va, va, na);
+        nb = _mm512_fmadd_ps(vb, vb, nb);
+    }
+    if (i < n) {
+        __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512 va = _mm512_maskz_loadu_ps(mask, a + i);
+        __m512 vb = _mm512_maskz_loadu_ps(mask, b + i);
+        d = _mm512_fmadd_ps(va, vb, d);
+        na = _mm512_fmadd_ps(va, va, na);
+        nb = _mm512_fmadd_ps(vb, vb, nb);
+    }
+    dot = hsum512(d);
+    norm_a = hsum512(na);
+    norm_b = hsum512(nb);
+}
+
+__attribute__((target("avx512f")))
+void scaleAVX512(float* a, size_t n, float factor) {
+    __m512 f = _mm512_set1_ps(factor);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(a + i, _mm512_mul_ps(_mm512_loadu_ps(a + i), f));
+    }
+    for (; i < n; i++) {
+        a[i] *= factor;
+    }
+}
+
+__attribute__((target("avx512f")))
+void axpyAVX512(float* y, const float* x, size_t n, float a) {
+    __m512 f = _mm512_set1_ps(a);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(y + i, _mm512_fmadd_ps(_mm512_loadu_ps(x + i), f, _mm512_loadu_ps(y + i)));
+    }
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+__attribute__((target("avx512f")))
+void dotBatchAVX512(const float* query, const float* rows, size_t count, size_t dims, size_t stride, float* out) {
+    size_t r = 0;
+    size_t full = dims / 16 * 16;
+    __mmask16 tail = static_cast<__mmask16>((1u << (dims - full)) - 1);
+
+    for (; r + 4 <= count; r += 4) {
+        const float* r0 = rows + r * stride;
+        const float* r1 = r0 + stride;
+        const float* r2 = r1 + stride;
+        const float* r3 = r2 + stride;
+
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps();
+        __m512 acc3 = _mm512_setzero_ps();
+        for (size_t i = 0; i < full; i += 16) {
+            __m512 q = _mm512_loadu_ps(query + i);
+            acc0 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r0 + i), acc0);
+            acc1 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r1 + i), acc1);
+            acc2 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r2 + i), acc2);
+            acc3 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r3 + i), acc3);
+        }
+        if (tail) {
+            __m512 q = _mm512_maskz_loadu_ps(tail, query + full);
+            acc0 = _mm512_fmadd_ps(q, _mm512_maskz_loadu_ps(tail, r0 + full), acc0);
+            acc1 = _mm512_fmadd_ps(q, _mm512_maskz_loadu_ps(tail, r1 + full), acc1);
+            acc2 = _mm512_fmadd_ps(q, _mm512_maskz_loadu_ps(tail, r2 + full), acc2);
+            acc3 = _mm512_fmadd_ps(q, _mm512_maskz_loadu_ps(tail, r3 + full), acc3);
+        }
+        out[r] = hsum512(acc0);
+        out[r + 1] = hsum512(acc1);
+        out[r + 2] = hsum512(acc2);
+        out[r + 3] = hsum512(acc3);
+    }
+    for (; r < count; r++) {
+        out[r] = dotAVX512(query, rows + r * stride, dims);
+    }
+}
+
+#endif // CASPER_SIMD_X86
+
+#ifdef CASPER_SIMD_NEON
+
+// ============================================================================
+// NEON (always available on AArch64)
+// ============================================================================
+
+float dotNEON(const float* a, const float* b, size_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+float squaredNormNEON(const float* a, size_t n) {
+    return dotNEON(a, a, n);
+}
+
+void dotAndNormsNEON(const float* a, const float* b, size_t n, float& dot, float& norm_a, float& norm_b) {
+    float32x4_t d = vdupq_n_f32(0.0f);
+    float32x4_t na = vdupq_n_f32(0.0f);
+    float32x4_t nb = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t va = vld1q_f32(a + i);
+        float32x4_t vb = vld1q_f32(b + i);
+        d = vfmaq_f32(d, va, vb);
+        na = vfmaq_f32(na, va, va);
+        nb = vfmaq_f32(nb, vb, vb);
+    }
+    dot = vaddvq_f32(d);
+    norm_a = vaddvq_f32(na);
+    norm_b = vaddvq_f32(nb);
+    for (; i < n; i++) {
+        dot += a[i] * b[i];
+        norm_a += a[i] * a[i];
+        norm_b += b[i] * b[i];
+    }
+}
+
+void scaleNEON(float* a, size_t n, float factor) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(a + i, vmulq_n_f32(vld1q_f32(a + i), factor));
+    }
+    for (; i < n; i++) {
+        a[i] *= factor;
+    }
+}
+
+void axpyNEON(float* y, const float* x, size_t n, float a) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(y + i, vmlaq_n_f32(vld1q_f32(y + i), vld1q_f32(x + i), a));
+    }
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+#endif // CASPER_SIMD_NEON
+
+Kernels selectKernels() {
+#ifdef CASPER_SIMD_X86
+    __builtin_cpu_init();
+    bool f16c = __builtin_cpu_supports("f16c");
+    if (__builtin_cpu_supports("avx512f")) {
+        return {"avx512", dotAVX512, squaredNormAVX512, dotAndNormsAVX512, scaleAVX512, axpyAVX512, dotBatchAVX512,
+                f16c ? dotF16AVX2 : dotF16Scalar, dotI8AVX2};
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return {"avx2", dotAVX2, squaredNormAVX2, dotAndNormsAVX2, scaleAVX2, axpyAVX2, dotBatchAVX2,
+                f16c ? dotF16AVX2 : dotF16Scalar, dotI8AVX2};
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return {"sse4.2", dotSSE, squaredNormSSE, dotAndNormsSSE, scaleSSE, axpySSE, dotBatchGeneric<dotSSE>,
+                dotF16Scalar, dotI8Scalar};
+    }
+#endif
+#ifdef CASPER_SIMD_NEON
+    return {"neon", dotNEON, squaredNormNEON, dotAndNormsNEON, scaleNEON, axpyNEON, dotBatchGeneric<dotNEON>,
+            dotF16Scalar, dotI8Scalar};
+#else
+    return {"scalar", dotScalar, squaredNormScalar, dotAndNormsScalar, scaleScalar, axpyScalar, dotBatchGeneric<dotScalar>,
+            dotF16Scalar, dotI8Scalar};
+#endif
+}
+
+const Kernels& kernels() {
+    static const Kernels selected = selectKernels();
+    return selected;
+}
+
+} // namespace
+
+const char* activeKernel() {
+    return kernels().name;
+}
+
+float dot(const float* a, const float* b, size_t n) {
+    return kernels().dot(a, b, n);
+}
+
+float squaredNorm(const float* a, size_t n) {
+    return kernels().squaredNorm(a, n);
+}
+
+void dotAndNorms(const float* a, const float* b, size_t n, float& dot, float& norm_a, float& norm_b) {
+    kernels().dotAndNorms(a, b, n, dot, norm_a, norm_b);
+}
+
+void scale(float* a, size_t n, float factor) {
+    kernels().scale(a, n, factor);
+}
+
+void axpy(float* y, const float* x, size_t n, float a) {
+    kernels().axpy(y, x, n, a);
+}
+
+void dotBatch(const float* query, const float* rows, size_t count, size_t dims, size_t stride, float* out) {
+    kernels().dotBatch(query, rows, count, dims, stride, out);
+}
+
+float dotF16(const float* query, const uint16_t* half, size_t n) {
+    return kernels().dotF16(query, half, n);
+}
+
+float dotI8(const float* query, const int8_t* codes, size_t n) {
+    return kernels().dotI8(query, codes, n);
+}
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t exponent = (bits >> 23) & 0xFFu;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (exponent == 0xFFu) {
+        // Inf / NaN
+        return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    }
+
+    int32_t half_exp = static_cast<int32_t>(exponent) - 127 + 15;
+    if (half_exp >= 0x1F) {
+        return static_cast<uint16_t>(sign | 0x7C00u);  // Overflow to infinity
+    }
+    if (half_exp <= 0) {
+        // Subnormal or zero
+        if (half_exp < -10) return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000u;
+        uint32_t shift = static_cast<uint32_t>(14 - half_exp);
+        uint32_t half_mant = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half_mant & 1u))) half_mant++;
+        return static_cast<uint16_t>(sign | half_mant);
+    }
+
+    uint32_t half = sign | (static_cast<uint32_t>(half_exp) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) half++;  // May carry into exponent
+    return static_cast<uint16_t>(half);
+}
+
+float halfToFloat(uint16_t value) {
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1Fu;
+    uint32_t mantissa = value & 0x3FFu;
+    uint32_t bits;
+
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // Renormalize subnormal
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            mantissa &= 0x3FFu;
+            bits = sign | (exponent << 23) | (mantissa << 13);
+        }
+    } else if (exponent == 0x1F) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void cosineBatch(const float* query, const float* rows, size_t count, size_t dims, size_t stride, float* out) {
+    const Kernels& k = kernels();
+    float query_norm = std::sqrt(k.squaredNorm(query, dims));
+    if (query_norm == 0.0f) {
+        for (size_t r = 0; r < count; r++) out[r] = 0.0f;
+        return;
+    }
+
+    k.dotBatch(query, rows, count, dims, stride, out);
+    for (size_t r = 0; r < count; r++) {
+        float row_norm = std::sqrt(k.squaredNorm(rows + r * stride, dims));
+        out[r] = row_norm == 0.0f ? 0.0f : out[r] / (query_norm * row_norm);
+    }
+}
+
+} // namespace simd
+} // namespace casper
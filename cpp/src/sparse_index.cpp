@@ -0,0 +1,282 @@
+#include "sparse_index.h"
+#include "top_k.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace casper {
+
+namespace {
+
+// Quiet NaN with a payload, in place of the first float of a dense embedding
+const uint32_t kSerializedMarker = 0x7FC05350u;
+
+const uint32_t kNoDocument = std::numeric_limits<uint32_t>::max();
+
+} // namespace
+
+SparseIndex::SparseIndex()
+    : dimensions_(0)
+    , entries_(0) {
+}
+
+void SparseIndex::reset(int dimensions) {
+    dimensions_ = dimensions;
+    ids_.clear();
+    numbers_.clear();
+    postings_.clear();
+    entries_ = 0;
+}
+
+bool SparseIndex::upsert(const std::string& id, const SparseVector& vector, int dimensions) {
+    if (dimensions <= 0) return false;
+    if (dimensions_ == 0) dimensions_ = dimensions;
+    if (dimensions != dimensions_) return false;
+    for (const auto& entry : vector) {
+        if (entry.first >= static_cast<uint32_t>(dimensions_)) return false;
+    }
+
+    remove(id);
+    if (ids_.size() >= kNoDocument) compact();
+
+    uint32_t doc = static_cast<uint32_t>(ids_.size());
+    ids_.push_back(id);
+    numbers_[id] = doc;
+
+    for (const auto& [dim, value] : vector) {
+        PostingList& list = postings_[dim];
+        if (list.docs.empty()) {
+            list.max_value = list.min_value = value;
+        } else {
+            list.max_value = std::max(list.max_value, value);
+            list.min_value = std::min(list.min_value, value);
+        }
+        list.docs.push_back(doc);
+        list.values.push_back(value);
+    }
+    entries_ += vector.size();
+    return true;
+}
+
+bool SparseIndex::remove(const std::string& id) {
+    auto it = numbers_.find(id);
+    if (it == numbers_.end()) return false;
+    ids_[it->second].clear();
+    numbers_.erase(it);
+
+    if (numbers_.empty()) {
+        reset(dimensions_);
+    } else if (ids_.size() - numbers_.size() > numbers_.size()) {
+        compact();
+    }
+    return true;
+}
+
+// Renumbers the live documents in order, so every list stays sorted
+void SparseIndex::compact() {
+    std::vector<uint32_t> renumber(ids_.size(), kNoDocument);
+    std::vector<std::string> live;
+    live.reserve(numbers_.size());
+    for (size_t doc = 0; doc < ids_.size(); doc++) {
+        if (ids_[doc].empty()) continue;
+        renumber[doc] = static_cast<uint32_t>(live.size());
+        live.push_back(std::move(ids_[doc]));
+    }
+
+    entries_ = 0;
+    for (auto it = postings_.begin(); it != postings_.end();) {
+        PostingList& list = it->second;
+        size_t kept = 0;
+        for (size_t i = 0; i < list.docs.size(); i++) {
+            uint32_t doc = renumber[list.docs[i]];
+            if (doc == kNoDocument) continue;
+            list.docs[kept] = doc;
+            list.values[kept] = list.values[i];
+            kept++;
+        }
+        if (kept == 0) {
+            it = postings_.erase(it);
+            continue;
+        }
+
+        list.docs.resize(kept);
+        list.values.resize(kept);
+        list.docs.shrink_to_fit();
+        list.values.shrink_to_fit();
+        auto range = std::minmax_element(list.values.begin(), list.values.end());
+        list.min_value = *range.first;
+        list.max_value = *range.second;
+        entries_ += kept;
+        ++it;
+    }
+
+    ids_ = std::move(live);
+    for (size_t doc = 0; doc < ids_.size(); doc++) {
+        numbers_[ids_[doc]] = static_cast<uint32_t>(doc);
+    }
+}
+
+std::vector<std::pair<float, std::string>> SparseIndex::search(const SparseVector& query, size_t k, float threshold,
+                                                               const std::vector<std::string>* allowed) const {
+    std::vector<std::pair<float, std::string>> results;
+    if (k == 0 || numbers_.empty()) return results;
+
+    std::vector<char> mask;
+    if (allowed) {
+        mask.assign(ids_.size(), 0);
+        for (const auto& id : *allowed) {
+            auto it = numbers_.find(id);
+            if (it != numbers_.end()) mask[it->second] = 1;
+        }
+    }
+
+    // One cursor per query dimension that has postings. A dimension adds at
+    // most bound to any score; never less than nothing, since a document
+    // without it gets 0 from it.
+    struct Cursor {
+        const PostingList* list;
+        float weight;
+        float bound;
+        size_t pos;
+    };
+    std::vector<Cursor> cursors;
+    cursors.reserve(query.size());
+    for (const auto& [dim, weight] : query) {
+        if (weight == 0.0f) continue;
+        auto it = postings_.find(dim);
+        if (it == postings_.end()) continue;
+        const PostingList& list = it->second;
+        float bound = std::max({weight * list.max_value, weight * list.min_value, 0.0f});
+        cursors.push_back({&list, weight, bound, 0});
+    }
+    if (cursors.empty()) return results;
+
+    std::sort(cursors.begin(), cursors.end(), [](const Cursor& a, const Cursor& b) { return a.bound < b.bound; });
+    const size_t count = cursors.size();
+    std::vector<float> reach(count);  // reach[i]: most cursors[0..i] add together
+    float sum = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        sum += cursors[i].bound;
+        reach[i] = sum;
+    }
+
+    // cursors[essential..] drive the traversal; the ones below it cannot
+    // reach the current bound on their own
+    TopKSelector top(k, threshold);
+    size_t essential = 0;
+    auto raiseEssential = [&] {
+        while (essential < count && reach[essential] < top.bound()) essential++;
+    };
+    raiseEssential();
+
+    while (essential < count) {
+        uint32_t doc = kNoDocument;
+        for (size_t i = essential; i < count; i++) {
+            const Cursor& cursor = cursors[i];
+            if (cursor.pos < cursor.list->docs.size()) doc = std::min(doc, cursor.list->docs[cursor.pos]);
+        }
+        if (doc == kNoDocument) break;
+
+        bool live = !ids_[doc].empty() && (!allowed || mask[doc]);
+        float score = 0.0f;
+        for (size_t i = essential; i < count; i++) {
+            Cursor& cursor = cursors[i];
+            if (cursor.pos < cursor.list->docs.size() && cursor.list->docs[cursor.pos] == doc) {
+                score += cursor.weight * cursor.list->values[cursor.pos];
+                cursor.pos++;
+            }
+        }
+        if (!live) continue;
+
+        // Probe the other dimensions, largest bound first, for as long as
+        // the document can still make it
+        bool pruned = false;
+        for (size_t i = essential; i-- > 0;) {
+            if (score + reach[i] < top.bound()) {
+                pruned = true;
+                break;
+            }
+            Cursor& cursor = cursors[i];
+            const auto& docs = cursor.list->docs;
+            cursor.pos = static_cast<size_t>(std::lower_bound(docs.begin() + cursor.pos, docs.end(), doc) - docs.begin());
+            if (cursor.pos < docs.size() && docs[cursor.pos] == doc) {
+                score += cursor.weight * cursor.list->values[cursor.pos];
+            }
+        }
+        if (!pruned && top.push(score, doc)) raiseEssential();
+    }
+
+    for (const auto& hit : top.take()) {
+        results.emplace_back(hit.first, ids_[hit.second]);
+    }
+    return results;
+}
+
+size_t SparseIndex::memoryBytes() const {
+    size_t bytes = entries_ * (sizeof(uint32_t) + sizeof(float)) + postings_.size() * sizeof(PostingList);
+    for (const auto& id : ids_) bytes += sizeof(std::string) + id.capacity();
+    return bytes;
+}
+
+SparseVector SparseIndex::fromDense(const float* values, size_t count) {
+    SparseVector vector;
+    for (size_t i = 0; i < count; i++) {
+        if (values[i] != 0.0f) vector.emplace_back(static_cast<uint32_t>(i), values[i]);
+    }
+    return vector;
+}
+
+std::string SparseIndex::serialize(const SparseVector& vector, int dimensions) {
+    const size_t count = vector.size();
+    std::string data((2 + 2 * count) * sizeof(uint32_t), '\0');
+    char* out = &data[0];
+
+    uint32_t header[2] = {kSerializedMarker, static_cast<uint32_t>(dimensions)};
+    std::memcpy(out, header, sizeof(header));
+    out += sizeof(header);
+    for (const auto& entry : vector) {
+        std::memcpy(out, &entry.first, sizeof(uint32_t));
+        out += sizeof(uint32_t);
+    }
+    for (const auto& entry : vector) {
+        std::memcpy(out, &entry.second, sizeof(float));
+        out += sizeof(float);
+    }
+    return data;
+}
+
+bool SparseIndex::isSerialized(const void* data, size_t size) {
+    if (!data || size < 2 * sizeof(uint32_t) || size % (2 * sizeof(uint32_t)) != 0) return false;
+    uint32_t marker;
+    std::memcpy(&marker, data, sizeof(marker));
+    return marker == kSerializedMarker;
+}
+
+bool SparseIndex::deserialize(const void* data, size_t size, SparseVector& vector, int& dimensions) {
+    if (!isSerialized(data, size)) return false;
+    const char* in = static_cast<const char*>(data);
+
+    uint32_t header[2];
+    std::memcpy(header, in, sizeof(header));
+    dimensions = static_cast<int>(header[1]);
+
+    size_t count = (size - sizeof(header)) / (2 * sizeof(uint32_t));
+    const char* dims = in + sizeof(header);
+    const char* values = dims + count * sizeof(uint32_t);
+    vector.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        std::memcpy(&vector[i].first, dims + i * sizeof(uint32_t), sizeof(uint32_t));
+        std::memcpy(&vector[i].second, values + i * sizeof(float), sizeof(float));
+    }
+    return true;
+}
+
+Embedding SparseIndex::toDense(const SparseVector& vector, int dimensions) {
+    Embedding embedding(static_cast<size_t>(std::max(dimensions, 0)), 0.0f);
+    for (const auto& [dim, value] : vector) {
+        if (dim < embedding.size()) embedding[dim] = value;
+    }
+    return embedding;
+}
+
+} // namespace casper
@@ -0,0 +1,154 @@
+#include "text_chunker.h"
+#include <algorithm>
+
+namespace casper {
+
+namespace {
+
+// A whitespace run can end several kinds of unit at once (".\n\n" ends a
+// sentence, a line and a paragraph), so breaks are tracked per kind
+enum BreakKind { kWord, kSentence, kLine, kParagraph, kBreakKinds };
+
+const size_t kNone = static_cast<size_t>(-1);
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+inline bool isContinuationByte(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// Kinds a strategy prefers to cut at, and what it falls back to first
+struct Ranking {
+    unsigned preferred;
+    unsigned fallback;
+};
+
+Ranking rankingFor(ChunkStrategy strategy) {
+    switch (strategy) {
+        case ChunkStrategy::Paragraph:
+            return {1u << kParagraph, (1u << kSentence) | (1u << kLine)};
+        case ChunkStrategy::Line:
+            return {(1u << kLine) | (1u << kParagraph), 1u << kSentence};
+        default:
+            return {(1u << kSentence) | (1u << kParagraph), 1u << kLine};
+    }
+}
+
+} // namespace
+
+TextChunker::TextChunker(size_t chunk_size, size_t overlap, ChunkStrategy strategy)
+    : chunk_size_(std::max<size_t>(chunk_size, 1))
+    , overlap_(std::min(overlap, chunk_size_ / 2))
+    , strategy_(strategy) {
+}
+
+ChunkStrategy TextChunker::parseStrategy(const std::string& name) {
+    if (name == "paragraph") return ChunkStrategy::Paragraph;
+    if (name == "line") return ChunkStrategy::Line;
+    return ChunkStrategy::Sentence;
+}
+
+std::string TextChunker::strategyName(ChunkStrategy strategy) {
+    switch (strategy) {
+        case ChunkStrategy::Paragraph: return "paragraph";
+        case ChunkStrategy::Line: return "line";
+        default: return "sentence";
+    }
+}
+
+std::vector<std::string_view> TextChunker::split(std::string_view text) const {
+    std::vector<std::string_view> chunks;
+    const size_t n = text.size();
+    if (n == 0) return chunks;
+
+    const Ranking ranking = rankingFor(strategy_);
+
+    auto emit = [&](size_t begin, size_t end) {
+        while (begin < end && isSpace(text[begin])) begin++;
+        while (end > begin && isSpace(text[end - 1])) end--;
+        if (end > begin) chunks.push_back(text.substr(begin, end - begin));
+    };
+
+    // Latest break of each kind after the previous cut
+    size_t last[kBreakKinds];
+    std::fill(last, last + kBreakKinds, kNone);
+    auto latest = [&](unsigned kinds, size_t after) {
+        size_t best = kNone;
+        for (int k = 0; k < kBreakKinds; k++) {
+            if ((kinds & (1u << k)) && last[k] != kNone && last[k] > after &&
+                (best == kNone || last[k] > best)) {
+                best = last[k];
+            }
+        }
+        return best;
+    };
+
+    size_t start = 0;
+    size_t run_start = kNone;  // Start of the whitespace run being scanned
+    int run_newlines = 0;
+
+    for (size_t pos = 0; pos < n; pos++) {
+        char c = text[pos];
+        if (isSpace(c)) {
+            if (run_start == kNone) {
+                run_start = pos;
+                run_newlines = 0;
+            }
+            if (c == '\n') run_newlines++;
+        } else if (run_start != kNone) {
+            // A break sits where the whitespace run ends
+            last[kWord] = pos;
+            if (run_start > 0) {
+                char before = text[run_start - 1];
+                if (before == '.' || before == '!' || before == '?') last[kSentence] = pos;
+            }
+            if (run_newlines >= 1) last[kLine] = pos;
+            if (run_newlines >= 2) last[kParagraph] = pos;
+            run_start = kNone;
+        }
+
+        if (pos - start < chunk_size_) continue;
+
+        // Chunk full: prefer a break in its second half, in ranking order,
+        // then any break at all, then a hard cut
+        size_t half = start + chunk_size_ / 2;
+        size_t cut = latest(ranking.preferred, half);
+        if (cut == kNone) cut = latest(ranking.fallback, half);
+        if (cut == kNone) cut = latest(1u << kWord, half);
+        if (cut == kNone) cut = latest(~0u, start);
+        if (cut == kNone) {
+            cut = pos;
+            while (cut > start + 1 && isContinuationByte(text[cut])) cut--;
+        }
+
+        emit(start, cut);
+        for (int k = 0; k < kBreakKinds; k++) {
+            if (last[k] != kNone && last[k] <= cut) last[k] = kNone;
+        }
+
+        // The next chunk repeats up to overlap_ bytes, starting at a word
+        size_t next = cut;
+        if (overlap_ > 0 && cut - start > overlap_) {
+            size_t from = cut - overlap_;
+            size_t word = from;
+            if (!isSpace(text[word - 1])) {
+                while (word < cut && !isSpace(text[word])) word++;
+            }
+            while (word < cut && isSpace(text[word])) word++;
+            if (word < cut) {
+                next = word;
+            } else {
+                next = from;
+                while (next < cut && isContinuationByte(text[next])) next++;
+            }
+        }
+        start = next;
+    }
+
+    emit(start, n);
+    return chunks;
+}
+
+} // namespace casper
@@ -8,10 +8,12 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <array>
+#include <ctime>
 
 namespace casper {
 
@@ -38,6 +40,45 @@ static std::vector<std::string> splitLines(const std::string& str) {
     return lines;
 }
 
+// One line of the learned-sources listing: chunks, text size, when it was
+// last indexed and with which embedding model
+static std::string describeSource(const SourceInfo& info) {
+    std::stringstream ss;
+    ss << info.chunks << (info.chunks == 1 ? " chunk, " : " chunks, ");
+    if (info.bytes >= 1024 * 1024) {
+        ss << std::fixed << std::setprecision(1) << info.bytes / (1024.0 * 1024.0) << " MB";
+    } else if (info.bytes >= 1024) {
+        ss << std::fixed << std::setprecision(1) << info.bytes / 1024.0 << " KB";
+    } else {
+        ss << info.bytes << " bytes";
+    }
+    if (info.last_indexed > 0) {
+        std::time_t time = static_cast<std::time_t>(info.last_indexed);
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", std::localtime(&time));
+        ss << ", indexed " << buffer;
+    }
+    if (!info.embedding_model.empty()) {
+        ss << ", " << info.embedding_model;
+    }
+    return ss.str();
+}
+
+// The optional "collection" parameter of the RAG tools ("" is the default
+// collection). Returns false with result's error set if the name is invalid.
+static bool parseCollection(const ToolCall& tool_call, std::string& collection, ToolResult& result) {
+    auto collection_it = tool_call.parameters.find("collection");
+    if (collection_it != tool_call.parameters.end()) {
+        collection = collection_it->second;
+    }
+    if (!collection.empty() && !VectorDB::isValidCollectionName(collection)) {
+        result.success = false;
+        result.error = "Invalid collection name: " + collection + " (letters, digits, '-' and '_' only)";
+        return false;
+    }
+    return true;
+}
+
 ToolExecutor::ToolExecutor(Config& config)
     : config_(config)
     , confirm_callback_(nullptr)
@@ -1197,14 +1238,21 @@ ToolResult ToolExecutor::executeLearn(const ToolCall& tool_call) {
         return result;
     }
 
+    // Optional: list what has been learned so far; nothing is indexed
+    bool status = false;
+    auto status_it = tool_call.parameters.find("status");
+    if (status_it != tool_call.parameters.end()) {
+        status = (status_it->second == "true" || status_it->second == "1");
+    }
+
     auto source_it = tool_call.parameters.find("source");
-    if (source_it == tool_call.parameters.end()) {
+    if (source_it == tool_call.parameters.end() && !status) {
         result.success = false;
         result.error = "Missing 'source' parameter";
         return result;
     }
 
-    std::string source = source_it->second;
+    std::string source = source_it != tool_call.parameters.end() ? source_it->second : "";
     std::string pattern = "*";
     std::string content;
 
@@ -1218,11 +1266,44 @@ ToolResult ToolExecutor::executeLearn(const ToolCall& tool_call) {
         content = content_it->second;
     }
 
+    // Optional: learn into a named collection instead of the default one
+    std::string collection;
+    if (!parseCollection(tool_call, collection, result)) {
+        return result;
+    }
+
+    if (status) {
+        auto sources = rag_engine_->getSourceInfo("", collection);
+        int64_t chunks = 0;
+        std::stringstream ss;
+        for (const auto& info : sources) {
+            chunks += info.chunks;
+            ss << "  " << info.source << ": " << describeSource(info) << "\n";
+        }
+
+        std::string collections;
+        for (const auto& name : rag_engine_->listCollections()) {
+            collections += (collections.empty() ? "" : ", ") + name;
+        }
+
+        utils::terminal::printInfo("[Tool: Learn]");
+        result.output = "Collections: " + collections + "\n" +
+                        "Learned sources" + (collection.empty() ? "" : " in " + collection) + ": " +
+                        std::to_string(sources.size()) + " (" + std::to_string(chunks) + " chunks)\n" + ss.str();
+        result.success = true;
+        result.exit_code = 0;
+        std::cout << "\n" << result.output << "\n";
+        return result;
+    }
+
     utils::terminal::printInfo("[Tool: Learn]");
     std::cout << utils::terminal::CYAN << "Source: " << source << utils::terminal::RESET << "\n";
     if (!pattern.empty() && pattern != "*") {
         std::cout << utils::terminal::CYAN << "Pattern: " << pattern << utils::terminal::RESET << "\n";
     }
+    if (!collection.empty()) {
+        std::cout << utils::terminal::CYAN << "Collection: " << collection << utils::terminal::RESET << "\n";
+    }
     std::cout << "\n";
 
     // Confirmation
@@ -1236,15 +1317,17 @@ ToolResult ToolExecutor::executeLearn(const ToolCall& tool_call) {
     utils::terminal::printInfo("Learning...");
 
     LearnResult learn_result;
+    bool directory = false;
 
     if (source == "text" && !content.empty()) {
-        learn_result = rag_engine_->learnText(content, "text_input");
+        learn_result = rag_engine_->learnText(content, "text_input", collection);
     } else if (source.find("http://") == 0 || source.find("https://") == 0) {
-        learn_result = rag_engine_->learnUrl(source);
+        learn_result = rag_engine_->learnUrl(source, collection);
     } else if (utils::dirExists(source)) {
-        learn_result = rag_engine_->learnDirectory(source, pattern);
+        learn_result = rag_engine_->learnDirectory(source, pattern, collection);
+        directory = true;
     } else if (utils::fileExists(source)) {
-        learn_result = rag_engine_->learnFile(source);
+        learn_result = rag_engine_->learnFile(source, collection);
     } else {
         result.success = false;
         result.error = "Source not found: " + source;
@@ -1261,8 +1344,43 @@ ToolResult ToolExecutor::executeLearn(const ToolCall& tool_call) {
 
     std::stringstream ss;
     ss << "Learned from: " << source << "\n";
+    if (!collection.empty()) {
+        ss << "Collection: " << collection << "\n";
+    }
     ss << "Documents indexed: " << learn_result.documents_added << "\n";
     ss << "Chunks created: " << learn_result.chunks_created << "\n";
+    if (learn_result.files_unchanged > 0) {
+        ss << "Unchanged files skipped: " << learn_result.files_unchanged << "\n";
+    }
+    if (learn_result.chunks_unchanged > 0) {
+        ss << "Unchanged chunks kept: " << learn_result.chunks_unchanged << "\n";
+    }
+    if (learn_result.files_removed > 0) {
+        ss << "Deleted files forgotten: " << learn_result.files_removed << "\n";
+    }
+    if (learn_result.files_skipped > 0) {
+        ss << "Skipped (too large, excluded type or binary): " << learn_result.files_skipped << "\n";
+    }
+    SourceInfo info;
+    if (!directory && rag_engine_->getSource(source, info, collection)) {
+        ss << "Source now holds: " << describeSource(info) << "\n";
+    }
+    if (directory) {
+        IngestStats ingest = rag_engine_->getIngestStats();
+        ss << std::fixed << std::setprecision(2);
+        ss << "Pipeline: " << ingest.wall_seconds << "s\n";
+        for (const auto& stage : ingest.stages) {
+            ss << "  " << stage.name << " (" << stage.workers << "): " << stage.files << " files, "
+               << stage.units << " " << stage.unit << ", " << stage.unitsPerSecond() << " " << stage.unit << "/s, "
+               << stage.stall_seconds << "s stalled\n";
+        }
+        for (const auto& watched : rag_engine_->getWatchedDirectories()) {
+            if (source.compare(0, watched.size(), watched) == 0) {
+                ss << "Watching " << watched << " for changes\n";
+                break;
+            }
+        }
+    }
 
     result.output = ss.str();
     result.success = true;
@@ -1308,13 +1426,33 @@ ToolResult ToolExecutor::executeRemember(const ToolCall& tool_call) {
         } catch (...) {}
     }
 
+    // Optional scope: only sources starting with the given prefix
+    SearchFilter filter;
+    auto source_it = tool_call.parameters.find("source");
+    if (source_it != tool_call.parameters.end()) {
+        filter.source_prefix = source_it->second;
+    }
+
+    // Optional: search one named collection; the others are not touched
+    std::string collection;
+    if (!parseCollection(tool_call, collection, result)) {
+        return result;
+    }
+
     utils::terminal::printInfo("[Tool: Remember]");
     std::cout << utils::terminal::CYAN << "Query: " << query << utils::terminal::RESET << "\n";
-    std::cout << utils::terminal::CYAN << "Max results: " << max_results << utils::terminal::RESET << "\n\n";
+    std::cout << utils::terminal::CYAN << "Max results: " << max_results << utils::terminal::RESET << "\n";
+    if (!filter.source_prefix.empty()) {
+        std::cout << utils::terminal::CYAN << "Source: " << filter.source_prefix << "*" << utils::terminal::RESET << "\n";
+    }
+    if (!collection.empty()) {
+        std::cout << utils::terminal::CYAN << "Collection: " << collection << utils::terminal::RESET << "\n";
+    }
+    std::cout << "\n";
 
     utils::terminal::printInfo("Searching memory...");
 
-    auto context = rag_engine_->retrieve(query, max_results);
+    auto context = rag_engine_->retrieve(query, max_results, filter, collection);
 
     if (context.results.empty()) {
         result.output = "No relevant context found in memory.";
@@ -1359,9 +1497,52 @@ ToolResult ToolExecutor::executeForget(const ToolCall& tool_call) {
     }
 
     std::string source = source_it->second;
+    bool all = source == "*" || source == "all";
+
+    // Optional: forget from a named collection; "all" then empties only it
+    std::string collection;
+    if (!parseCollection(tool_call, collection, result)) {
+        return result;
+    }
+
+    // Resolve the source against the catalog: an exact match, or every
+    // source under a directory
+    std::vector<SourceInfo> targets;
+    int64_t chunks = 0;
+    if (!all) {
+        SourceInfo info;
+        if (rag_engine_->getSource(source, info, collection)) {
+            targets.push_back(info);
+        } else {
+            std::string prefix = source;
+            if (!prefix.empty() && prefix.back() != '/') prefix += '/';
+            targets = rag_engine_->getSourceInfo(prefix, collection);
+        }
+        for (const auto& target : targets) {
+            chunks += target.chunks;
+        }
+    }
 
     utils::terminal::printInfo("[Tool: Forget]");
-    std::cout << utils::terminal::CYAN << "Source: " << source << utils::terminal::RESET << "\n\n";
+    std::cout << utils::terminal::CYAN << "Source: " << source << utils::terminal::RESET << "\n";
+    if (!collection.empty()) {
+        std::cout << utils::terminal::CYAN << "Collection: " << collection << utils::terminal::RESET << "\n";
+    }
+    if (targets.size() > 1) {
+        std::cout << utils::terminal::CYAN << "Matches: " << targets.size() << " sources, " << chunks << " chunks"
+                  << utils::terminal::RESET << "\n";
+    } else if (targets.size() == 1) {
+        std::cout << utils::terminal::CYAN << "Holds: " << describeSource(targets[0]) << utils::terminal::RESET << "\n";
+    }
+    std::cout << "\n";
+
+    if (!all && targets.empty()) {
+        result.output = "Nothing learned from: " + source;
+        result.success = true;
+        result.exit_code = 0;
+        utils::terminal::printInfo(result.output);
+        return result;
+    }
 
     // Confirmation
     if (!requestConfirmation("Forget", "Remove content from vector database?")) {
@@ -1373,13 +1554,19 @@ ToolResult ToolExecutor::executeForget(const ToolCall& tool_call) {
 
     utils::terminal::printInfo("Forgetting...");
 
-    bool success;
-    if (source == "*" || source == "all") {
-        success = rag_engine_->forgetAll();
-        result.output = "All content removed from vector database.";
+    bool success = true;
+    if (all) {
+        success = rag_engine_->forgetAll(collection);
+        result.output = collection.empty() ? "All content removed from vector database." :
+                                             "All content removed from collection: " + collection;
     } else {
-        success = rag_engine_->forget(source);
-        result.output = "Removed content from: " + source;
+        for (const auto& target : targets) {
+            success = rag_engine_->forget(target.source, collection) && success;
+        }
+        result.output = "Removed " + std::to_string(chunks) + " chunks from: " + source;
+        if (targets.size() > 1) {
+            result.output += " (" + std::to_string(targets.size()) + " sources)";
+        }
     }
 
     if (!success) {
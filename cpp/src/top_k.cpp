@@ -0,0 +1,95 @@
+#include "top_k.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <limits>
+
+namespace casper {
+
+namespace {
+
+// Higher score first; equal scores keep the lower index so results are stable
+bool better(const TopKSelector::Entry& a, const TopKSelector::Entry& b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+} // namespace
+
+TopKSelector::TopKSelector(size_t k, float threshold)
+    : k_(k)
+    , threshold_(threshold)
+    , bound_(threshold) {
+    heap_.reserve(k_);
+    updateBound();
+}
+
+void TopKSelector::updateBound() {
+    if (k_ == 0) {
+        bound_ = std::numeric_limits<float>::infinity();
+    } else if (heap_.size() < k_) {
+        bound_ = threshold_;
+    } else {
+        bound_ = std::max(threshold_, heap_.front().first);
+    }
+}
+
+bool TopKSelector::push(float score, size_t index) {
+    if (score < bound_) return false;
+
+    Entry entry(score, index);
+    if (heap_.size() < k_) {
+        // better() as the ordering puts the worst entry at the root
+        heap_.push_back(entry);
+        std::push_heap(heap_.begin(), heap_.end(), better);
+    } else {
+        if (!better(entry, heap_.front())) return false;
+        std::pop_heap(heap_.begin(), heap_.end(), better);
+        heap_.back() = entry;
+        std::push_heap(heap_.begin(), heap_.end(), better);
+    }
+
+    updateBound();
+    return true;
+}
+
+void TopKSelector::merge(const TopKSelector& other) {
+    for (const auto& entry : other.heap_) {
+        push(entry.first, entry.second);
+    }
+}
+
+std::vector<TopKSelector::Entry> TopKSelector::take() {
+    std::vector<Entry> entries;
+    entries.swap(heap_);
+    std::sort(entries.begin(), entries.end(), better);
+    heap_.reserve(k_);
+    updateBound();
+    return entries;
+}
+
+TopKSelector parallelTopK(WorkerPool* pool, size_t count, size_t k, float threshold,
+                          size_t partitions, const TopKScan& scan) {
+    TopKSelector top(k, threshold);
+    if (!pool || pool->size() < 2 || partitions < 2 || count == 0) {
+        scan(0, count, top);
+        return top;
+    }
+
+    // Partition boundaries fall on 64-row multiples so scans keep whole blocks
+    size_t per_partition = (count + partitions - 1) / partitions;
+    per_partition = (per_partition + 63) / 64 * 64;
+    partitions = (count + per_partition - 1) / per_partition;
+
+    std::vector<TopKSelector> partial(partitions, TopKSelector(k, threshold));
+    pool->run(partitions, [&](size_t p) {
+        size_t begin = p * per_partition;
+        size_t end = std::min(count, begin + per_partition);
+        scan(begin, end, partial[p]);
+    });
+
+    for (const auto& part : partial) {
+        top.merge(part);
+    }
+    return top;
+}
+
+} // namespace casper
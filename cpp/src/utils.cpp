@@ -9,6 +9,7 @@
 #include <unistd.h>
 #include <pwd.h>
 #include <chrono>
+#include <cstdint>
 
 namespace casper {
 namespace utils {
@@ -47,7 +48,39 @@ std::string toLower(const std::string& str) {
     return result;
 }
 
-// File utilities
+// Hashing
+void hash128(const void* data, size_t size, unsigned char out[16]) {
+    // FNV-1a, 128-bit variant: enough bits that distinct chunks do not collide
+    // in practice, and no dependency on a crypto library
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hi = 0x6c62272e07bb0142ULL;
+    uint64_t lo = 0x62b821756295c58dULL;
+    for (size_t i = 0; i < size; i++) {
+        lo ^= bytes[i];
+        // h *= 2^88 + 0x13B, on 64-bit halves
+        uint64_t carry = ((lo >> 32) * 0x13B + (((lo & 0xFFFFFFFFULL) * 0x13B) >> 32)) >> 32;
+        hi = hi * 0x13B + carry + (lo << 24);
+        lo *= 0x13B;
+    }
+    for (int i = 0; i < 8; i++) {
+        out[i] = static_cast<unsigned char>(lo >> (8 * i));
+        out[8 + i] = static_cast<unsigned char>(hi >> (8 * i));
+    }
+}
+
+std::string hash128Hex(std::string_view data) {
+    static const char digits[] = "0123456789abcdef";
+    unsigned char hash[16];
+    hash128(data.data(), data.size(), hash);
+
+    std::string hex(32, '0');
+    for (int i = 0; i < 16; i++) {
+        hex[2 * i] = digits[hash[i] >> 4];
+        hex[2 * i + 1] = digits[hash[i] & 0xF];
+    }
+    return hex;
+}
+
 bool fileExists(const std::string& path) {
     struct stat buffer;
     return (stat(path.c_str(), &buffer) == 0 && S_ISREG(buffer.st_mode));
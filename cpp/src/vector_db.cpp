@@ -1,5 +1,10 @@
 #include "vector_db.h"
 #include "json.hpp"
+#include "simd_kernels.h"
+#include "quantizer.h"
+#include "top_k.h"
+#include "vector_snapshot.h"
+#include "utils.h"
 #include <sqlite3.h>
 #include <curl/curl.h>
 #include <algorithm>
@@ -9,7 +14,13 @@
 #include <chrono>
 #include <random>
 #include <iostream>
+#include <map>
+#include <set>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
 #include <sys/stat.h>
+#include <dirent.h>
 
 using json = nlohmann::json;
 
@@ -22,11 +33,152 @@ static size_t writeCallback(void* contents, size_t size, size_t nmemb, std::stri
     return total_size;
 }
 
+// ============================================================================
+// SearchFilter
+// ============================================================================
+
+bool SearchFilter::empty() const {
+    return source_prefix.empty() && min_timestamp == 0 && max_timestamp == 0 && metadata.empty();
+}
+
+// The filter's textual form of a value, read as a number (all of it)
+static bool parseMetadataNumber(const std::string& expected, double& number) {
+    try {
+        size_t used = 0;
+        number = std::stod(expected, &used);
+        return used == expected.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+// Compare a metadata value against the filter's textual form
+static bool metadataValueEquals(const json& value, const std::string& expected) {
+    if (value.is_string()) return value.get<std::string>() == expected;
+    if (value.is_boolean()) {
+        return expected == (value.get<bool>() ? "true" : "false") || expected == (value.get<bool>() ? "1" : "0");
+    }
+    if (value.is_number()) {
+        double number;
+        return parseMetadataNumber(expected, number) && number == value.get<double>();
+    }
+    return value.dump() == expected;
+}
+
+bool SearchFilter::matches(const std::string& source, const std::string& metadata_json, int64_t timestamp) const {
+    if (!source_prefix.empty() && source.compare(0, source_prefix.size(), source_prefix) != 0) return false;
+    if (timestamp >= 0) {
+        if (min_timestamp > 0 && timestamp < min_timestamp) return false;
+        if (max_timestamp > 0 && timestamp > max_timestamp) return false;
+    }
+    if (metadata.empty()) return true;
+
+    json meta = json::parse(metadata_json, nullptr, false);
+    if (!meta.is_object()) return false;
+    for (const auto& kv : metadata) {
+        auto it = meta.find(kv.first);
+        if (it == meta.end() || !metadataValueEquals(*it, kv.second)) return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// VectorDBBackend
+// ============================================================================
+
+bool VectorDBBackend::forEach(const std::function<bool(const VectorDocument&)>& fn) {
+    const int page = 1000;
+    std::string previous_first;
+    for (int offset = 0; ; offset += page) {
+        auto docs = getAll(page, offset);
+        // A backend that ignores the offset hands back the first page again;
+        // stop rather than loop over it forever
+        if (!docs.empty() && offset > 0 && docs.front().id == previous_first) {
+            std::cerr << "Backend does not support paging; export stopped after "
+                      << offset << " documents" << std::endl;
+            return false;
+        }
+        for (const auto& doc : docs) {
+            if (!fn(doc)) return false;
+        }
+        if (static_cast<int>(docs.size()) < page) return true;
+        previous_first = docs.front().id;
+    }
+}
+
+bool VectorDBBackend::updateMetadata(const std::string& id, const std::string& metadata) {
+    VectorDocument doc = get(id);
+    if (doc.id.empty()) return false;
+    doc.metadata = metadata;
+    return update(doc);
+}
+
+std::vector<SourceInfo> VectorDBBackend::listSources(const std::string& prefix) {
+    std::map<std::string, SourceInfo> sources;
+    forEach([&](const VectorDocument& doc) {
+        if (doc.source.compare(0, prefix.size(), prefix) != 0) return true;
+        SourceInfo& info = sources[doc.source];
+        info.source = doc.source;
+        info.chunks++;
+        info.bytes += static_cast<int64_t>(doc.content.size());
+        info.last_indexed = std::max(info.last_indexed, doc.timestamp);
+        return true;
+    });
+
+    std::vector<SourceInfo> list;
+    list.reserve(sources.size());
+    for (auto& entry : sources) {
+        list.push_back(std::move(entry.second));
+    }
+    return list;
+}
+
+bool VectorDBBackend::getSource(const std::string& source, SourceInfo& info) {
+    for (auto& candidate : listSources(source)) {
+        if (candidate.source == source) {
+            info = std::move(candidate);
+            return true;
+        }
+    }
+    return false;
+}
+
 // ============================================================================
 // SQLiteVectorDB Implementation
 // ============================================================================
 
-SQLiteVectorDB::SQLiteVectorDB() : db_(nullptr), dimensions_(0) {
+SQLiteVectorDB::SQLiteVectorDB()
+    : db_(nullptr), dimensions_(0), bulk_depth_(0), bulk_rows_(0)
+    , text_search_(false), read_db_(nullptr), text_stmt_(nullptr) {
+}
+
+void SQLiteVectorDB::configure(const VectorDBOptions& options) {
+    bool rebuild = db_ && options.hnsw_enabled &&
+        (!options_.hnsw_enabled || options.hnsw_m != options_.hnsw_m);
+    bool requantize = db_ && options.quantization != options_.quantization;
+    if (options.search_threads != options_.search_threads) {
+        pool_.reset();
+    }
+
+    options_ = options;
+    if (db_) {
+        applyPragmas();
+    }
+
+    HNSWParams params;
+    params.M = options_.hnsw_m;
+    params.ef_construction = options_.hnsw_ef_construction;
+    params.ef_search = options_.hnsw_ef_search;
+    index_.setParams(params);
+
+    if (requantize) {
+        loadResident();
+    }
+    if (rebuild) {
+        rebuildIndex();
+    } else if (requantize && options_.hnsw_enabled) {
+        loadIndex();  // Node vectors follow the matrix between floats and codes
+    }
 }
 
 SQLiteVectorDB::~SQLiteVectorDB() {
@@ -45,22 +197,121 @@ bool SQLiteVectorDB::open(const std::string& path) {
         return false;
     }
 
+    applyPragmas();
     initializeTables();
+    loadResident();
+
+    if (options_.hnsw_enabled) {
+        loadIndex();
+    }
     return true;
 }
 
 void SQLiteVectorDB::close() {
     if (db_) {
+        if (bulk_depth_ > 0) {
+            bulk_depth_ = 1;
+            endBulkLoad();
+        }
+        finalizeStatements();
+        {
+            std::lock_guard<std::mutex> lock(text_mutex_);
+            sqlite3_finalize(static_cast<sqlite3_stmt*>(text_stmt_));
+            sqlite3_close(static_cast<sqlite3*>(read_db_));
+            text_stmt_ = nullptr;
+            read_db_ = nullptr;
+        }
         sqlite3_close(static_cast<sqlite3*>(db_));
         db_ = nullptr;
     }
+    text_search_ = false;
+    matrix_.reset();
+    sparse_.reset();
+    index_.reset(&matrix_);
 }
 
 bool SQLiteVectorDB::isOpen() const {
     return db_ != nullptr;
 }
 
+void SQLiteVectorDB::applyPragmas() {
+    sqlite3* db = static_cast<sqlite3*>(db_);
+
+    std::string synchronous = options_.sqlite_synchronous;
+    std::transform(synchronous.begin(), synchronous.end(), synchronous.begin(), ::tolower);
+    if (synchronous != "off" && synchronous != "normal" && synchronous != "full" && synchronous != "extra") {
+        std::cerr << "SQLite vector DB: unknown synchronous mode '" << options_.sqlite_synchronous
+                  << "', using normal" << std::endl;
+        synchronous = "normal";
+    }
+
+    // WAL lets readers run alongside the writer, and with synchronous=NORMAL
+    // a commit no longer waits for an fsync
+    std::string pragmas = "PRAGMA journal_mode = WAL;"
+                          "PRAGMA synchronous = " + synchronous + ";"
+                          "PRAGMA cache_size = " + std::to_string(-static_cast<int64_t>(options_.sqlite_cache_kb)) + ";"
+                          "PRAGMA mmap_size = " + std::to_string(options_.sqlite_mmap_bytes) + ";"
+                          "PRAGMA temp_store = MEMORY;"
+                          // INSERT OR REPLACE must fire the delete trigger of
+                          // the row it replaces, or vectors_fts keeps its text
+                          "PRAGMA recursive_triggers = ON;";
+
+    char* err_msg = nullptr;
+    sqlite3_exec(db, pragmas.c_str(), nullptr, nullptr, &err_msg);
+    if (err_msg) {
+        std::cerr << "SQLite pragma error: " << err_msg << std::endl;
+        sqlite3_free(err_msg);
+    }
+}
+
+void* SQLiteVectorDB::statement(const char* sql) {
+    auto it = statements_.find(sql);
+    if (it != statements_.end()) {
+        sqlite3_stmt* stmt = static_cast<sqlite3_stmt*>(it->second);
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        return stmt;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(static_cast<sqlite3*>(db_), sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQLite prepare error: " << sqlite3_errmsg(static_cast<sqlite3*>(db_)) << std::endl;
+        return nullptr;
+    }
+    statements_[sql] = stmt;
+    return stmt;
+}
+
+void SQLiteVectorDB::finalizeStatements() {
+    for (auto& kv : statements_) {
+        sqlite3_finalize(static_cast<sqlite3_stmt*>(kv.second));
+    }
+    statements_.clear();
+}
+
+// Schema history (stored in PRAGMA user_version):
+//   0 - original layout, raw embeddings
+//   1 - embeddings stored unit-length, original length in the norm column
+//   2 - quantized codes in the code column, codebooks in vector_meta
+//   3 - sources table (per source chunk count, bytes, last update), kept
+//       current by triggers on vectors
+static const int kSchemaVersion = 3;
+
 void SQLiteVectorDB::initializeTables() {
+    sqlite3* db = static_cast<sqlite3*>(db_);
+
+    int version = 0;
+    bool fresh = true;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) version = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'vectors'", -1, &stmt, nullptr) == SQLITE_OK) {
+        fresh = sqlite3_step(stmt) != SQLITE_ROW;
+        sqlite3_finalize(stmt);
+    }
+
     const char* create_sql = R"(
         CREATE TABLE IF NOT EXISTS vectors (
             id TEXT PRIMARY KEY,
@@ -69,30 +320,208 @@ void SQLiteVectorDB::initializeTables() {
             metadata TEXT,
             embedding BLOB NOT NULL,
             dimensions INTEGER,
-            timestamp INTEGER
+            timestamp INTEGER,
+            norm REAL,
+            code BLOB
         );
         CREATE INDEX IF NOT EXISTS idx_source ON vectors(source);
         CREATE INDEX IF NOT EXISTS idx_timestamp ON vectors(timestamp);
+        CREATE TABLE IF NOT EXISTS hnsw_nodes (
+            label INTEGER PRIMARY KEY,
+            doc_id TEXT NOT NULL,
+            level INTEGER NOT NULL,
+            deleted INTEGER NOT NULL DEFAULT 0,
+            links BLOB
+        );
+        CREATE TABLE IF NOT EXISTS hnsw_meta (
+            key TEXT PRIMARY KEY,
+            value TEXT NOT NULL
+        );
+        CREATE TABLE IF NOT EXISTS vector_meta (
+            key TEXT PRIMARY KEY,
+            value BLOB
+        );
+        CREATE TABLE IF NOT EXISTS source_manifest (
+            source TEXT PRIMARY KEY,
+            size INTEGER NOT NULL,
+            mtime INTEGER NOT NULL,
+            content_hash TEXT NOT NULL,
+            chunk_ids TEXT NOT NULL,
+            indexed_at INTEGER NOT NULL
+        );
+        CREATE TABLE IF NOT EXISTS sources (
+            source TEXT PRIMARY KEY,
+            chunks INTEGER NOT NULL,
+            bytes INTEGER NOT NULL,
+            last_indexed INTEGER NOT NULL,
+            embedding_model TEXT
+        );
+        CREATE TRIGGER IF NOT EXISTS sources_insert AFTER INSERT ON vectors BEGIN
+            INSERT INTO sources (source, chunks, bytes, last_indexed, embedding_model)
+            VALUES (COALESCE(new.source, ''), 1, LENGTH(CAST(new.content AS BLOB)), COALESCE(new.timestamp, 0),
+                    (SELECT CAST(value AS TEXT) FROM vector_meta WHERE key = 'embedding_model'))
+            ON CONFLICT (source) DO UPDATE SET
+                chunks = chunks + 1,
+                bytes = bytes + excluded.bytes,
+                last_indexed = MAX(last_indexed, excluded.last_indexed),
+                embedding_model = COALESCE(excluded.embedding_model, embedding_model);
+        END;
+        CREATE TRIGGER IF NOT EXISTS sources_delete AFTER DELETE ON vectors BEGIN
+            UPDATE sources SET chunks = chunks - 1, bytes = bytes - LENGTH(CAST(old.content AS BLOB))
+                WHERE source = COALESCE(old.source, '');
+            DELETE FROM sources WHERE source = COALESCE(old.source, '') AND chunks <= 0;
+        END;
+        CREATE TRIGGER IF NOT EXISTS sources_update AFTER UPDATE OF content, source ON vectors BEGIN
+            UPDATE sources SET chunks = chunks - 1, bytes = bytes - LENGTH(CAST(old.content AS BLOB))
+                WHERE source = COALESCE(old.source, '');
+            DELETE FROM sources WHERE source = COALESCE(old.source, '') AND chunks <= 0;
+            INSERT INTO sources (source, chunks, bytes, last_indexed, embedding_model)
+            VALUES (COALESCE(new.source, ''), 1, LENGTH(CAST(new.content AS BLOB)), COALESCE(new.timestamp, 0),
+                    (SELECT CAST(value AS TEXT) FROM vector_meta WHERE key = 'embedding_model'))
+            ON CONFLICT (source) DO UPDATE SET
+                chunks = chunks + 1,
+                bytes = bytes + excluded.bytes,
+                last_indexed = MAX(last_indexed, excluded.last_indexed);
+        END;
     )";
 
     char* err_msg = nullptr;
-    sqlite3_exec(static_cast<sqlite3*>(db_), create_sql, nullptr, nullptr, &err_msg);
+    sqlite3_exec(db, create_sql, nullptr, nullptr, &err_msg);
     if (err_msg) {
         std::cerr << "SQLite init error: " << err_msg << std::endl;
         sqlite3_free(err_msg);
     }
+
+    if (fresh) {
+        sqlite3_exec(db, ("PRAGMA user_version = " + std::to_string(kSchemaVersion)).c_str(), nullptr, nullptr, nullptr);
+    } else if (version < kSchemaVersion) {
+        migrateSchema(version);
+    }
+
+    initializeTextIndex();
 }
 
-std::string SQLiteVectorDB::generateId() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, 15);
+// The keyword index is optional (SQLite may be built without FTS5), so it is
+// not part of the versioned schema: it is created, and filled from the
+// existing rows, whenever a database is opened without it
+void SQLiteVectorDB::initializeTextIndex() {
+    sqlite3* db = static_cast<sqlite3*>(db_);
+
+    bool exists = false;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE name = 'vectors_fts'", -1, &stmt, nullptr) == SQLITE_OK) {
+        exists = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_finalize(stmt);
+    }
 
-    std::stringstream ss;
-    for (int i = 0; i < 32; i++) {
-        ss << std::hex << dis(gen);
+    // External-content index over vectors.content, kept in sync by triggers.
+    // '_' is a token character so identifiers like ERR_CONN_RESET stay whole.
+    const char* fts_sql = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS vectors_fts USING fts5(
+            content,
+            content = 'vectors',
+            content_rowid = 'rowid',
+            tokenize = "unicode61 tokenchars '_'"
+        );
+        CREATE TRIGGER IF NOT EXISTS vectors_fts_insert AFTER INSERT ON vectors BEGIN
+            INSERT INTO vectors_fts (rowid, content) VALUES (new.rowid, new.content);
+        END;
+        CREATE TRIGGER IF NOT EXISTS vectors_fts_delete AFTER DELETE ON vectors BEGIN
+            INSERT INTO vectors_fts (vectors_fts, rowid, content) VALUES ('delete', old.rowid, old.content);
+        END;
+        CREATE TRIGGER IF NOT EXISTS vectors_fts_update AFTER UPDATE OF content ON vectors BEGIN
+            INSERT INTO vectors_fts (vectors_fts, rowid, content) VALUES ('delete', old.rowid, old.content);
+            INSERT INTO vectors_fts (rowid, content) VALUES (new.rowid, new.content);
+        END;
+    )";
+
+    char* err_msg = nullptr;
+    sqlite3_exec(db, fts_sql, nullptr, nullptr, &err_msg);
+    if (err_msg) {
+        std::cerr << "SQLite keyword index unavailable: " << err_msg << std::endl;
+        sqlite3_free(err_msg);
+        text_search_ = false;
+        return;
+    }
+    text_search_ = true;
+
+    if (!exists) {
+        sqlite3_exec(db, "INSERT INTO vectors_fts (vectors_fts) VALUES ('rebuild')", nullptr, nullptr, nullptr);
     }
-    return ss.str();
+}
+
+void SQLiteVectorDB::migrateSchema(int from_version) {
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    sqlite3_exec(db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+    if (from_version < 1) {
+        // Normalize every stored embedding once and keep its original length
+        sqlite3_exec(db, "ALTER TABLE vectors ADD COLUMN norm REAL", nullptr, nullptr, nullptr);
+
+        sqlite3_stmt* select_stmt;
+        sqlite3_stmt* update_stmt;
+        if (sqlite3_prepare_v2(db, "SELECT rowid, embedding FROM vectors", -1, &select_stmt, nullptr) == SQLITE_OK) {
+            if (sqlite3_prepare_v2(db, "UPDATE vectors SET embedding = ?, norm = ? WHERE rowid = ?", -1, &update_stmt, nullptr) == SQLITE_OK) {
+                while (sqlite3_step(select_stmt) == SQLITE_ROW) {
+                    const void* blob = sqlite3_column_blob(select_stmt, 1);
+                    int blob_size = sqlite3_column_bytes(select_stmt, 1);
+                    Embedding emb = deserializeEmbedding(std::string(static_cast<const char*>(blob), blob_size));
+                    float norm = normalizeInPlace(emb);
+
+                    std::string data = serializeEmbedding(emb);
+                    sqlite3_bind_blob(update_stmt, 1, data.data(), static_cast<int>(data.size()), SQLITE_TRANSIENT);
+                    sqlite3_bind_double(update_stmt, 2, norm);
+                    sqlite3_bind_int64(update_stmt, 3, sqlite3_column_int64(select_stmt, 0));
+                    sqlite3_step(update_stmt);
+                    sqlite3_reset(update_stmt);
+                }
+                sqlite3_finalize(update_stmt);
+            }
+            sqlite3_finalize(select_stmt);
+        }
+    }
+
+    if (from_version < 2) {
+        // Codes are filled in by loadResident() when quantization is enabled
+        sqlite3_exec(db, "ALTER TABLE vectors ADD COLUMN code BLOB", nullptr, nullptr, nullptr);
+    }
+
+    if (from_version < 3) {
+        // Fill the source catalog once; the triggers keep it current after
+        // this. The model that indexed older rows is not known.
+        sqlite3_exec(db, "DELETE FROM sources; "
+                     "INSERT INTO sources (source, chunks, bytes, last_indexed) "
+                     "SELECT COALESCE(source, ''), COUNT(*), SUM(LENGTH(CAST(content AS BLOB))), COALESCE(MAX(timestamp), 0) "
+                     "FROM vectors GROUP BY COALESCE(source, '')",
+                     nullptr, nullptr, nullptr);
+    }
+
+    sqlite3_exec(db, ("PRAGMA user_version = " + std::to_string(kSchemaVersion)).c_str(), nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+}
+
+float SQLiteVectorDB::normalizeInPlace(Embedding& emb) {
+    float norm = std::sqrt(simd::squaredNorm(emb.data(), emb.size()));
+    if (norm > 0.0f && std::fabs(norm - 1.0f) > 1e-5f) {
+        simd::scale(emb.data(), emb.size(), 1.0f / norm);
+    }
+    return norm;
+}
+
+std::string SQLiteVectorDB::generateId() {
+    static const char hex[] = "0123456789abcdef";
+    static std::mt19937_64 gen(std::random_device{}());
+
+    // 32 hex digits from two 64-bit draws
+    std::string id(32, '0');
+    for (int half = 0; half < 2; half++) {
+        uint64_t bits = gen();
+        for (int i = 0; i < 16; i++) {
+            id[half * 16 + i] = hex[bits & 0xF];
+            bits >>= 4;
+        }
+    }
+    return id;
 }
 
 std::string SQLiteVectorDB::serializeEmbedding(const Embedding& emb) {
@@ -100,163 +529,1301 @@ std::string SQLiteVectorDB::serializeEmbedding(const Embedding& emb) {
 }
 
 Embedding SQLiteVectorDB::deserializeEmbedding(const std::string& data) {
+    SparseVector sparse;
+    int dims = 0;
+    if (SparseIndex::deserialize(data.data(), data.size(), sparse, dims)) {
+        return SparseIndex::toDense(sparse, dims);
+    }
+
     size_t count = data.size() / sizeof(float);
     Embedding emb(count);
     std::memcpy(emb.data(), data.data(), data.size());
     return emb;
 }
 
+// ----------------------------------------------------------------------------
+// Resident embedding matrix
+// ----------------------------------------------------------------------------
+
+// Sparse rows (see SparseIndex::serialize) are always shorter than a dense
+// row of their dimensionality, so SQL can tell them apart by blob length
+#define DENSE_ROW "LENGTH(embedding) = dimensions * 4"
+
+void SQLiteVectorDB::loadResident() {
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    matrix_.reset();
+    sparse_.reset();
+
+    int64_t count = 0;  // Dense rows
+    int dims = 0;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM vectors WHERE " DENSE_ROW, -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            count = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+
+        // Size the block from the first row's dimensionality
+        if (sqlite3_prepare_v2(db, "SELECT dimensions FROM vectors LIMIT 1", -1, &stmt, nullptr) == SQLITE_OK) {
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                dims = sqlite3_column_int(stmt, 0);
+            }
+            sqlite3_finalize(stmt);
+        }
+    }
+
+    quantizer_.configure(VectorQuantizer::parseMode(options_.quantization), dims);
+
+    if (quantizer_.mode() != QuantizationMode::None && prepareCodes(count)) {
+        matrix_.resetCodes(dims, quantizer_.codeSize());
+        matrix_.reserve(static_cast<size_t>(count));
+
+        if (sqlite3_prepare_v2(db, "SELECT id, code FROM vectors WHERE code IS NOT NULL ORDER BY rowid", -1, &stmt, nullptr) == SQLITE_OK) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                const char* id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+                const void* blob = sqlite3_column_blob(stmt, 1);
+                if (!id || !blob) continue;
+                matrix_.upsertCode(id, static_cast<const uint8_t*>(blob), sqlite3_column_bytes(stmt, 1));
+            }
+            sqlite3_finalize(stmt);
+        }
+
+        if (sqlite3_prepare_v2(db, "SELECT id, embedding FROM vectors WHERE NOT " DENSE_ROW " ORDER BY rowid",
+                               -1, &stmt, nullptr) == SQLITE_OK) {
+            SparseVector sparse;
+            int sparse_dims;
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                const char* id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+                if (id && SparseIndex::deserialize(sqlite3_column_blob(stmt, 1), sqlite3_column_bytes(stmt, 1),
+                                                   sparse, sparse_dims)) {
+                    sparse_.upsert(id, sparse, sparse_dims);
+                }
+            }
+            sqlite3_finalize(stmt);
+        }
+    } else {
+        if (dims > 0) {
+            matrix_.reset(dims);
+            matrix_.reserve(static_cast<size_t>(count));
+        }
+
+        if (sqlite3_prepare_v2(db, "SELECT id, embedding FROM vectors ORDER BY rowid", -1, &stmt, nullptr) == SQLITE_OK) {
+            SparseVector sparse;
+            int sparse_dims;
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                const char* id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+                const void* blob = sqlite3_column_blob(stmt, 1);
+                int blob_size = sqlite3_column_bytes(stmt, 1);
+                if (!id || !blob) continue;
+                if (SparseIndex::deserialize(blob, blob_size, sparse, sparse_dims)) {
+                    sparse_.upsert(id, sparse, sparse_dims);
+                } else {
+                    matrix_.upsert(id, static_cast<const float*>(blob), blob_size / sizeof(float));
+                }
+            }
+            sqlite3_finalize(stmt);
+        }
+    }
+
+    dimensions_ = dims > 0 ? dims : matrix_.dimensions();
+    // Rows were reloaded in a new order
+    index_.remapRows();
+}
+
+// Drop a resident dense row. The graph copies the row for the node's
+// tombstone first, then follows the row the matrix moves into the hole.
+void SQLiteVectorDB::removeResident(const std::string& id) {
+    int64_t row = matrix_.rowOf(id);
+    index_.markDeleted(id);
+    if (!matrix_.remove(id)) return;
+    if (static_cast<size_t>(row) < matrix_.size()) {
+        index_.rowMoved(matrix_.idAt(static_cast<size_t>(row)), static_cast<size_t>(row));
+    }
+}
+
+// Bring the code column in line with the configured quantization: drop codes
+// written under another mode or codebook, train a PQ codebook if needed and
+// encode rows without a code. Returns false if codes cannot be used yet
+// (empty table, or too few rows to train PQ).
+bool SQLiteVectorDB::prepareCodes(int64_t count) {
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    if (quantizer_.dimensions() == 0) return false;
+
+    sqlite3_exec(db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+    std::string mode = VectorQuantizer::modeName(quantizer_.mode());
+    std::string stored_mode = readMeta("quantization");
+    if (stored_mode != mode) {
+        sqlite3_exec(db, "UPDATE vectors SET code = NULL; DELETE FROM vector_meta WHERE key = 'codebook';",
+                     nullptr, nullptr, nullptr);
+        writeMeta("quantization", mode);
+    }
+
+    sqlite3_stmt* stmt;
+    if (quantizer_.needsTraining()) {
+        std::string codebook = readMeta("codebook");
+        if (codebook.empty() || !quantizer_.loadCodebook(codebook.data(), codebook.size())) {
+            // (Re)train from the stored vectors; old codes belong to another codebook
+            std::vector<float> rows;
+            size_t dims = static_cast<size_t>(quantizer_.dimensions());
+            rows.reserve(static_cast<size_t>(count) * dims);
+            if (sqlite3_prepare_v2(db, "SELECT embedding FROM vectors ORDER BY rowid", -1, &stmt, nullptr) == SQLITE_OK) {
+                while (sqlite3_step(stmt) == SQLITE_ROW) {
+                    const float* blob = static_cast<const float*>(sqlite3_column_blob(stmt, 0));
+                    if (blob && static_cast<size_t>(sqlite3_column_bytes(stmt, 0)) == dims * sizeof(float)) {
+                        rows.insert(rows.end(), blob, blob + dims);
+                    }
+                }
+                sqlite3_finalize(stmt);
+            }
+
+            sqlite3_exec(db, "UPDATE vectors SET code = NULL", nullptr, nullptr, nullptr);
+            if (!quantizer_.train(rows.data(), rows.size() / dims, dims)) {
+                sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+                return false;
+            }
+            writeMeta("codebook", quantizer_.serializeCodebook());
+        }
+    }
+
+    // Encode rows stored without a code
+    sqlite3_stmt* update_stmt;
+    if (sqlite3_prepare_v2(db, "SELECT rowid, embedding FROM vectors WHERE code IS NULL", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_prepare_v2(db, "UPDATE vectors SET code = ? WHERE rowid = ?", -1, &update_stmt, nullptr) == SQLITE_OK) {
+            std::vector<uint8_t> code(quantizer_.codeSize());
+            size_t expected = static_cast<size_t>(quantizer_.dimensions()) * sizeof(float);
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                const void* blob = sqlite3_column_blob(stmt, 1);
+                if (!blob || static_cast<size_t>(sqlite3_column_bytes(stmt, 1)) != expected) continue;
+
+                quantizer_.encode(static_cast<const float*>(blob), code.data());
+                sqlite3_bind_blob(update_stmt, 1, code.data(), static_cast<int>(code.size()), SQLITE_TRANSIENT);
+                sqlite3_bind_int64(update_stmt, 2, sqlite3_column_int64(stmt, 0));
+                sqlite3_step(update_stmt);
+                sqlite3_reset(update_stmt);
+            }
+            sqlite3_finalize(update_stmt);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+    return true;
+}
+
+std::string SQLiteVectorDB::readMeta(const std::string& key) {
+    std::string value;
+    auto* stmt = static_cast<sqlite3_stmt*>(statement("SELECT value FROM vector_meta WHERE key = ?"));
+    if (stmt) {
+        sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            const void* blob = sqlite3_column_blob(stmt, 0);
+            if (blob) value.assign(static_cast<const char*>(blob), sqlite3_column_bytes(stmt, 0));
+        }
+        sqlite3_reset(stmt);
+    }
+    return value;
+}
+
+void SQLiteVectorDB::writeMeta(const std::string& key, const std::string& value) {
+    auto* stmt = static_cast<sqlite3_stmt*>(statement("INSERT OR REPLACE INTO vector_meta (key, value) VALUES (?, ?)"));
+    if (stmt) {
+        sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_blob(stmt, 2, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// HNSW index persistence
+// ----------------------------------------------------------------------------
+
+bool SQLiteVectorDB::useIndex() const {
+    // The graph lags behind the table during a bulk load
+    return options_.hnsw_enabled && bulk_depth_ == 0 &&
+           static_cast<int64_t>(index_.liveCount()) >= options_.hnsw_min_documents;
+}
+
+void SQLiteVectorDB::loadIndex() {
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    index_.reset(&matrix_, matrix_.holdsCodes() ? &quantizer_ : nullptr);
+
+    // Read index metadata
+    std::map<std::string, std::string> meta;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT key, value FROM hnsw_meta", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* key = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            if (key && value) meta[key] = value;
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    int64_t vector_count = 0;
+    int64_t live_nodes = 0;
+    int64_t total_nodes = 0;
+    if (sqlite3_prepare_v2(db, "SELECT (SELECT COUNT(*) FROM vectors WHERE " DENSE_ROW "), "
+                               "(SELECT COUNT(*) FROM hnsw_nodes WHERE deleted = 0), "
+                               "(SELECT COUNT(*) FROM hnsw_nodes)", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            vector_count = sqlite3_column_int64(stmt, 0);
+            live_nodes = sqlite3_column_int64(stmt, 1);
+            total_nodes = sqlite3_column_int64(stmt, 2);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    // Entry point and top level, as written by persistIndex
+    int64_t entry_point = -1;
+    long long max_level = -1;
+    bool entry_valid = false;
+    if (meta.count("entry_point") && meta.count("max_level")) {
+        char* entry_end = nullptr;
+        char* level_end = nullptr;
+        const std::string& entry_text = meta["entry_point"];
+        const std::string& level_text = meta["max_level"];
+        entry_point = std::strtoll(entry_text.c_str(), &entry_end, 10);
+        max_level = std::strtoll(level_text.c_str(), &level_end, 10);
+        entry_valid = !entry_text.empty() && *entry_end == '\0' && !level_text.empty() && *level_end == '\0' &&
+                      entry_point >= -1 && entry_point < total_nodes && max_level >= -1 && max_level < 64;
+    }
+
+    // Rebuild if the stored graph is missing, was built with different
+    // parameters, is out of sync with the vectors table, is mostly
+    // tombstones or has no readable entry point
+    bool stale = meta.count("M") == 0 ||
+                 meta["M"] != std::to_string(options_.hnsw_m) ||
+                 live_nodes != vector_count ||
+                 (total_nodes - live_nodes) * 4 > total_nodes ||
+                 !entry_valid;
+    if (stale) {
+        rebuildIndex();
+        return;
+    }
+
+    // Nodes read their vectors from the resident matrix: float rows, or the
+    // codes themselves when it holds codes
+    const char* sql = "SELECT label, doc_id, level, deleted, links FROM hnsw_nodes ORDER BY label";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        rebuildIndex();
+        return;
+    }
+
+    // Rows are checked before they are restored: labels are dense (the
+    // primary key is unique, so every label below total_nodes is present
+    // exactly once), levels fit under the stored top level and links only
+    // name existing labels. Anything else is a damaged table.
+    bool invalid = false;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int64_t label = sqlite3_column_int64(stmt, 0);
+        const char* doc_id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        int64_t level = sqlite3_column_int64(stmt, 2);
+        bool deleted = sqlite3_column_int(stmt, 3) != 0;
+        if (!doc_id || label < 0 || label >= total_nodes || level < 0 || level > max_level) {
+            invalid = true;
+            break;
+        }
+
+        std::string id = doc_id;
+        auto links = HNSWIndex::deserializeLinks(sqlite3_column_blob(stmt, 4), sqlite3_column_bytes(stmt, 4));
+        bool links_valid = links.size() <= static_cast<size_t>(level) + 1;
+        for (const auto& layer : links) {
+            for (uint32_t neighbor : layer) {
+                links_valid = links_valid && neighbor < total_nodes;
+            }
+        }
+        if (!links_valid) {
+            invalid = true;
+            break;
+        }
+
+        int64_t row = deleted ? -1 : matrix_.rowOf(id);
+        if (!deleted && row < 0) {
+            invalid = true;
+            break;
+        }
+        index_.restoreNode(static_cast<uint32_t>(label), id, static_cast<int>(level), deleted, std::move(links), row);
+    }
+    sqlite3_finalize(stmt);
+
+    index_.restoreEntryPoint(entry_point, static_cast<int>(max_level));
+    if (invalid || index_.size() != static_cast<size_t>(total_nodes) || !index_.linksConsistent()) {
+        rebuildIndex();
+        return;
+    }
+
+    index_.detachDeleted();
+    index_.takeDirty();
+}
+
+void SQLiteVectorDB::rebuildIndex() {
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    index_.reset(&matrix_, matrix_.holdsCodes() ? &quantizer_ : nullptr);
+
+    bool own_txn = sqlite3_get_autocommit(db) != 0;
+    if (own_txn) sqlite3_exec(db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+    sqlite3_exec(db, "DELETE FROM hnsw_nodes; DELETE FROM hnsw_meta;", nullptr, nullptr, nullptr);
+
+    if (matrix_.holdsCodes()) {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "SELECT id, embedding FROM vectors WHERE " DENSE_ROW " ORDER BY rowid",
+                               -1, &stmt, nullptr) == SQLITE_OK) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                const void* blob = sqlite3_column_blob(stmt, 1);
+                int blob_size = sqlite3_column_bytes(stmt, 1);
+                if (!blob) continue;
+                indexDocument(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                              deserializeEmbedding(std::string(static_cast<const char*>(blob), blob_size)));
+            }
+            sqlite3_finalize(stmt);
+        }
+    } else {
+        Embedding emb;
+        for (size_t row = 0; row < matrix_.size(); row++) {
+            const float* vec = matrix_.rowAt(row);
+            emb.assign(vec, vec + matrix_.dimensions());
+            indexDocument(matrix_.idAt(row), emb);
+        }
+    }
+
+    persistIndex();
+    if (own_txn) sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+}
+
+void SQLiteVectorDB::indexDocument(const std::string& id, const Embedding& embedding) {
+    if (embedding.empty()) return;
+    if (index_.getDimensions() != 0 && index_.getDimensions() != static_cast<int>(embedding.size())) {
+        index_.markDeleted(id);
+        return;
+    }
+    index_.add(id, embedding);
+}
+
+void SQLiteVectorDB::persistIndex() {
+    auto dirty = index_.takeDirty();
+    if (dirty.empty()) return;
+
+    auto* stmt = static_cast<sqlite3_stmt*>(
+        statement("INSERT OR REPLACE INTO hnsw_nodes (label, doc_id, level, deleted, links) VALUES (?, ?, ?, ?, ?)"));
+    if (stmt) {
+        for (uint32_t label : dirty) {
+            const auto& node = index_.node(label);
+            std::string links = HNSWIndex::serializeLinks(node.links);
+
+            sqlite3_bind_int64(stmt, 1, label);
+            sqlite3_bind_text(stmt, 2, node.id.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(stmt, 3, node.level);
+            sqlite3_bind_int(stmt, 4, node.deleted ? 1 : 0);
+            sqlite3_bind_blob(stmt, 5, links.data(), static_cast<int>(links.size()), SQLITE_TRANSIENT);
+            sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+        }
+    }
+
+    stmt = static_cast<sqlite3_stmt*>(statement("INSERT OR REPLACE INTO hnsw_meta (key, value) VALUES (?, ?)"));
+    if (stmt) {
+        const std::pair<std::string, std::string> values[] = {
+            {"M", std::to_string(index_.getParams().M)},
+            {"dimensions", std::to_string(index_.getDimensions())},
+            {"entry_point", std::to_string(index_.entryPoint())},
+            {"max_level", std::to_string(index_.maxLevel())},
+        };
+        for (const auto& kv : values) {
+            sqlite3_bind_text(stmt, 1, kv.first.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, kv.second.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+        }
+    }
+}
+
+std::vector<std::string> SQLiteVectorDB::idsForSource(const std::string& source) {
+    std::vector<std::string> ids;
+
+    auto* stmt = static_cast<sqlite3_stmt*>(statement("SELECT id FROM vectors WHERE source = ?"));
+    if (stmt) {
+        sqlite3_bind_text(stmt, 1, source.c_str(), -1, SQLITE_TRANSIENT);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            ids.push_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+        }
+        sqlite3_reset(stmt);
+    }
+    return ids;
+}
+
+// ----------------------------------------------------------------------------
+// CRUD
+// ----------------------------------------------------------------------------
+
 bool SQLiteVectorDB::insert(const VectorDocument& doc) {
     if (!db_) return false;
 
-    sqlite3_stmt* stmt;
-    const char* sql = "INSERT OR REPLACE INTO vectors (id, content, source, metadata, embedding, dimensions, timestamp) VALUES (?, ?, ?, ?, ?, ?, ?)";
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    bool own_txn = options_.hnsw_enabled && sqlite3_get_autocommit(db) != 0;
+    if (own_txn) sqlite3_exec(db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+    bool success = insertRow(doc);
+    if (success && options_.hnsw_enabled) {
+        persistIndex();
+    }
+
+    if (own_txn) sqlite3_exec(db, success ? "COMMIT" : "ROLLBACK", nullptr, nullptr, nullptr);
+    if (success) commitBulkProgress();
+    return success;
+}
+
+bool SQLiteVectorDB::insertRow(const VectorDocument& doc) {
+    auto* stmt = static_cast<sqlite3_stmt*>(statement(
+        "INSERT OR REPLACE INTO vectors (id, content, source, metadata, embedding, dimensions, timestamp, norm, code) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+    if (!stmt) return false;
+
+    // Rows are stored unit-length so search is a plain dot product. Vectors
+    // already normalized by VectorDB carry their original length in doc.norm.
+    Embedding embedding = doc.embedding;
+    float norm = normalizeInPlace(embedding);
+    if (std::fabs(norm - 1.0f) <= 1e-5f && doc.norm > 0.0f) {
+        norm = doc.norm;
+    }
+
+    std::string id = doc.id.empty() ? generateId() : doc.id;
+    int dims = static_cast<int>(doc.embedding.size());
+
+    SparseVector sparse;
+    bool is_sparse = false;
+    if (options_.sparse_vectors && dims > 0) {
+        sparse = SparseIndex::fromDense(embedding.data(), embedding.size());
+        is_sparse = SparseIndex::worthStoring(sparse.size(), embedding.size());
+    }
+    std::string emb_data = is_sparse ? SparseIndex::serialize(sparse, dims) : serializeEmbedding(embedding);
+    int64_t ts = doc.timestamp > 0 ? doc.timestamp :
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
+
+    if (dimensions_ == 0) dimensions_ = dims;
+
+    // The first dense row of an empty table fixes the code layout
+    if (!is_sparse && quantizer_.mode() != QuantizationMode::None && quantizer_.dimensions() == 0 && matrix_.empty()) {
+        quantizer_.configure(quantizer_.mode(), dims);
+        if (quantizer_.ready()) {
+            writeMeta("quantization", VectorQuantizer::modeName(quantizer_.mode()));
+            matrix_.resetCodes(dims, quantizer_.codeSize());
+            // The graph holds tombstones at most; it keeps codes from now on too
+            if (options_.hnsw_enabled) {
+                sqlite3_exec(static_cast<sqlite3*>(db_), "DELETE FROM hnsw_nodes; DELETE FROM hnsw_meta;",
+                             nullptr, nullptr, nullptr);
+                index_.reset(&matrix_, &quantizer_);
+            }
+        }
+    }
+
+    std::vector<uint8_t> code;
+    if (!is_sparse && matrix_.holdsCodes() && dims == quantizer_.dimensions()) {
+        code.resize(quantizer_.codeSize());
+        quantizer_.encode(embedding.data(), code.data());
+    }
+
+    sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, doc.content.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, doc.source.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, doc.metadata.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_blob(stmt, 5, emb_data.data(), static_cast<int>(emb_data.size()), SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 6, dims);
+    sqlite3_bind_int64(stmt, 7, ts);
+    sqlite3_bind_double(stmt, 8, norm);
+    if (code.empty()) {
+        sqlite3_bind_null(stmt, 9);
+    } else {
+        sqlite3_bind_blob(stmt, 9, code.data(), static_cast<int>(code.size()), SQLITE_TRANSIENT);
+    }
+
+    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_reset(stmt);
+
+    if (success && is_sparse) {
+        // Replaces a dense row of the same id, if there was one
+        removeResident(id);
+        sparse_.upsert(id, sparse, dims);
+    } else if (success) {
+        sparse_.remove(id);
+        // The graph reads the row being overwritten: retire its node first
+        index_.markDeleted(id);
+        if (matrix_.holdsCodes() ? code.empty() : (matrix_.dimensions() != 0 && matrix_.dimensions() != dims)) {
+            removeResident(id);
+        } else if (matrix_.holdsCodes()) {
+            matrix_.upsertCode(id, code.data(), code.size());
+        } else {
+            matrix_.upsert(id, embedding);
+        }
+        if (bulk_depth_ > 0) {
+            if (options_.hnsw_enabled) bulk_pending_.push_back(id);
+            bulk_rows_++;
+        } else if (options_.hnsw_enabled) {
+            indexDocument(id, embedding);
+        }
+    }
+    return success;
+}
+
+bool SQLiteVectorDB::insertBatch(const std::vector<VectorDocument>& docs) {
+    if (!db_) return false;
+
+    sqlite3* db = static_cast<sqlite3*>(db_);
+
+    // A savepoint opens its own transaction, or nests inside a bulk load
+    sqlite3_exec(db, "SAVEPOINT insert_batch", nullptr, nullptr, nullptr);
+
+    for (const auto& doc : docs) {
+        if (!insertRow(doc)) {
+            sqlite3_exec(db, "ROLLBACK TO insert_batch; RELEASE insert_batch", nullptr, nullptr, nullptr);
+            // The resident copies may now reference rolled back rows
+            if (bulk_depth_ > 0) bulk_pending_.clear();
+            loadResident();
+            if (options_.hnsw_enabled && bulk_depth_ == 0) loadIndex();
+            return false;
+        }
+    }
+
+    if (options_.hnsw_enabled && bulk_depth_ == 0) {
+        persistIndex();
+    }
+
+    sqlite3_exec(db, "RELEASE insert_batch", nullptr, nullptr, nullptr);
+    commitBulkProgress();
+
+    // Switch to PQ codes once there is enough data to train a codebook
+    if (quantizer_.needsTraining() && !matrix_.holdsCodes() &&
+        matrix_.size() >= VectorQuantizer::kMinTrainingRows) {
+        loadResident();
+        if (options_.hnsw_enabled && bulk_depth_ == 0) loadIndex();
+    }
+    return true;
+}
+
+// Bulk loads commit every kBulkCommitRows rows so the WAL stays bounded
+static const int64_t kBulkCommitRows = 8192;
+
+void SQLiteVectorDB::commitBulkProgress() {
+    if (bulk_depth_ == 0 || bulk_rows_ < kBulkCommitRows) return;
+    sqlite3_exec(static_cast<sqlite3*>(db_), "COMMIT; BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+    bulk_rows_ = 0;
+}
+
+void SQLiteVectorDB::beginBulkLoad() {
+    if (!db_ || bulk_depth_++ > 0) return;
+
+    bulk_rows_ = 0;
+    bulk_pending_.clear();
+
+    // idx_timestamp is rebuilt in one pass at the end. idx_source stays, since
+    // re-ingesting a file looks up and removes its previous chunks by source.
+    sqlite3_exec(static_cast<sqlite3*>(db_), "BEGIN TRANSACTION; DROP INDEX IF EXISTS idx_timestamp;",
+                 nullptr, nullptr, nullptr);
+}
+
+void SQLiteVectorDB::endBulkLoad() {
+    if (!db_ || bulk_depth_ == 0 || --bulk_depth_ > 0) return;
+
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    sqlite3_exec(db, "CREATE INDEX IF NOT EXISTS idx_timestamp ON vectors(timestamp)", nullptr, nullptr, nullptr);
+
+    if (options_.hnsw_enabled && !bulk_pending_.empty()) {
+        if (bulk_pending_.size() >= index_.liveCount() || index_.holdsCodes() != matrix_.holdsCodes()) {
+            // Mostly new data, or the matrix switched to PQ codes during the
+            // load: build the graph from scratch, which also drops tombstones
+            rebuildIndex();
+        } else {
+            std::set<std::string> seen;
+            Embedding emb;
+            for (const auto& id : bulk_pending_) {
+                if (!seen.insert(id).second) continue;
+
+                int64_t row = matrix_.holdsCodes() ? -1 : matrix_.rowOf(id);
+                if (row >= 0) {
+                    const float* vec = matrix_.rowAt(static_cast<size_t>(row));
+                    emb.assign(vec, vec + matrix_.dimensions());
+                } else {
+                    // Codes only (or removed since): read the stored floats
+                    auto* stmt = static_cast<sqlite3_stmt*>(statement("SELECT embedding FROM vectors WHERE id = ?"));
+                    if (!stmt) break;
+                    sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+                    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+                    if (found) {
+                        const void* blob = sqlite3_column_blob(stmt, 0);
+                        int blob_size = sqlite3_column_bytes(stmt, 0);
+                        emb = deserializeEmbedding(std::string(static_cast<const char*>(blob), blob_size));
+                    }
+                    sqlite3_reset(stmt);
+                    if (!found) continue;
+                }
+                indexDocument(id, emb);
+            }
+            persistIndex();
+        }
+    }
+
+    sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+    bulk_pending_.clear();
+    bulk_pending_.shrink_to_fit();
+    bulk_rows_ = 0;
+
+    if (quantizer_.needsTraining() && !matrix_.holdsCodes() &&
+        matrix_.size() >= VectorQuantizer::kMinTrainingRows) {
+        loadResident();
+        if (options_.hnsw_enabled) loadIndex();
+    }
+}
+
+bool SQLiteVectorDB::update(const VectorDocument& doc) {
+    return insert(doc);  // INSERT OR REPLACE handles updates
+}
+
+bool SQLiteVectorDB::remove(const std::string& id) {
+    if (!db_) return false;
+
+    auto* stmt = static_cast<sqlite3_stmt*>(statement("DELETE FROM vectors WHERE id = ?"));
+    if (!stmt) return false;
+
+    sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_reset(stmt);
+
+    if (success) {
+        bool indexed = index_.contains(id);
+        removeResident(id);
+        sparse_.remove(id);
+        if (options_.hnsw_enabled && indexed) {
+            persistIndex();
+        }
+    }
+    return success;
+}
+
+bool SQLiteVectorDB::updateMetadata(const std::string& id, const std::string& metadata) {
+    if (!db_) return false;
+
+    auto* stmt = static_cast<sqlite3_stmt*>(statement("UPDATE vectors SET metadata = ? WHERE id = ?"));
+    if (!stmt) return false;
+
+    sqlite3_bind_text(stmt, 1, metadata.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
+    bool success = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(static_cast<sqlite3*>(db_)) > 0;
+    sqlite3_reset(stmt);
+    return success;
+}
+
+bool SQLiteVectorDB::removeBySource(const std::string& source) {
+    if (!db_) return false;
+
+    std::vector<std::string> ids = idsForSource(source);
+
+    auto* stmt = static_cast<sqlite3_stmt*>(statement("DELETE FROM vectors WHERE source = ?"));
+    if (!stmt) return false;
+
+    sqlite3_bind_text(stmt, 1, source.c_str(), -1, SQLITE_TRANSIENT);
+    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_reset(stmt);
+
+    if (success && !ids.empty()) {
+        for (const auto& id : ids) {
+            removeResident(id);
+            sparse_.remove(id);
+        }
+        if (options_.hnsw_enabled) {
+            persistIndex();
+        }
+    }
+    return success;
+}
+
+std::vector<VectorSearchResult> SQLiteVectorDB::search(const Embedding& query, int top_k, float threshold,
+                                                      const SearchFilter& filter) {
+    std::vector<VectorSearchResult> results;
+    if (!db_) return results;
+
+    results = searchDense(query, top_k, threshold, filter);
+    if (sparse_.empty() || static_cast<int>(query.size()) != sparse_.dimensions() || top_k <= 0) {
+        return results;
+    }
+
+    // Sparse rows are scored through the inverted index, then merged with
+    // the dense hits; only the winners are read from the table
+    std::vector<std::string> allowed;
+    if (!filter.empty()) {
+        allowed = filteredIds(filter);
+        if (allowed.empty()) return results;
+    }
+    Embedding unit_query = EmbeddingClient::normalize(query);
+    auto hits = sparse_.search(SparseIndex::fromDense(unit_query.data(), unit_query.size()),
+                               static_cast<size_t>(top_k), threshold, filter.empty() ? nullptr : &allowed);
+    if (hits.empty()) return results;
+
+    std::vector<VectorSearchResult> merged;
+    size_t dense = 0;
+    size_t sparse = 0;
+    while (static_cast<int>(merged.size()) < top_k && (dense < results.size() || sparse < hits.size())) {
+        if (sparse == hits.size() || (dense < results.size() && results[dense].score >= hits[sparse].first)) {
+            merged.push_back(std::move(results[dense++]));
+            continue;
+        }
+        VectorSearchResult res;
+        res.document = getResult(hits[sparse].second);
+        res.score = hits[sparse].first;
+        res.distance = 1.0f - res.score;
+        sparse++;
+        if (!res.document.id.empty()) merged.push_back(std::move(res));
+    }
+    return merged;
+}
+
+// A filter matching fewer rows than this many times the HNSW candidate list
+// is scanned exactly: the graph would need too wide a search to find enough
+// of them
+static const size_t kFilterScanFactor = 4;
+
+// Search over the resident matrix or HNSW graph, which hold every row that
+// is not stored sparsely
+std::vector<VectorSearchResult> SQLiteVectorDB::searchDense(const Embedding& query, int top_k, float threshold,
+                                                           const SearchFilter& filter) {
+    std::vector<VectorSearchResult> results;
+
+    // Approximate search through the HNSW graph once the corpus is large
+    // enough. A filter is checked on the graph's candidates as long as it
+    // keeps a good share of the rows; a selective one scans its subset exactly.
+    if (useIndex() && static_cast<int>(query.size()) == index_.getDimensions() &&
+        (filter.empty() || filterReaches(filter, kFilterScanFactor * static_cast<size_t>(
+                                                     std::max(options_.hnsw_ef_search, top_k))))) {
+        if (searchGraph(query, top_k, threshold, filter, results)) {
+            return results;
+        }
+    }
+
+    // Exact scan over the resident matrix; text columns are only read for the winners
+    if (matrix_.empty() || static_cast<int>(query.size()) != matrix_.dimensions()) {
+        return results;
+    }
+
+    // Stored rows are unit-length, so cosine similarity is a dot product
+    // with the normalized query
+    Embedding unit_query = EmbeddingClient::normalize(query);
+
+    // Predicates are resolved through the SQL indexes first, so only the
+    // matching rows are scored
+    std::vector<size_t> subset;
+    bool filtered = !filter.empty();
+    if (filtered) {
+        subset = filteredRows(filter);
+        if (subset.empty()) return results;
+    }
+
+    if (matrix_.holdsCodes()) {
+        return searchCodes(unit_query, top_k, threshold, filtered ? &subset : nullptr);
+    }
+
+    size_t candidates = filtered ? subset.size() : matrix_.size();
+    WorkerPool* pool = scanPool(candidates);
+    TopKSelector top = parallelTopK(pool, candidates, static_cast<size_t>(std::max(top_k, 0)), threshold,
+                                    pool ? pool->size() : 1,
+        [&](size_t begin, size_t end, TopKSelector& part) {
+            if (filtered) {
+                for (size_t i = begin; i < end; i++) {
+                    float score = simd::dot(unit_query.data(), matrix_.rowAt(subset[i]), unit_query.size());
+                    if (score >= part.bound()) {
+                        part.push(score, subset[i]);
+                    }
+                }
+                return;
+            }
+
+            const size_t block = 256;
+            float scores[block];
+            for (size_t start = begin; start < end; start += block) {
+                size_t count = std::min(block, end - start);
+                EmbeddingClient::dotProductBatch(unit_query, matrix_.rowAt(start), count, matrix_.stride(), scores);
+
+                for (size_t i = 0; i < count; i++) {
+                    if (scores[i] >= part.bound()) {
+                        part.push(scores[i], start + i);
+                    }
+                }
+            }
+        });
+
+    for (const auto& hit : top.take()) {
+        VectorSearchResult res;
+        res.document = getResult(matrix_.idAt(hit.second));
+        if (res.document.id.empty()) continue;
+        res.score = hit.first;
+        res.distance = 1.0f - res.score;
+        results.push_back(res);
+    }
+
+    return results;
+}
+
+// Search through the HNSW graph. With a filter the graph is asked for a
+// wider candidate list, checked against the filter, and widened again while
+// too few candidates pass; false means the filter rejects so much that the
+// caller should scan its subset exactly instead.
+bool SQLiteVectorDB::searchGraph(const Embedding& query, int top_k, float threshold, const SearchFilter& filter,
+                                 std::vector<VectorSearchResult>& results) {
+    // Graph similarities from codes are re-ranked exactly: widen, and keep
+    // candidates slightly below the threshold
+    const bool codes = index_.holdsCodes();
+    const size_t wanted = codes ? rerankCandidates(top_k) : static_cast<size_t>(std::max(top_k, 0));
+    const float floor = codes ? threshold - rerankSlack() : threshold;
+
+    std::vector<std::pair<std::string, float>> hits;
+    if (filter.empty()) {
+        hits = index_.search(query, static_cast<int>(wanted));
+    } else {
+        size_t candidates = std::max(wanted, static_cast<size_t>(std::max(options_.hnsw_ef_search, 1))) * 2;
+        while (true) {
+            auto found = index_.search(query, static_cast<int>(candidates), static_cast<int>(candidates));
+            std::vector<std::string> ids;
+            for (const auto& hit : found) {
+                if (hit.second < floor) break;
+                ids.push_back(hit.first);
+            }
+            auto allowed = filteredIds(filter, &ids);
+            std::set<std::string> passed(allowed.begin(), allowed.end());
+
+            hits.clear();
+            for (const auto& hit : found) {
+                if (hits.size() == wanted) break;
+                if (passed.count(hit.first)) hits.push_back(hit);
+            }
+            // Done once enough candidates pass, the graph has nothing more to
+            // give, or the rest scores below the threshold
+            if (hits.size() == wanted || found.size() < candidates || ids.size() < found.size()) break;
+
+            // The share of candidates that passed estimates how many rows
+            // match; once that is only a few times the next candidate list,
+            // scanning them exactly is cheaper
+            candidates *= 4;
+            size_t matching = index_.liveCount() * hits.size() / ids.size();
+            if (matching < candidates * kFilterScanFactor) return false;
+        }
+    }
+
+    if (codes) {
+        std::vector<std::string> ids;
+        for (const auto& hit : hits) {
+            if (hit.second < floor) break;
+            ids.push_back(hit.first);
+        }
+        results = rerankExact(EmbeddingClient::normalize(query), ids, top_k, threshold);
+        return true;
+    }
+    for (const auto& hit : hits) {
+        if (hit.second < threshold) break;
+
+        VectorSearchResult res;
+        res.document = getResult(hit.first);
+        if (res.document.id.empty()) continue;
+        res.score = hit.second;
+        res.distance = 1.0f - res.score;
+        results.push_back(res);
+    }
+    return true;
+}
+
+// Words too common to help a keyword query
+static const std::set<std::string>& stopwords() {
+    static const std::set<std::string> words = {
+        "about", "an", "and", "are", "as", "at", "be", "by", "can", "could", "do", "does", "for",
+        "from", "get", "has", "have", "how", "if", "in", "into", "is", "it", "its", "me", "my",
+        "no", "not", "of", "on", "or", "our", "should", "that", "the", "then", "there", "this",
+        "to", "us", "was", "we", "what", "when", "where", "which", "who", "why", "will", "with",
+        "would", "you", "your"
+    };
+    return words;
+}
 
-    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        return false;
+// FTS5 MATCH expression for free text: each distinct word as a quoted term,
+// OR-ed so BM25 ranks documents by how many and how rare the matches are
+static std::string ftsQuery(const std::string& text) {
+    std::set<std::string> seen;
+    std::string match;
+    std::string word;
+
+    auto flush = [&]() {
+        if (word.size() > 1) {
+            std::string lower = word;
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            if (!stopwords().count(lower) && seen.insert(lower).second) {
+                if (!match.empty()) match += " OR ";
+                match += "\"" + word + "\"";
+            }
+        }
+        word.clear();
+    };
+
+    for (unsigned char c : text) {
+        if (std::isalnum(c) || c == '_' || c >= 0x80) {
+            word += static_cast<char>(c);
+        } else {
+            flush();
+        }
     }
+    flush();
+    return match;
+}
 
-    std::string id = doc.id.empty() ? generateId() : doc.id;
-    std::string emb_data = serializeEmbedding(doc.embedding);
-    int dims = static_cast<int>(doc.embedding.size());
-    int64_t ts = doc.timestamp > 0 ? doc.timestamp :
-        std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::system_clock::now().time_since_epoch()
-        ).count();
+// SQL conditions for a filter, each starting with " AND ", over the
+// source, metadata and timestamp columns of vectors. Parameters are numbered
+// from first: the source prefix bounds, the timestamp bounds, then four per
+// metadata key. Source prefix and timestamp bounds become range conditions
+// that SQLite answers from idx_source / idx_timestamp. Metadata keys are
+// looked up with json_each, the key bound as a parameter, and compared by
+// JSON type as metadataValueEquals does: strings as text, numbers
+// numerically, booleans as true/1 or false/0. Arrays, objects and null pass
+// through to SearchFilter::matches, which every row with a metadata filter
+// is finally checked against.
+static std::string filterConditions(const SearchFilter& filter, int first) {
+    auto param = [&](int offset) { return "?" + std::to_string(first + offset); };
+
+    std::string sql;
+    if (!filter.source_prefix.empty()) sql += " AND source >= " + param(0) + " AND source < " + param(1);
+    if (filter.min_timestamp > 0) sql += " AND timestamp >= " + param(2);
+    if (filter.max_timestamp > 0) sql += " AND timestamp <= " + param(3);
+    int offset = 4;
+    for (size_t i = 0; i < filter.metadata.size(); i++, offset += 4) {
+        sql += " AND CASE WHEN json_valid(metadata) AND json_type(metadata) = 'object' THEN EXISTS ("
+               "SELECT 1 FROM json_each(metadata) WHERE key = " + param(offset) + " AND ("
+               "(type = 'text' AND value = " + param(offset + 1) + ") OR "
+               "(type IN ('integer', 'real') AND value = " + param(offset + 2) + ") OR "
+               "type = " + param(offset + 3) + " OR type IN ('null', 'array', 'object'))) ELSE 0 END";
+    }
+    return sql;
+}
 
-    if (dimensions_ == 0) dimensions_ = dims;
+static void bindFilter(sqlite3_stmt* stmt, const SearchFilter& filter, int first) {
+    if (!filter.source_prefix.empty()) {
+        // Every string with the prefix sorts below prefix + 0xFF (never valid UTF-8)
+        std::string upper = filter.source_prefix + '\xFF';
+        sqlite3_bind_text(stmt, first, filter.source_prefix.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, first + 1, upper.c_str(), static_cast<int>(upper.size()), SQLITE_TRANSIENT);
+    }
+    if (filter.min_timestamp > 0) sqlite3_bind_int64(stmt, first + 2, filter.min_timestamp);
+    if (filter.max_timestamp > 0) sqlite3_bind_int64(stmt, first + 3, filter.max_timestamp);
+
+    int param = first + 4;
+    for (const auto& kv : filter.metadata) {
+        const std::string& value = kv.second;
+        sqlite3_bind_text(stmt, param, kv.first.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, param + 1, value.c_str(), -1, SQLITE_TRANSIENT);
+
+        // Unbound parameters are NULL and never compare equal
+        double number;
+        if (parseMetadataNumber(value, number)) sqlite3_bind_double(stmt, param + 2, number);
+        if (value == "true" || value == "1") sqlite3_bind_text(stmt, param + 3, "true", -1, SQLITE_STATIC);
+        if (value == "false" || value == "0") sqlite3_bind_text(stmt, param + 3, "false", -1, SQLITE_STATIC);
+        param += 4;
+    }
+}
 
-    sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, doc.content.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, doc.source.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, doc.metadata.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_blob(stmt, 5, emb_data.data(), static_cast<int>(emb_data.size()), SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 6, dims);
-    sqlite3_bind_int64(stmt, 7, ts);
+// Rows fetched per result for keyword queries with a metadata filter
+static const int64_t kTextFilterOverfetch = 4;
 
-    bool success = sqlite3_step(stmt) == SQLITE_DONE;
-    sqlite3_finalize(stmt);
-    return success;
-}
+std::vector<VectorSearchResult> SQLiteVectorDB::searchText(const std::string& query, int top_k,
+                                                           const SearchFilter& filter) {
+    std::vector<VectorSearchResult> results;
+    if (!db_ || !text_search_ || top_k <= 0) return results;
+
+    std::string match = ftsQuery(query);
+    if (match.empty()) return results;
+
+    // Ranked by BM25, with the filter applied in SQL so LIMIT cuts the
+    // ranking short; parameter 1 is the match expression, 2 the limit
+    static const char* kTextSql =
+        "SELECT v.id, v.content, v.source, v.metadata, v.timestamp, v.norm, vectors_fts.rank "
+        "FROM vectors_fts JOIN vectors v ON v.rowid = vectors_fts.rowid "
+        "WHERE vectors_fts MATCH ?1";
+    static const char* kTextOrder = " ORDER BY vectors_fts.rank LIMIT ?2";
+
+    std::lock_guard<std::mutex> lock(text_mutex_);
+    if (!text_stmt_) {
+        // A read-only connection sees the last commit without waiting on the
+        // writer (WAL). In-memory databases exist only on their own connection.
+        sqlite3* reader = static_cast<sqlite3*>(db_);
+        if (!db_path_.empty() && db_path_ != ":memory:") {
+            sqlite3* conn = nullptr;
+            if (sqlite3_open_v2(db_path_.c_str(), &conn, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK) {
+                std::string pragmas = "PRAGMA mmap_size = " + std::to_string(options_.sqlite_mmap_bytes) + ";";
+                sqlite3_exec(conn, pragmas.c_str(), nullptr, nullptr, nullptr);
+                read_db_ = conn;
+                reader = conn;
+            } else {
+                sqlite3_close(conn);
+            }
+        }
 
-bool SQLiteVectorDB::insertBatch(const std::vector<VectorDocument>& docs) {
-    if (!db_) return false;
+        // Unfiltered queries reuse one statement
+        std::string sql = std::string(kTextSql) + kTextOrder;
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v3(reader, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "SQLite keyword search error: " << sqlite3_errmsg(reader) << std::endl;
+            return results;
+        }
+        text_stmt_ = stmt;
+    }
 
-    sqlite3_exec(static_cast<sqlite3*>(db_), "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+    sqlite3_stmt* stmt = static_cast<sqlite3_stmt*>(text_stmt_);
+    if (!filter.empty()) {
+        sqlite3* reader = static_cast<sqlite3*>(read_db_ ? read_db_ : db_);
+        std::string sql = kTextSql + filterConditions(filter, 3) + kTextOrder;
+        stmt = nullptr;
+        if (sqlite3_prepare_v2(reader, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "SQLite keyword search error: " << sqlite3_errmsg(reader) << std::endl;
+            return results;
+        }
+        bindFilter(stmt, filter, 3);
+    }
 
-    for (const auto& doc : docs) {
-        if (!insert(doc)) {
-            sqlite3_exec(static_cast<sqlite3*>(db_), "ROLLBACK", nullptr, nullptr, nullptr);
-            return false;
+    // Metadata conditions let some JSON types through to SearchFilter::matches,
+    // so those queries fetch more rows, and more again if too many fail it
+    int64_t limit = static_cast<int64_t>(top_k) * (filter.metadata.empty() ? 1 : kTextFilterOverfetch);
+    while (true) {
+        sqlite3_reset(stmt);
+        sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 2, limit);
+
+        int64_t rows = 0;
+        results.clear();
+        while (static_cast<int>(results.size()) < top_k && sqlite3_step(stmt) == SQLITE_ROW) {
+            rows++;
+            VectorDocument doc;
+            const char* source = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+            const char* metadata = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+            doc.source = source ? source : "";
+            doc.metadata = metadata ? metadata : "";
+            doc.timestamp = sqlite3_column_int64(stmt, 4);
+            if (!filter.metadata.empty() && !filter.matches(doc.source, doc.metadata, doc.timestamp)) continue;
+
+            doc.id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            doc.content = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            doc.norm = static_cast<float>(sqlite3_column_double(stmt, 5));
+
+            // bm25() is negative, lower is better; squash it into (0, 1)
+            double relevance = std::max(0.0, -sqlite3_column_double(stmt, 6));
+            VectorSearchResult res;
+            res.document = std::move(doc);
+            res.score = static_cast<float>(relevance / (1.0 + relevance));
+            res.distance = static_cast<float>(-relevance);
+            results.push_back(std::move(res));
         }
+        if (static_cast<int>(results.size()) == top_k || rows < limit) break;
+        limit *= kTextFilterOverfetch;
     }
 
-    sqlite3_exec(static_cast<sqlite3*>(db_), "COMMIT", nullptr, nullptr, nullptr);
-    return true;
+    if (stmt == text_stmt_) {
+        sqlite3_reset(stmt);
+    } else {
+        sqlite3_finalize(stmt);
+    }
+    return results;
 }
 
-bool SQLiteVectorDB::update(const VectorDocument& doc) {
-    return insert(doc);  // INSERT OR REPLACE handles updates
+// Worker pool for brute-force scans, or nullptr when the collection is too
+// small for the fan-out to pay off or only one thread is configured
+WorkerPool* SQLiteVectorDB::scanPool(size_t rows) {
+    if (options_.search_threads == 1 ||
+        static_cast<int64_t>(rows) < options_.parallel_min_documents) {
+        return nullptr;
+    }
+    if (!pool_) {
+        pool_ = std::make_unique<WorkerPool>(static_cast<size_t>(std::max(options_.search_threads, 0)));
+    }
+    return pool_->size() > 1 ? pool_.get() : nullptr;
 }
 
-bool SQLiteVectorDB::remove(const std::string& id) {
-    if (!db_) return false;
+// Ids of the documents matching a filter, optionally only among the given ids
+std::vector<std::string> SQLiteVectorDB::filteredIds(const SearchFilter& filter, const std::vector<std::string>* among) {
+    std::vector<std::string> ids;
+    if (among && among->empty()) return ids;
 
-    sqlite3_stmt* stmt;
-    const char* sql = "DELETE FROM vectors WHERE id = ?";
+    std::string sql = "SELECT id, source, metadata, timestamp FROM vectors WHERE 1";
+    if (among) sql += " AND id IN (SELECT value FROM json_each(?1))";
+    sql += filterConditions(filter, 2);
 
-    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        return false;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQLite filter error: " << sqlite3_errmsg(static_cast<sqlite3*>(db_)) << std::endl;
+        return ids;
     }
+    if (among) {
+        std::string list = json(*among).dump();
+        sqlite3_bind_text(stmt, 1, list.c_str(), static_cast<int>(list.size()), SQLITE_TRANSIENT);
+    }
+    bindFilter(stmt, filter, 2);
 
-    sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
-    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (!filter.metadata.empty()) {
+            const char* source = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            const char* metadata = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+            if (!filter.matches(source ? source : "", metadata ? metadata : "", sqlite3_column_int64(stmt, 3))) {
+                continue;
+            }
+        }
+        ids.push_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+    }
     sqlite3_finalize(stmt);
-    return success;
+    return ids;
 }
 
-bool SQLiteVectorDB::removeBySource(const std::string& source) {
-    if (!db_) return false;
+// Whether at least count rows pass the SQL side of a filter; the count
+// stops there, so a broad filter costs no more than a selective one
+bool SQLiteVectorDB::filterReaches(const SearchFilter& filter, size_t count) {
+    std::string sql = "SELECT COUNT(*) FROM (SELECT 1 FROM vectors WHERE 1" + filterConditions(filter, 2) + " LIMIT ?1)";
 
     sqlite3_stmt* stmt;
-    const char* sql = "DELETE FROM vectors WHERE source = ?";
-
-    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQLite filter error: " << sqlite3_errmsg(static_cast<sqlite3*>(db_)) << std::endl;
         return false;
     }
+    sqlite3_bind_int64(stmt, 1, static_cast<int64_t>(count));
+    bindFilter(stmt, filter, 2);
 
-    sqlite3_bind_text(stmt, 1, source.c_str(), -1, SQLITE_TRANSIENT);
-    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    bool reaches = sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int64(stmt, 0) >= static_cast<int64_t>(count);
     sqlite3_finalize(stmt);
-    return success;
+    return reaches;
 }
 
-std::vector<VectorSearchResult> SQLiteVectorDB::search(const Embedding& query, int top_k, float threshold) {
-    std::vector<VectorSearchResult> results;
-    if (!db_) return results;
-
-    // Load all vectors and compute similarity (brute force for SQLite)
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id, content, source, metadata, embedding, timestamp FROM vectors";
-
-    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        return results;
+// Resident matrix rows of the documents matching a filter, in row order
+std::vector<size_t> SQLiteVectorDB::filteredRows(const SearchFilter& filter) {
+    std::vector<size_t> rows;
+    for (const auto& id : filteredIds(filter)) {
+        int64_t row = matrix_.rowOf(id);
+        if (row >= 0) rows.push_back(static_cast<size_t>(row));
     }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
 
-    std::vector<VectorSearchResult> all_results;
+// Two-pass search over quantized codes: approximate scores pick
+// top_k * rerank_factor candidates, whose float embeddings are then read back
+// from the vectors table and scored exactly.
+std::vector<VectorSearchResult> SQLiteVectorDB::searchCodes(const Embedding& unit_query, int top_k, float threshold,
+                                                           const std::vector<size_t>* subset) {
+    std::vector<VectorSearchResult> results;
+    if (top_k <= 0) return results;
+
+    const float slack = rerankSlack();
+    VectorQuantizer::PreparedQuery prepared = quantizer_.prepare(unit_query.data());
+    size_t candidates = rerankCandidates(top_k);
+
+    size_t rows = subset ? subset->size() : matrix_.size();
+    WorkerPool* pool = scanPool(rows);
+    TopKSelector coarse = parallelTopK(pool, rows, candidates, threshold - slack,
+                                       pool ? pool->size() : 1,
+        [&](size_t begin, size_t end, TopKSelector& part) {
+            if (subset) {
+                for (size_t i = begin; i < end; i++) {
+                    size_t row = (*subset)[i];
+                    float score;
+                    quantizer_.scoreBatch(prepared, matrix_.codeAt(row), 1, matrix_.strideBytes(), &score);
+                    if (score >= part.bound()) {
+                        part.push(score, row);
+                    }
+                }
+                return;
+            }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        VectorSearchResult res;
-        res.document.id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        res.document.content = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            const size_t block = 256;
+            float scores[block];
+            for (size_t start = begin; start < end; start += block) {
+                size_t count = std::min(block, end - start);
+                quantizer_.scoreBatch(prepared, matrix_.codeAt(start), count, matrix_.strideBytes(), scores);
+
+                for (size_t i = 0; i < count; i++) {
+                    if (scores[i] >= part.bound()) {
+                        part.push(scores[i], start + i);
+                    }
+                }
+            }
+        });
 
-        const char* source = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        res.document.source = source ? source : "";
+    std::vector<std::string> ids;
+    for (const auto& candidate : coarse.take()) {
+        ids.push_back(matrix_.idAt(candidate.second));
+    }
+    return rerankExact(unit_query, ids, top_k, threshold);
+}
 
-        const char* meta = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        res.document.metadata = meta ? meta : "";
+// PQ codes are much coarser than fp16/int8 and get a deeper re-rank
+size_t SQLiteVectorDB::rerankCandidates(int top_k) const {
+    int factor = std::max(options_.rerank_factor, 1) * (quantizer_.mode() == QuantizationMode::PQ ? 4 : 1);
+    return static_cast<size_t>(std::max(top_k * factor, 32));
+}
 
-        const void* blob = sqlite3_column_blob(stmt, 4);
-        int blob_size = sqlite3_column_bytes(stmt, 4);
-        res.document.embedding = deserializeEmbedding(std::string(static_cast<const char*>(blob), blob_size));
+// Approximate scores may undershoot the exact ones, so the first pass
+// keeps candidates slightly below the threshold
+float SQLiteVectorDB::rerankSlack() const {
+    return quantizer_.mode() == QuantizationMode::PQ ? 0.1f : 0.02f;
+}
 
-        res.document.timestamp = sqlite3_column_int64(stmt, 5);
+std::vector<VectorSearchResult> SQLiteVectorDB::rerankExact(const Embedding& unit_query, const std::vector<std::string>& ids,
+                                                           int top_k, float threshold) {
+    std::vector<VectorSearchResult> results;
+    TopKSelector top(static_cast<size_t>(std::max(top_k, 0)), threshold);
+    auto* stmt = static_cast<sqlite3_stmt*>(statement("SELECT embedding FROM vectors WHERE id = ?"));
+    if (!stmt) return results;
+    for (size_t i = 0; i < ids.size(); i++) {
+        sqlite3_bind_text(stmt, 1, ids[i].c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) == SQLITE_ROW &&
+            static_cast<size_t>(sqlite3_column_bytes(stmt, 0)) == unit_query.size() * sizeof(float)) {
+            top.push(simd::dot(unit_query.data(), static_cast<const float*>(sqlite3_column_blob(stmt, 0)), unit_query.size()), i);
+        }
+        sqlite3_reset(stmt);
+    }
 
-        // Compute cosine similarity
-        res.score = EmbeddingClient::cosineSimilarity(query, res.document.embedding);
+    for (const auto& hit : top.take()) {
+        VectorSearchResult res;
+        res.document = getResult(ids[hit.second]);
+        if (res.document.id.empty()) continue;
+        res.score = hit.first;
         res.distance = 1.0f - res.score;
-
-        if (res.score >= threshold) {
-            all_results.push_back(res);
-        }
+        results.push_back(res);
     }
 
-    sqlite3_finalize(stmt);
+    return results;
+}
 
-    // Sort by score descending
-    std::sort(all_results.begin(), all_results.end(),
-        [](const VectorSearchResult& a, const VectorSearchResult& b) {
-            return a.score > b.score;
-        });
+// Search winners only need their text columns; the embedding BLOB is
+// neither read nor kept in the returned document
+VectorDocument SQLiteVectorDB::getResult(const std::string& id) {
+    VectorDocument doc;
+    auto* stmt = static_cast<sqlite3_stmt*>(
+        statement("SELECT id, content, source, metadata, timestamp, norm FROM vectors WHERE id = ?"));
+    if (!stmt) return doc;
 
-    // Return top_k
-    if (static_cast<int>(all_results.size()) > top_k) {
-        all_results.resize(top_k);
+    sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        doc.id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        doc.content = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        const char* source = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        doc.source = source ? source : "";
+        const char* meta = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        doc.metadata = meta ? meta : "";
+        doc.timestamp = sqlite3_column_int64(stmt, 4);
+        doc.norm = static_cast<float>(sqlite3_column_double(stmt, 5));
     }
-
-    return all_results;
+    sqlite3_reset(stmt);
+    return doc;
 }
 
 VectorDocument SQLiteVectorDB::get(const std::string& id) {
     VectorDocument doc;
     if (!db_) return doc;
 
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id, content, source, metadata, embedding, timestamp FROM vectors WHERE id = ?";
-
-    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        return doc;
-    }
+    auto* stmt = static_cast<sqlite3_stmt*>(
+        statement("SELECT id, content, source, metadata, embedding, timestamp FROM vectors WHERE id = ?"));
+    if (!stmt) return doc;
 
     sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
 
@@ -277,7 +1844,7 @@ VectorDocument SQLiteVectorDB::get(const std::string& id) {
         doc.timestamp = sqlite3_column_int64(stmt, 5);
     }
 
-    sqlite3_finalize(stmt);
+    sqlite3_reset(stmt);
     return doc;
 }
 
@@ -347,80 +1914,436 @@ std::vector<VectorDocument> SQLiteVectorDB::getAll(int limit, int offset) {
         int blob_size = sqlite3_column_bytes(stmt, 4);
         doc.embedding = deserializeEmbedding(std::string(static_cast<const char*>(blob), blob_size));
 
-        doc.timestamp = sqlite3_column_int64(stmt, 5);
+        doc.timestamp = sqlite3_column_int64(stmt, 5);
+
+        docs.push_back(doc);
+    }
+
+    sqlite3_finalize(stmt);
+    return docs;
+}
+
+bool SQLiteVectorDB::forEach(const std::function<bool(const VectorDocument&)>& fn) {
+    if (!db_) return false;
+
+    // One cursor in rowid order instead of OFFSET paging, which rescans the
+    // skipped rows on every page
+    sqlite3_stmt* stmt;
+    const char* sql = "SELECT id, content, source, metadata, embedding, timestamp, norm FROM vectors ORDER BY rowid";
+
+    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+
+    bool completed = true;
+    VectorDocument doc;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        doc.id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        doc.content = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+
+        const char* source = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        doc.source = source ? source : "";
+
+        const char* meta = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        doc.metadata = meta ? meta : "";
+
+        const void* blob = sqlite3_column_blob(stmt, 4);
+        int blob_size = sqlite3_column_bytes(stmt, 4);
+        doc.embedding = deserializeEmbedding(std::string(static_cast<const char*>(blob), blob_size));
+
+        doc.timestamp = sqlite3_column_int64(stmt, 5);
+        doc.norm = static_cast<float>(sqlite3_column_double(stmt, 6));
+
+        if (!fn(doc)) {
+            completed = false;
+            break;
+        }
+    }
+
+    sqlite3_finalize(stmt);
+    return completed;
+}
+
+VectorDBStats SQLiteVectorDB::getStats() {
+    VectorDBStats stats;
+    stats.backend = "sqlite";
+    stats.path = db_path_;
+    stats.document_count = 0;
+    stats.dimensions = dimensions_;
+    stats.size_bytes = 0;
+
+    if (!db_) return stats;
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), "SELECT COUNT(*) FROM vectors", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            stats.document_count = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    // Get file size
+    struct stat st;
+    if (stat(db_path_.c_str(), &st) == 0) {
+        stats.size_bytes = st.st_size;
+    }
+
+    if (matrix_.holdsCodes()) {
+        stats.quantization = VectorQuantizer::modeName(quantizer_.mode());
+        stats.compression_ratio = quantizer_.compressionRatio();
+    }
+    stats.resident_bytes = static_cast<int64_t>(matrix_.memoryBytes() + sparse_.memoryBytes() + index_.memoryBytes());
+    stats.sparse_documents = static_cast<int64_t>(sparse_.size());
+    stats.embedding_model = readMeta("embedding_model");
+
+    return stats;
+}
+
+bool SQLiteVectorDB::optimize() {
+    if (!db_) return false;
+
+    // Retrain the PQ codebook on the current corpus
+    if (quantizer_.mode() == QuantizationMode::PQ) {
+        sqlite3_exec(static_cast<sqlite3*>(db_), "DELETE FROM vector_meta WHERE key = 'codebook'", nullptr, nullptr, nullptr);
+        loadResident();
+        if (options_.hnsw_enabled) loadIndex();
+    }
+
+    // Drop HNSW tombstones left behind by removals
+    if (options_.hnsw_enabled && index_.deletedCount() > 0) {
+        rebuildIndex();
+    }
+
+    char* err_msg = nullptr;
+    sqlite3_exec(static_cast<sqlite3*>(db_), "VACUUM", nullptr, nullptr, &err_msg);
+    if (err_msg) {
+        sqlite3_free(err_msg);
+        return false;
+    }
+    return true;
+}
+
+bool SQLiteVectorDB::clear() {
+    if (!db_) return false;
+    char* err_msg = nullptr;
+    sqlite3_exec(static_cast<sqlite3*>(db_), "DELETE FROM vectors; DELETE FROM hnsw_nodes; DELETE FROM hnsw_meta; "
+                 "DELETE FROM vector_meta WHERE key = 'codebook'; DELETE FROM source_manifest; DELETE FROM sources;",
+                 nullptr, nullptr, &err_msg);
+    matrix_.reset();
+    sparse_.reset();
+    index_.reset(&matrix_);
+    dimensions_ = 0;
+    quantizer_.configure(quantizer_.mode(), 0);
+    if (err_msg) {
+        sqlite3_free(err_msg);
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Source manifests
+// ----------------------------------------------------------------------------
+
+static SourceManifest readManifestRow(sqlite3_stmt* stmt) {
+    SourceManifest manifest;
+    manifest.source = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    manifest.size = sqlite3_column_int64(stmt, 1);
+    manifest.mtime = sqlite3_column_int64(stmt, 2);
+    manifest.content_hash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+    json ids = json::parse(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4)), nullptr, false);
+    if (ids.is_array()) {
+        for (const auto& id : ids) {
+            if (id.is_string()) manifest.chunk_ids.push_back(id.get<std::string>());
+        }
+    }
+    manifest.indexed_at = sqlite3_column_int64(stmt, 5);
+    return manifest;
+}
+
+bool SQLiteVectorDB::getManifest(const std::string& source, SourceManifest& manifest) {
+    if (!db_) return false;
+
+    auto* stmt = static_cast<sqlite3_stmt*>(statement(
+        "SELECT source, size, mtime, content_hash, chunk_ids, indexed_at FROM source_manifest WHERE source = ?"));
+    if (!stmt) return false;
+
+    sqlite3_bind_text(stmt, 1, source.c_str(), -1, SQLITE_TRANSIENT);
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) manifest = readManifestRow(stmt);
+    sqlite3_reset(stmt);
+    return found;
+}
+
+bool SQLiteVectorDB::putManifest(const SourceManifest& manifest) {
+    if (!db_) return false;
+
+    auto* stmt = static_cast<sqlite3_stmt*>(statement(
+        "INSERT OR REPLACE INTO source_manifest (source, size, mtime, content_hash, chunk_ids, indexed_at) "
+        "VALUES (?, ?, ?, ?, ?, ?)"));
+    if (!stmt) return false;
+
+    std::string ids = json(manifest.chunk_ids).dump();
+    sqlite3_bind_text(stmt, 1, manifest.source.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, manifest.size);
+    sqlite3_bind_int64(stmt, 3, manifest.mtime);
+    sqlite3_bind_text(stmt, 4, manifest.content_hash.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 5, ids.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 6, manifest.indexed_at);
+    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_reset(stmt);
+    return success;
+}
+
+bool SQLiteVectorDB::removeManifest(const std::string& source) {
+    if (!db_) return false;
+
+    auto* stmt = static_cast<sqlite3_stmt*>(statement("DELETE FROM source_manifest WHERE source = ?"));
+    if (!stmt) return false;
+
+    sqlite3_bind_text(stmt, 1, source.c_str(), -1, SQLITE_TRANSIENT);
+    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_reset(stmt);
+    return success;
+}
+
+std::vector<SourceManifest> SQLiteVectorDB::listManifests(const std::string& prefix) {
+    std::vector<SourceManifest> manifests;
+    if (!db_) return manifests;
+
+    auto* stmt = static_cast<sqlite3_stmt*>(statement(
+        "SELECT source, size, mtime, content_hash, chunk_ids, indexed_at FROM source_manifest "
+        "WHERE substr(source, 1, length(?1)) = ?1 ORDER BY source"));
+    if (!stmt) return manifests;
+
+    sqlite3_bind_text(stmt, 1, prefix.c_str(), -1, SQLITE_TRANSIENT);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        manifests.push_back(readManifestRow(stmt));
+    }
+    sqlite3_reset(stmt);
+    return manifests;
+}
+
+static SourceInfo readSourceRow(sqlite3_stmt* stmt) {
+    SourceInfo info;
+    const char* source = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    const char* model = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+    info.source = source ? source : "";
+    info.chunks = sqlite3_column_int64(stmt, 1);
+    info.bytes = sqlite3_column_int64(stmt, 2);
+    info.last_indexed = sqlite3_column_int64(stmt, 3);
+    info.embedding_model = model ? model : "";
+    return info;
+}
+
+std::vector<SourceInfo> SQLiteVectorDB::listSources(const std::string& prefix) {
+    std::vector<SourceInfo> sources;
+    if (!db_) return sources;
+
+    auto* stmt = static_cast<sqlite3_stmt*>(statement(
+        "SELECT source, chunks, bytes, last_indexed, embedding_model FROM sources "
+        "WHERE substr(source, 1, length(?1)) = ?1 ORDER BY source"));
+    if (!stmt) return sources;
+
+    sqlite3_bind_text(stmt, 1, prefix.c_str(), -1, SQLITE_TRANSIENT);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        sources.push_back(readSourceRow(stmt));
+    }
+    sqlite3_reset(stmt);
+    return sources;
+}
+
+bool SQLiteVectorDB::getSource(const std::string& source, SourceInfo& info) {
+    if (!db_) return false;
 
-        docs.push_back(doc);
-    }
+    auto* stmt = static_cast<sqlite3_stmt*>(statement(
+        "SELECT source, chunks, bytes, last_indexed, embedding_model FROM sources WHERE source = ?"));
+    if (!stmt) return false;
 
-    sqlite3_finalize(stmt);
-    return docs;
+    sqlite3_bind_text(stmt, 1, source.c_str(), -1, SQLITE_TRANSIENT);
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) info = readSourceRow(stmt);
+    sqlite3_reset(stmt);
+    return found;
 }
 
-VectorDBStats SQLiteVectorDB::getStats() {
-    VectorDBStats stats;
-    stats.backend = "sqlite";
-    stats.path = db_path_;
-    stats.document_count = 0;
-    stats.dimensions = dimensions_;
-    stats.size_bytes = 0;
+void SQLiteVectorDB::setEmbeddingModel(const std::string& model) {
+    if (!db_ || model.empty() || readMeta("embedding_model") == model) return;
+    writeMeta("embedding_model", model);
+}
 
-    if (!db_) return stats;
+// ============================================================================
+// ChromaDBBackend Implementation
+// ============================================================================
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(static_cast<sqlite3*>(db_), "SELECT COUNT(*) FROM vectors", -1, &stmt, nullptr) == SQLITE_OK) {
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            stats.document_count = sqlite3_column_int64(stmt, 0);
+namespace {
+
+// Chroma rejects larger batches regardless of their size in bytes
+const size_t kChromaMaxBatchDocuments = 1000;
+
+// Prefix of the flattened copies of our metadata keys in Chroma metadata
+const char* const kChromaMetaPrefix = "meta.";
+
+// Chroma only takes flat metadata, so ours is kept as a JSON string next to
+// the source and timestamp. Its scalar top-level values are also copied to
+// "meta.<key>" entries, so that filters can go into the where clause.
+json chromaMetadata(const VectorDocument& doc) {
+    json metadata;
+    metadata["source"] = doc.source;
+    metadata["timestamp"] = doc.timestamp > 0 ? doc.timestamp :
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
+    if (!doc.metadata.empty()) {
+        metadata["custom"] = doc.metadata;
+        json custom = json::parse(doc.metadata, nullptr, false);
+        if (custom.is_object()) {
+            for (auto it = custom.begin(); it != custom.end(); ++it) {
+                if (it->is_string() || it->is_number() || it->is_boolean()) {
+                    metadata[kChromaMetaPrefix + it.key()] = *it;
+                }
+            }
         }
-        sqlite3_finalize(stmt);
     }
+    return metadata;
+}
 
-    // Get file size
-    struct stat st;
-    if (stat(db_path_.c_str(), &st) == 0) {
-        stats.size_bytes = st.st_size;
+// The part of a filter Chroma can evaluate: timestamp bounds and metadata
+// equality, with the value tried as each JSON type metadataValueEquals
+// accepts it as. Source prefixes have no Chroma operator and stay with the
+// caller. Null if nothing applies.
+json chromaWhere(const SearchFilter& filter) {
+    json conditions = json::array();
+    if (filter.min_timestamp > 0) conditions.push_back({{"timestamp", {{"$gte", filter.min_timestamp}}}});
+    if (filter.max_timestamp > 0) conditions.push_back({{"timestamp", {{"$lte", filter.max_timestamp}}}});
+
+    for (const auto& kv : filter.metadata) {
+        std::string key = kChromaMetaPrefix + kv.first;
+        const std::string& value = kv.second;
+        json alternatives = json::array();
+        alternatives.push_back({{key, {{"$eq", value}}}});
+
+        double number;
+        if (parseMetadataNumber(value, number)) {
+            if (std::nearbyint(number) == number && std::fabs(number) < 9.0e15) {
+                alternatives.push_back({{key, {{"$eq", static_cast<int64_t>(number)}}}});
+            }
+            alternatives.push_back({{key, {{"$eq", number}}}});
+        }
+        if (value == "true" || value == "1") alternatives.push_back({{key, {{"$eq", true}}}});
+        if (value == "false" || value == "0") alternatives.push_back({{key, {{"$eq", false}}}});
+
+        if (alternatives.size() == 1) {
+            conditions.push_back(alternatives[0]);
+        } else {
+            conditions.push_back({{"$or", alternatives}});
+        }
     }
 
-    return stats;
+    if (conditions.empty()) return json();
+    if (conditions.size() == 1) return conditions[0];
+    return {{"$and", conditions}};
 }
 
-bool SQLiteVectorDB::optimize() {
-    if (!db_) return false;
-    char* err_msg = nullptr;
-    sqlite3_exec(static_cast<sqlite3*>(db_), "VACUUM", nullptr, nullptr, &err_msg);
-    if (err_msg) {
-        sqlite3_free(err_msg);
-        return false;
+// Inverse of chromaMetadata(); older entries hold the custom metadata as a
+// nested object
+void readChromaMetadata(const json& meta, VectorDocument& doc) {
+    doc.timestamp = 0;
+    if (!meta.is_object()) return;
+    doc.source = meta.value("source", "");
+    auto timestamp = meta.find("timestamp");
+    if (timestamp != meta.end() && timestamp->is_number_integer()) {
+        doc.timestamp = timestamp->get<int64_t>();
+    }
+    auto custom = meta.find("custom");
+    if (custom != meta.end()) {
+        doc.metadata = custom->is_string() ? custom->get<std::string>() : custom->dump();
     }
-    return true;
 }
 
-bool SQLiteVectorDB::clear() {
-    if (!db_) return false;
-    char* err_msg = nullptr;
-    sqlite3_exec(static_cast<sqlite3*>(db_), "DELETE FROM vectors", nullptr, nullptr, &err_msg);
-    if (err_msg) {
-        sqlite3_free(err_msg);
-        return false;
+// Documents of a /get response, whose columns are parallel arrays
+std::vector<VectorDocument> chromaDocuments(const json& data) {
+    std::vector<VectorDocument> docs;
+    if (!data.is_object() || !data.contains("ids") || !data["ids"].is_array()) return docs;
+
+    const json& ids = data["ids"];
+    auto column = [&](const char* name) -> const json* {
+        auto it = data.find(name);
+        return it != data.end() && it->is_array() && it->size() == ids.size() ? &*it : nullptr;
+    };
+    const json* documents = column("documents");
+    const json* metadatas = column("metadatas");
+    const json* embeddings = column("embeddings");
+
+    docs.resize(ids.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        VectorDocument& doc = docs[i];
+        doc.id = ids[i].get<std::string>();
+        doc.timestamp = 0;
+        if (documents && (*documents)[i].is_string()) {
+            doc.content = (*documents)[i].get<std::string>();
+        }
+        if (metadatas) {
+            readChromaMetadata((*metadatas)[i], doc);
+        }
+        if (embeddings && (*embeddings)[i].is_array()) {
+            doc.embedding = (*embeddings)[i].get<Embedding>();
+        }
     }
-    return true;
+    return docs;
 }
 
-// ============================================================================
-// ChromaDBBackend Implementation
-// ============================================================================
+// About what a document adds to an upsert body; floats print with up to
+// 17 significant digits
+size_t chromaBytes(const VectorDocument& doc) {
+    return doc.id.size() + doc.content.size() + doc.source.size() + doc.metadata.size() +
+           doc.embedding.size() * 20 + 128;
+}
 
-ChromaDBBackend::ChromaDBBackend() : connected_(false) {
+// One upsert request of a batch
+struct ChromaRequest {
+    const std::string* payload;
+    std::string response;
+    CURLcode code = CURLE_OK;
+    long status = 0;
+};
+
+} // namespace
+
+ChromaDBBackend::ChromaDBBackend()
+    : connected_(false)
+    , batch_bytes_(4194304)
+    , concurrency_(4)
+    , curl_(nullptr)
+    , multi_(nullptr) {
 }
 
 ChromaDBBackend::~ChromaDBBackend() {
     close();
+    for (void* curl : handles_) {
+        if (curl) curl_easy_cleanup(static_cast<CURL*>(curl));
+    }
+    if (multi_) {
+        curl_multi_cleanup(static_cast<CURLM*>(multi_));
+    }
+    if (curl_) {
+        curl_easy_cleanup(static_cast<CURL*>(curl_));
+    }
+}
+
+void ChromaDBBackend::configure(const VectorDBOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch_bytes_ = static_cast<size_t>(std::max<int64_t>(options.chroma_batch_bytes, 1));
+    concurrency_ = std::max(1, options.chroma_concurrency);
 }
 
 bool ChromaDBBackend::open(const std::string& url) {
     // Parse URL: http://host:port/collection_name
     size_t last_slash = url.rfind('/');
-    if (last_slash == std::string::npos || last_slash == url.length() - 1) {
-        base_url_ = url;
+    size_t scheme = url.find("://");
+    bool no_path = scheme != std::string::npos && last_slash < scheme + 3;
+    if (last_slash == std::string::npos || no_path || last_slash == url.length() - 1) {
+        base_url_ = no_path || last_slash == std::string::npos ? url : url.substr(0, last_slash);
         collection_name_ = "default";
     } else {
         base_url_ = url.substr(0, last_slash);
@@ -430,7 +2353,14 @@ bool ChromaDBBackend::open(const std::string& url) {
     // Test connection
     std::string response = httpRequest("GET", "/api/v1/heartbeat");
     connected_ = !response.empty();
-    return connected_;
+    if (!connected_) return false;
+
+    // Collections are created on first use
+    json request;
+    request["name"] = collection_name_;
+    request["get_or_create"] = true;
+    httpRequest("POST", "/api/v1/collections", request.dump());
+    return true;
 }
 
 void ChromaDBBackend::close() {
@@ -441,85 +2371,201 @@ bool ChromaDBBackend::isOpen() const {
     return connected_;
 }
 
+std::string ChromaDBBackend::collectionPath(const std::string& action) const {
+    return "/api/v1/collections/" + collection_name_ + "/" + action;
+}
+
 std::string ChromaDBBackend::httpRequest(const std::string& method, const std::string& endpoint, const std::string& body) {
-    CURL* curl = curl_easy_init();
-    if (!curl) return "";
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!curl_) {
+        curl_ = curl_easy_init();
+        if (!curl_) return "";
+    }
+    // Resetting keeps the handle's open connections
+    CURL* curl = static_cast<CURL*>(curl_);
+    curl_easy_reset(curl);
 
     std::string url = base_url_ + endpoint;
     std::string response;
 
     struct curl_slist* headers = nullptr;
     headers = curl_slist_append(headers, "Content-Type: application/json");
+    headers = curl_slist_append(headers, "Expect:");
 
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
 
     if (method == "POST") {
         curl_easy_setopt(curl, CURLOPT_POST, 1L);
         curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
     } else if (method == "DELETE") {
         curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
     }
 
     CURLcode res = curl_easy_perform(curl);
     curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
 
     if (res != CURLE_OK) {
         return "";
     }
 
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    if (status >= 400) {
+        std::cerr << "ChromaDB " << endpoint << " failed (" << status << "): " << response << std::endl;
+        return "";
+    }
+
     return response;
 }
 
-bool ChromaDBBackend::insert(const VectorDocument& doc) {
-    json request;
-    request["ids"] = {doc.id.empty() ? std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) : doc.id};
-    request["documents"] = {doc.content};
-    request["embeddings"] = {doc.embedding};
+bool ChromaDBBackend::postConcurrent(const std::string& endpoint, const std::vector<std::string>& bodies) {
+    if (bodies.empty()) return true;
 
-    json metadata;
-    metadata["source"] = doc.source;
-    if (!doc.metadata.empty()) {
-        try {
-            metadata["custom"] = json::parse(doc.metadata);
-        } catch (...) {
-            metadata["custom"] = doc.metadata;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!multi_) {
+        multi_ = curl_multi_init();
+        if (!multi_) return false;
+    }
+    CURLM* multi = static_cast<CURLM*>(multi_);
+
+    std::vector<ChromaRequest> requests(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        requests[i].payload = &bodies[i];
+    }
+
+    std::string url = base_url_ + endpoint;
+    struct curl_slist* headers = nullptr;
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+    headers = curl_slist_append(headers, "Expect:");
+
+    // Each slot owns one easy handle; a finished slot picks up the next request
+    size_t slots = std::min(requests.size(), static_cast<size_t>(concurrency_));
+    if (handles_.size() < slots) {
+        handles_.resize(slots, nullptr);
+    }
+    size_t next = 0;
+    size_t in_flight = 0;
+    bool failed = false;
+
+    auto start = [&](size_t slot) {
+        if (!handles_[slot]) {
+            handles_[slot] = curl_easy_init();
+        }
+        CURL* curl = static_cast<CURL*>(handles_[slot]);
+        if (!curl) {
+            failed = true;
+            return;
         }
+        auto& req = requests[next++];
+        curl_easy_reset(curl);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, req.payload->c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(req.payload->size()));
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &req.response);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 300L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, static_cast<void*>(&req));
+        curl_multi_add_handle(multi, curl);
+        in_flight++;
+    };
+
+    for (size_t slot = 0; slot < slots; slot++) {
+        start(slot);
     }
-    request["metadatas"] = {metadata};
 
-    std::string response = httpRequest("POST", "/api/v1/collections/" + collection_name_ + "/add", request.dump());
-    return !response.empty();
+    while (in_flight > 0) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* msg;
+        int queued;
+        while ((msg = curl_multi_info_read(multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            CURL* curl = msg->easy_handle;
+            ChromaRequest* req = nullptr;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, reinterpret_cast<char**>(&req));
+            req->code = msg->data.result;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &req->status);
+            curl_multi_remove_handle(multi, curl);
+            in_flight--;
+
+            if (req->code != CURLE_OK || req->status >= 400) {
+                failed = true;
+            }
+            if (!failed && next < requests.size()) {
+                size_t slot = std::find(handles_.begin(), handles_.end(), curl) - handles_.begin();
+                start(slot);
+            }
+        }
+
+        if (in_flight > 0) {
+            curl_multi_wait(multi, nullptr, 0, 1000, nullptr);
+        }
+    }
+    curl_slist_free_all(headers);
+
+    for (const auto& req : requests) {
+        if (req.code != CURLE_OK) {
+            std::cerr << "ChromaDB " << endpoint << " failed: " << curl_easy_strerror(req.code) << std::endl;
+            return false;
+        }
+        if (req.status >= 400) {
+            std::cerr << "ChromaDB " << endpoint << " failed (" << req.status << "): " << req.response << std::endl;
+            return false;
+        }
+        if (req.status == 0) {
+            return false;  // Not sent after an earlier failure
+        }
+    }
+    return !failed;
+}
+
+bool ChromaDBBackend::insert(const VectorDocument& doc) {
+    return insertBatch({doc});
 }
 
 bool ChromaDBBackend::insertBatch(const std::vector<VectorDocument>& docs) {
+    // Upserts capped by document count and body size, so one large learn
+    // neither hits the server's limits nor waits on a single request
+    std::vector<std::string> bodies;
     json request;
-    std::vector<std::string> ids;
-    std::vector<std::string> documents;
-    std::vector<std::vector<float>> embeddings;
-    std::vector<json> metadatas;
-
-    for (const auto& doc : docs) {
-        ids.push_back(doc.id.empty() ? std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) : doc.id);
-        documents.push_back(doc.content);
-        embeddings.push_back(doc.embedding);
+    size_t count = 0;
+    size_t bytes = 0;
+    auto flush = [&] {
+        if (count == 0) return;
+        bodies.push_back(request.dump());
+        request = json();
+        count = 0;
+        bytes = 0;
+    };
+
+    std::string generated = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+    for (size_t i = 0; i < docs.size(); i++) {
+        const VectorDocument& doc = docs[i];
+        size_t size = chromaBytes(doc);
+        if (count > 0 && (count >= kChromaMaxBatchDocuments || bytes + size > batch_bytes_)) {
+            flush();
+        }
 
-        json metadata;
-        metadata["source"] = doc.source;
-        metadatas.push_back(metadata);
+        request["ids"].push_back(doc.id.empty() ? generated + "-" + std::to_string(i) : doc.id);
+        request["documents"].push_back(doc.content);
+        request["embeddings"].push_back(doc.embedding);
+        request["metadatas"].push_back(chromaMetadata(doc));
+        count++;
+        bytes += size;
     }
+    flush();
 
-    request["ids"] = ids;
-    request["documents"] = documents;
-    request["embeddings"] = embeddings;
-    request["metadatas"] = metadatas;
-
-    std::string response = httpRequest("POST", "/api/v1/collections/" + collection_name_ + "/add", request.dump());
-    return !response.empty();
+    return postConcurrent(collectionPath("upsert"), bodies);
 }
 
 bool ChromaDBBackend::update(const VectorDocument& doc) {
@@ -527,8 +2573,9 @@ bool ChromaDBBackend::update(const VectorDocument& doc) {
     request["ids"] = {doc.id};
     request["documents"] = {doc.content};
     request["embeddings"] = {doc.embedding};
+    request["metadatas"] = {chromaMetadata(doc)};
 
-    std::string response = httpRequest("POST", "/api/v1/collections/" + collection_name_ + "/update", request.dump());
+    std::string response = httpRequest("POST", collectionPath("update"), request.dump());
     return !response.empty();
 }
 
@@ -536,7 +2583,7 @@ bool ChromaDBBackend::remove(const std::string& id) {
     json request;
     request["ids"] = {id};
 
-    std::string response = httpRequest("POST", "/api/v1/collections/" + collection_name_ + "/delete", request.dump());
+    std::string response = httpRequest("POST", collectionPath("delete"), request.dump());
     return !response.empty();
 }
 
@@ -544,40 +2591,105 @@ bool ChromaDBBackend::removeBySource(const std::string& source) {
     json request;
     request["where"] = {{"source", source}};
 
-    std::string response = httpRequest("POST", "/api/v1/collections/" + collection_name_ + "/delete", request.dump());
+    std::string response = httpRequest("POST", collectionPath("delete"), request.dump());
     return !response.empty();
 }
 
-std::vector<VectorSearchResult> ChromaDBBackend::search(const Embedding& query, int top_k, float /*threshold*/) {
+std::vector<VectorSearchResult> ChromaDBBackend::search(const Embedding& query, int top_k, float threshold,
+                                                       const SearchFilter& filter) {
     std::vector<VectorSearchResult> results;
-
+    if (top_k <= 0) return results;
+
+    // The query returns ids and distances only (plus metadata when there is
+    // a filter to check). Timestamp and metadata conditions go into the
+    // where clause; a source prefix cannot, so those queries over-fetch and
+    // widen until top_k matches are found or the collection runs out.
+    json where = chromaWhere(filter);
+    bool prefix = !filter.source_prefix.empty();
     json request;
     request["query_embeddings"] = {query};
-    request["n_results"] = top_k;
-    request["include"] = {"documents", "metadatas", "distances"};
-
-    std::string response = httpRequest("POST", "/api/v1/collections/" + collection_name_ + "/query", request.dump());
-    if (response.empty()) return results;
-
-    try {
-        json data = json::parse(response);
+    if (!where.is_null()) request["where"] = where;
+    request["include"] = filter.empty() ? json::array({"distances"}) : json::array({"metadatas", "distances"});
+
+    std::vector<std::pair<float, size_t>> hits;
+    std::vector<std::string> hit_ids;
+    std::vector<float> hit_distances;
+    for (int n_results = prefix ? top_k * 4 : top_k; ; n_results *= 4) {
+        request["n_results"] = n_results;
+        std::string response = httpRequest("POST", collectionPath("query"), request.dump());
+        if (response.empty()) return results;
+
+        bool exhausted = true;
+        try {
+            json data = json::parse(response);
+            if (!data.contains("ids") || data["ids"].empty()) return results;
 
-        if (data.contains("ids") && !data["ids"].empty()) {
+            // Query columns are nested one level per query embedding
             auto& ids = data["ids"][0];
-            auto& documents = data["documents"][0];
             auto& distances = data["distances"][0];
 
+            // Distance to similarity; the threshold and filter apply before
+            // any document is fetched
+            TopKSelector top(static_cast<size_t>(top_k), threshold);
+            float lowest = 1.0f;
             for (size_t i = 0; i < ids.size(); i++) {
-                VectorSearchResult res;
-                res.document.id = ids[i].get<std::string>();
-                res.document.content = documents[i].get<std::string>();
-                res.distance = distances[i].get<float>();
-                res.score = 1.0f / (1.0f + res.distance);  // Convert distance to similarity
-                results.push_back(res);
+                float score = 1.0f / (1.0f + distances[i].get<float>());
+                lowest = std::min(lowest, score);
+                if (!filter.empty()) {
+                    VectorDocument meta;
+                    readChromaMetadata(data["metadatas"][0][i], meta);
+                    if (!filter.matches(meta.source, meta.metadata, meta.timestamp > 0 ? meta.timestamp : -1)) continue;
+                }
+                top.push(score, i);
+            }
+
+            // More candidates only help while the last batch was full and
+            // still above the threshold
+            exhausted = !prefix || top.size() >= static_cast<size_t>(top_k) ||
+                        static_cast<int>(ids.size()) < n_results || lowest < threshold;
+
+            hits = top.take();
+            hit_ids.clear();
+            hit_distances.clear();
+            for (const auto& hit : hits) {
+                hit_ids.push_back(ids[hit.second].get<std::string>());
+                hit_distances.push_back(distances[hit.second].get<float>());
             }
+        } catch (const std::exception& e) {
+            std::cerr << "ChromaDB search parse error: " << e.what() << std::endl;
+            return results;
+        }
+        if (exhausted) break;
+    }
+    if (hits.empty()) return results;
+
+    // Documents are fetched for the final hits only
+    json fetch;
+    fetch["ids"] = hit_ids;
+    fetch["include"] = json::array({"documents", "metadatas"});
+    std::string response = httpRequest("POST", collectionPath("get"), fetch.dump());
+    if (response.empty()) return results;
+
+    std::map<std::string, VectorDocument> found;
+    try {
+        for (auto& doc : chromaDocuments(json::parse(response))) {
+            std::string id = doc.id;
+            found.emplace(std::move(id), std::move(doc));
         }
     } catch (const std::exception& e) {
         std::cerr << "ChromaDB search parse error: " << e.what() << std::endl;
+        return results;
+    }
+
+    // Best first; hits deleted since the query are dropped
+    for (size_t i = 0; i < hits.size(); i++) {
+        auto it = found.find(hit_ids[i]);
+        if (it == found.end()) continue;
+        VectorSearchResult res;
+        res.document = std::move(it->second);
+        res.distance = hit_distances[i];
+        res.score = hits[i].first;
+        results.push_back(std::move(res));
     }
 
     return results;
@@ -590,17 +2702,13 @@ VectorDocument ChromaDBBackend::get(const std::string& id) {
     request["ids"] = {id};
     request["include"] = {"documents", "metadatas", "embeddings"};
 
-    std::string response = httpRequest("POST", "/api/v1/collections/" + collection_name_ + "/get", request.dump());
+    std::string response = httpRequest("POST", collectionPath("get"), request.dump());
     if (response.empty()) return doc;
 
     try {
-        json data = json::parse(response);
-        if (data.contains("ids") && !data["ids"].empty()) {
-            doc.id = data["ids"][0].get<std::string>();
-            doc.content = data["documents"][0].get<std::string>();
-            if (data.contains("embeddings") && !data["embeddings"].empty()) {
-                doc.embedding = data["embeddings"][0].get<std::vector<float>>();
-            }
+        auto docs = chromaDocuments(json::parse(response));
+        if (!docs.empty()) {
+            doc = std::move(docs[0]);
         }
     } catch (...) {
         // Ignore parse errors
@@ -616,20 +2724,11 @@ std::vector<VectorDocument> ChromaDBBackend::getBySource(const std::string& sour
     request["where"] = {{"source", source}};
     request["include"] = {"documents", "metadatas", "embeddings"};
 
-    std::string response = httpRequest("POST", "/api/v1/collections/" + collection_name_ + "/get", request.dump());
+    std::string response = httpRequest("POST", collectionPath("get"), request.dump());
     if (response.empty()) return docs;
 
     try {
-        json data = json::parse(response);
-        if (data.contains("ids")) {
-            for (size_t i = 0; i < data["ids"].size(); i++) {
-                VectorDocument doc;
-                doc.id = data["ids"][i].get<std::string>();
-                doc.content = data["documents"][i].get<std::string>();
-                doc.source = source;
-                docs.push_back(doc);
-            }
-        }
+        docs = chromaDocuments(json::parse(response));
     } catch (...) {
         // Ignore parse errors
     }
@@ -637,26 +2736,19 @@ std::vector<VectorDocument> ChromaDBBackend::getBySource(const std::string& sour
     return docs;
 }
 
-std::vector<VectorDocument> ChromaDBBackend::getAll(int limit, int /*offset*/) {
+std::vector<VectorDocument> ChromaDBBackend::getAll(int limit, int offset) {
     std::vector<VectorDocument> docs;
 
     json request;
-    request["include"] = {"documents", "metadatas"};
+    request["include"] = json::array({"documents", "metadatas"});
     request["limit"] = limit;
+    request["offset"] = std::max(offset, 0);
 
-    std::string response = httpRequest("POST", "/api/v1/collections/" + collection_name_ + "/get", request.dump());
+    std::string response = httpRequest("POST", collectionPath("get"), request.dump());
     if (response.empty()) return docs;
 
     try {
-        json data = json::parse(response);
-        if (data.contains("ids")) {
-            for (size_t i = 0; i < data["ids"].size(); i++) {
-                VectorDocument doc;
-                doc.id = data["ids"][i].get<std::string>();
-                doc.content = data["documents"][i].get<std::string>();
-                docs.push_back(doc);
-            }
-        }
+        docs = chromaDocuments(json::parse(response));
     } catch (...) {
         // Ignore parse errors
     }
@@ -672,7 +2764,7 @@ VectorDBStats ChromaDBBackend::getStats() {
     stats.dimensions = 0;
     stats.size_bytes = 0;
 
-    std::string response = httpRequest("GET", "/api/v1/collections/" + collection_name_ + "/count");
+    std::string response = httpRequest("GET", collectionPath("count"));
     if (!response.empty()) {
         try {
             stats.document_count = std::stoll(response);
@@ -690,10 +2782,33 @@ bool ChromaDBBackend::optimize() {
 
 bool ChromaDBBackend::clear() {
     json request;
-    std::string response = httpRequest("POST", "/api/v1/collections/" + collection_name_ + "/delete", request.dump());
+    std::string response = httpRequest("POST", collectionPath("delete"), request.dump());
     return !response.empty();
 }
 
+std::vector<std::string> ChromaDBBackend::listCollections() {
+    std::vector<std::string> names;
+
+    std::string response = httpRequest("GET", "/api/v1/collections");
+    if (response.empty()) return names;
+
+    try {
+        json data = json::parse(response);
+        for (const auto& collection : data) {
+            std::string name = collection.is_object() ? collection.value("name", "") : "";
+            if (name == collection_name_) {
+                names.push_back(VectorDB::kDefaultCollection);
+            } else if (VectorDB::isValidCollectionName(name)) {
+                names.push_back(name);
+            }
+        }
+    } catch (...) {
+        // Ignore parse errors
+    }
+
+    return names;
+}
+
 // ============================================================================
 // VectorDB Implementation
 // ============================================================================
@@ -705,6 +2820,17 @@ VectorDB::~VectorDB() {
     close();
 }
 
+void VectorDB::setOptions(const VectorDBOptions& options) {
+    options_ = options;
+    if (backend_) {
+        backend_->configure(options_);
+    }
+}
+
+VectorDBOptions VectorDB::getOptions() const {
+    return options_;
+}
+
 bool VectorDB::open(const std::string& backend, const std::string& path) {
     close();
 
@@ -726,13 +2852,17 @@ bool VectorDB::open(const std::string& backend, const std::string& path) {
         return false;
     }
 
-    return backend_->open(path);
+    backend_->configure(options_);
+    bool ok = backend_->open(path);
+    generation_++;
+    return ok;
 }
 
 void VectorDB::close() {
     if (backend_) {
         backend_->close();
         backend_.reset();
+        generation_++;
     }
 }
 
@@ -748,58 +2878,210 @@ std::string VectorDB::getPath() const {
     return path_;
 }
 
+bool VectorDB::isValidCollectionName(const std::string& name) {
+    if (name.empty() || name.size() > 64) return false;
+    for (unsigned char c : name) {
+        if (!std::isalnum(c) && c != '-' && c != '_') return false;
+    }
+    return true;
+}
+
+std::string VectorDB::collectionPath(const std::string& backend, const std::string& path, const std::string& collection) {
+    std::string name = collection.empty() ? kDefaultCollection : collection;
+
+    if (backend == "chroma") {
+        if (name == kDefaultCollection) return path;
+        size_t slash = path.rfind('/');
+        size_t scheme = path.find("://");
+        if (slash == std::string::npos || (scheme != std::string::npos && slash < scheme + 3)) {
+            return path + "/" + name;
+        }
+        return path.substr(0, slash + 1) + name;
+    }
+
+    if (utils::dirExists(path)) {
+        return utils::joinPath(path, name + ".db");
+    }
+    if (name == kDefaultCollection) return path;
+
+    // Beside the default file, the name before its extension
+    size_t slash = path.find_last_of('/');
+    size_t start = slash == std::string::npos ? 0 : slash + 1;
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || dot <= start) {
+        return path + "." + name;
+    }
+    return path.substr(0, dot) + "." + name + path.substr(dot);
+}
+
+std::vector<std::string> VectorDB::listCollections(const std::string& backend, const std::string& path) {
+    std::vector<std::string> names;
+
+    if (backend == "chroma") {
+        ChromaDBBackend chroma;
+        if (chroma.open(path)) {
+            names = chroma.listCollections();
+        }
+    } else {
+        // Files named the way collectionPath() names them
+        std::string pattern = collectionPath(backend, path, "\x01");
+        size_t slash = pattern.find_last_of('/');
+        std::string dir = slash == std::string::npos ? "." : pattern.substr(0, slash);
+        std::string file = pattern.substr(slash == std::string::npos ? 0 : slash + 1);
+        size_t mark = file.find('\x01');
+        std::string prefix = file.substr(0, mark);
+        std::string suffix = file.substr(mark + 1);
+
+        if (!utils::dirExists(path) && utils::fileExists(path)) {
+            names.push_back(kDefaultCollection);
+        }
+        if (DIR* entries = opendir(dir.c_str())) {
+            while (struct dirent* entry = readdir(entries)) {
+                std::string name = entry->d_name;
+                if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+                    name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+                    continue;
+                }
+                name = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+                // SQLite's own files beside a database without an extension
+                if (utils::endsWith(name, "-wal") || utils::endsWith(name, "-shm") || utils::endsWith(name, "-journal")) {
+                    continue;
+                }
+                if (isValidCollectionName(name)) names.push_back(name);
+            }
+            closedir(entries);
+        }
+    }
+
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
 bool VectorDB::add(const std::string& content, const std::string& source, const Embedding& embedding, const std::string& metadata) {
     if (!backend_) return false;
 
     VectorDocument doc;
     doc.content = content;
     doc.source = source;
-    doc.embedding = embedding;
+    doc.embedding = EmbeddingClient::normalize(embedding);
+    doc.norm = std::sqrt(EmbeddingClient::dotProduct(embedding, embedding));
     doc.metadata = metadata;
     doc.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::system_clock::now().time_since_epoch()
     ).count();
 
-    return backend_->insert(doc);
+    bool ok = backend_->insert(doc);
+    generation_++;
+    return ok;
 }
 
-bool VectorDB::addBatch(const std::vector<std::string>& contents, const std::vector<std::string>& sources, const std::vector<Embedding>& embeddings) {
+bool VectorDB::addBatch(const std::vector<std::string>& contents, const std::vector<std::string>& sources, const std::vector<Embedding>& embeddings,
+                        const std::vector<std::string>& metadata, const std::vector<std::string>& ids) {
     if (!backend_) return false;
 
     std::vector<VectorDocument> docs;
+    docs.reserve(contents.size());
     for (size_t i = 0; i < contents.size(); i++) {
         VectorDocument doc;
+        doc.id = i < ids.size() ? ids[i] : "";
         doc.content = contents[i];
         doc.source = i < sources.size() ? sources[i] : "";
-        doc.embedding = i < embeddings.size() ? embeddings[i] : Embedding{};
+        doc.metadata = i < metadata.size() ? metadata[i] : "";
+        if (i < embeddings.size()) {
+            doc.embedding = EmbeddingClient::normalize(embeddings[i]);
+            doc.norm = std::sqrt(EmbeddingClient::dotProduct(embeddings[i], embeddings[i]));
+        }
         doc.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
             std::chrono::system_clock::now().time_since_epoch()
         ).count();
         docs.push_back(doc);
     }
 
-    return backend_->insertBatch(docs);
+    bool ok = backend_->insertBatch(docs);
+    generation_++;
+    return ok;
+}
+
+bool VectorDB::updateMetadata(const std::string& id, const std::string& metadata) {
+    if (!backend_) return false;
+    bool ok = backend_->updateMetadata(id, metadata);
+    generation_++;
+    return ok;
 }
 
 bool VectorDB::remove(const std::string& id) {
     if (!backend_) return false;
-    return backend_->remove(id);
+    bool ok = backend_->remove(id);
+    generation_++;
+    return ok;
 }
 
 bool VectorDB::removeBySource(const std::string& source) {
     if (!backend_) return false;
-    return backend_->removeBySource(source);
+    bool ok = backend_->removeBySource(source);
+    generation_++;
+    return ok;
+}
+
+bool VectorDB::supportsManifests() const {
+    return backend_ && backend_->supportsManifests();
+}
+
+bool VectorDB::getManifest(const std::string& source, SourceManifest& manifest) {
+    if (!backend_) return false;
+    return backend_->getManifest(source, manifest);
+}
+
+bool VectorDB::putManifest(const SourceManifest& manifest) {
+    if (!backend_) return false;
+    return backend_->putManifest(manifest);
+}
+
+bool VectorDB::removeManifest(const std::string& source) {
+    if (!backend_) return false;
+    return backend_->removeManifest(source);
+}
+
+std::vector<SourceManifest> VectorDB::listManifests(const std::string& prefix) {
+    if (!backend_) return {};
+    return backend_->listManifests(prefix);
+}
+
+std::vector<SourceInfo> VectorDB::listSources(const std::string& prefix) {
+    if (!backend_) return {};
+    return backend_->listSources(prefix);
+}
+
+bool VectorDB::getSource(const std::string& source, SourceInfo& info) {
+    if (!backend_) return false;
+    return backend_->getSource(source, info);
+}
+
+void VectorDB::setEmbeddingModel(const std::string& model) {
+    if (backend_) backend_->setEmbeddingModel(model);
+}
+
+std::vector<VectorSearchResult> VectorDB::search(const Embedding& query, int top_k, float threshold,
+                                                const SearchFilter& filter) {
+    if (!backend_) return {};
+    return backend_->search(query, top_k, threshold, filter);
 }
 
-std::vector<VectorSearchResult> VectorDB::search(const Embedding& query, int top_k, float threshold) {
+bool VectorDB::supportsTextSearch() const {
+    return backend_ && backend_->supportsTextSearch();
+}
+
+std::vector<VectorSearchResult> VectorDB::searchText(const std::string& query, int top_k, const SearchFilter& filter) {
     if (!backend_) return {};
-    return backend_->search(query, top_k, threshold);
+    return backend_->searchText(query, top_k, filter);
 }
 
-std::vector<VectorSearchResult> VectorDB::searchByText(const std::string& query, EmbeddingClient& embedder, int top_k, float threshold) {
+std::vector<VectorSearchResult> VectorDB::searchByText(const std::string& query, EmbeddingClient& embedder, int top_k, float threshold,
+                                                      const SearchFilter& filter) {
     auto result = embedder.embed(query);
     if (!result.success) return {};
-    return search(result.embedding, top_k, threshold);
+    return search(result.embedding, top_k, threshold, filter);
 }
 
 VectorDocument VectorDB::get(const std::string& id) {
@@ -824,46 +3106,118 @@ bool VectorDB::optimize() {
 
 bool VectorDB::clear() {
     if (!backend_) return false;
-    return backend_->clear();
+    bool ok = backend_->clear();
+    generation_++;
+    return ok;
 }
 
-bool VectorDB::exportTo(const std::string& path) {
-    if (!backend_) return false;
+void VectorDB::beginBulkLoad() {
+    if (backend_) backend_->beginBulkLoad();
+}
 
-    auto docs = backend_->getAll(100000, 0);
+void VectorDB::endBulkLoad() {
+    if (backend_) backend_->endBulkLoad();
+}
 
-    json output;
-    output["backend"] = backend_name_;
-    output["documents"] = json::array();
+bool VectorDB::exportTo(const std::string& path) {
+    if (!backend_) return false;
 
-    for (const auto& doc : docs) {
-        json j;
-        j["id"] = doc.id;
-        j["content"] = doc.content;
-        j["source"] = doc.source;
-        j["metadata"] = doc.metadata;
-        j["embedding"] = doc.embedding;
-        j["timestamp"] = doc.timestamp;
-        output["documents"].push_back(j);
+    if (utils::endsWith(path, ".json")) {
+        // Legacy JSON format, streamed one document at a time
+        std::ofstream file(path);
+        if (!file.is_open()) return false;
+
+        file << "{\n  \"backend\": " << json(backend_name_).dump() << ",\n  \"documents\": [";
+        bool first = true;
+        bool ok = backend_->forEach([&](const VectorDocument& doc) {
+            json j;
+            j["id"] = doc.id;
+            j["content"] = doc.content;
+            j["source"] = doc.source;
+            j["metadata"] = doc.metadata;
+            j["embedding"] = doc.embedding;
+            j["timestamp"] = doc.timestamp;
+            if (doc.norm > 0.0f) j["norm"] = doc.norm;
+            file << (first ? "\n    " : ",\n    ") << j.dump();
+            first = false;
+            return file.good();
+        });
+        file << (first ? "]\n}\n" : "\n  ]\n}\n");
+        return ok && file.good();
     }
 
-    std::ofstream file(path);
-    if (!file.is_open()) return false;
+    SnapshotWriter writer(path);
+    if (!writer.isOpen()) return false;
 
-    file << output.dump(2);
+    bool ok = backend_->forEach([&](const VectorDocument& doc) {
+        return writer.add(doc);
+    });
+    if (!writer.finish() || !ok) {
+        std::cerr << "Export error: failed writing " << path << std::endl;
+        return false;
+    }
     return true;
 }
 
 bool VectorDB::importFrom(const std::string& path) {
     if (!backend_) return false;
 
+    // Imports return from several places; bump the generation on all of them
+    struct GenerationBump {
+        std::atomic<uint64_t>& generation;
+        ~GenerationBump() { generation++; }
+    } bump{generation_};
+
+    if (SnapshotReader::isSnapshot(path)) {
+        // A damaged snapshot is rejected before anything is written: one
+        // pass checks every block, a second one inserts them
+        std::vector<VectorDocument> block;
+        {
+            SnapshotReader check(path);
+            while (check.nextBlock(block)) {
+            }
+            if (!check.error().empty()) {
+                std::cerr << "Import error: " << check.error() << std::endl;
+                return false;
+            }
+        }
+
+        SnapshotReader reader(path);
+        if (!reader.isOpen()) {
+            std::cerr << "Import error: " << reader.error() << std::endl;
+            return false;
+        }
+
+        // Each block goes in as one insertBatch, index maintenance waits for the end
+        bool ok = true;
+        backend_->beginBulkLoad();
+        while (ok && reader.nextBlock(block)) {
+            ok = backend_->insertBatch(block);
+        }
+        backend_->endBulkLoad();
+        if (!ok) return false;
+        if (!reader.error().empty()) {
+            std::cerr << "Import error: " << reader.error() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
     std::ifstream file(path);
     if (!file.is_open()) return false;
 
+    bool bulk = false;
     try {
         json data = json::parse(file);
 
         if (data.contains("documents")) {
+            const size_t batch_size = SnapshotWriter::kBlockDocuments;
+            std::vector<VectorDocument> batch;
+            batch.reserve(batch_size);
+            bool ok = true;
+            backend_->beginBulkLoad();
+            bulk = true;
+
             for (const auto& j : data["documents"]) {
                 VectorDocument doc;
                 doc.id = j.value("id", "");
@@ -872,12 +3226,26 @@ bool VectorDB::importFrom(const std::string& path) {
                 doc.metadata = j.value("metadata", "");
                 doc.embedding = j.value("embedding", Embedding{});
                 doc.timestamp = j.value("timestamp", 0LL);
-                backend_->insert(doc);
+                doc.norm = j.value("norm", 0.0f);
+                batch.push_back(std::move(doc));
+
+                if (batch.size() == batch_size) {
+                    ok = backend_->insertBatch(batch);
+                    batch.clear();
+                    if (!ok) break;
+                }
+            }
+            if (ok && !batch.empty()) {
+                ok = backend_->insertBatch(batch);
             }
+            backend_->endBulkLoad();
+            bulk = false;
+            if (!ok) return false;
         }
 
         return true;
     } catch (const std::exception& e) {
+        if (bulk) backend_->endBulkLoad();
         std::cerr << "Import error: " << e.what() << std::endl;
         return false;
     }
@@ -0,0 +1,315 @@
+#include "vector_snapshot.h"
+#include <cstring>
+
+namespace casper {
+
+namespace {
+
+const char kMagic[8] = {'C', 'S', 'P', 'R', 'S', 'N', 'A', 'P'};
+const uint32_t kVersion = 2;  // 1: block CRC covered the payload only
+const size_t kHeaderSize = sizeof(kMagic) + 4 + 4 + 8;
+const uint64_t kMaxPayload = 1ULL << 32;  // Sanity bound when reading
+const size_t kMinDocumentBytes = 32;       // String table entry of a document with empty strings
+
+// CRC-32 (IEEE 802.3, same polynomial as zlib), table driven. Pass the
+// previous result as crc to continue a checksum over several buffers.
+uint32_t crc32(const char* data, size_t size, uint32_t crc = 0) {
+    static const auto table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c >> 1) ^ (0xEDB88320 & (0u - (c & 1)));
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putString(std::string& out, const std::string& value) {
+    put<uint32_t>(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+// Bounds-checked cursor over a block payload
+struct Cursor {
+    const char* data;
+    size_t size;
+    size_t pos;
+
+    template <typename T>
+    bool get(T& value) {
+        if (size - pos < sizeof(T)) return false;
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool getString(std::string& value) {
+        uint32_t length;
+        if (!get(length) || size - pos < length) return false;
+        value.assign(data + pos, length);
+        pos += length;
+        return true;
+    }
+};
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// SnapshotWriter
+// ----------------------------------------------------------------------------
+
+SnapshotWriter::SnapshotWriter(const std::string& path)
+    : file_(path, std::ios::binary | std::ios::trunc)
+    , total_(0)
+    , dimensions_(0)
+    , finished_(false) {
+    if (!file_.is_open()) return;
+
+    // Count and dimensions are patched in by finish()
+    std::string header(kMagic, sizeof(kMagic));
+    put<uint32_t>(header, kVersion);
+    put<uint32_t>(header, 0);
+    put<uint64_t>(header, 0);
+    file_.write(header.data(), header.size());
+    pending_.reserve(kBlockDocuments);
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    if (file_.is_open() && !finished_) {
+        finish();
+    }
+}
+
+bool SnapshotWriter::add(const VectorDocument& doc) {
+    if (!file_.is_open() || finished_) return false;
+    if (dimensions_ == 0) {
+        dimensions_ = static_cast<uint32_t>(doc.embedding.size());
+    }
+
+    pending_.push_back(doc);
+    total_++;
+    return pending_.size() < kBlockDocuments || flush();
+}
+
+bool SnapshotWriter::flush() {
+    if (pending_.empty()) return true;
+
+    uint64_t embedding_bytes = 0;
+    size_t string_bytes = 0;
+    for (const auto& doc : pending_) {
+        embedding_bytes += doc.embedding.size() * sizeof(float);
+        string_bytes += 32 + doc.id.size() + doc.content.size() + doc.source.size() + doc.metadata.size();
+    }
+
+    std::string payload;
+    payload.reserve(sizeof(embedding_bytes) + embedding_bytes + string_bytes);
+
+    // Embedding block
+    put<uint64_t>(payload, embedding_bytes);
+    for (const auto& doc : pending_) {
+        payload.append(reinterpret_cast<const char*>(doc.embedding.data()), doc.embedding.size() * sizeof(float));
+    }
+
+    // String table
+    for (const auto& doc : pending_) {
+        put<uint32_t>(payload, static_cast<uint32_t>(doc.embedding.size()));
+        put<int64_t>(payload, doc.timestamp);
+        put<float>(payload, doc.norm);
+        putString(payload, doc.id);
+        putString(payload, doc.content);
+        putString(payload, doc.source);
+        putString(payload, doc.metadata);
+    }
+
+    // The checksum covers the document count and size as well
+    std::string sizes;
+    put<uint32_t>(sizes, static_cast<uint32_t>(pending_.size()));
+    put<uint64_t>(sizes, payload.size());
+    uint32_t crc = crc32(payload.data(), payload.size(), crc32(sizes.data(), sizes.size()));
+
+    std::string block;
+    put<uint32_t>(block, static_cast<uint32_t>(pending_.size()));
+    put<uint32_t>(block, crc);
+    put<uint64_t>(block, payload.size());
+    file_.write(block.data(), block.size());
+    file_.write(payload.data(), payload.size());
+
+    pending_.clear();
+    return file_.good();
+}
+
+bool SnapshotWriter::finish() {
+    if (!file_.is_open() || finished_) return false;
+    finished_ = true;
+
+    if (!flush()) return false;
+
+    // Terminator block
+    std::string block;
+    put<uint32_t>(block, 0);
+    put<uint32_t>(block, 0);
+    put<uint64_t>(block, 0);
+    file_.write(block.data(), block.size());
+
+    std::string counts;
+    put<uint32_t>(counts, dimensions_);
+    put<uint64_t>(counts, total_);
+    file_.seekp(sizeof(kMagic) + 4);
+    file_.write(counts.data(), counts.size());
+
+    file_.close();
+    return !file_.fail();
+}
+
+// ----------------------------------------------------------------------------
+// SnapshotReader
+// ----------------------------------------------------------------------------
+
+bool SnapshotReader::isSnapshot(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+SnapshotReader::SnapshotReader(const std::string& path)
+    : file_(path, std::ios::binary)
+    , ok_(false)
+    , done_(false)
+    , version_(0)
+    , dimensions_(0)
+    , total_(0) {
+    if (!file_.is_open()) {
+        error_ = "Cannot open " + path;
+        return;
+    }
+
+    char header[kHeaderSize];
+    if (!file_.read(header, sizeof(header)) || std::memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+        error_ = "Not a vector snapshot";
+        return;
+    }
+
+    Cursor cursor{header, sizeof(header), sizeof(kMagic)};
+    cursor.get(version_);
+    cursor.get(dimensions_);
+    cursor.get(total_);
+
+    if (version_ == 0 || version_ > kVersion) {
+        error_ = "Unsupported snapshot version " + std::to_string(version_);
+        return;
+    }
+    ok_ = true;
+}
+
+bool SnapshotReader::nextBlock(std::vector<VectorDocument>& docs) {
+    docs.clear();
+    if (!ok_ || done_) return false;
+
+    char block_header[16];
+    if (!file_.read(block_header, sizeof(block_header))) {
+        error_ = "Truncated snapshot";
+        ok_ = false;
+        return false;
+    }
+
+    uint32_t count;
+    uint32_t crc;
+    uint64_t bytes;
+    Cursor header{block_header, sizeof(block_header), 0};
+    header.get(count);
+    header.get(crc);
+    header.get(bytes);
+
+    if (count == 0) {
+        done_ = true;
+        return false;
+    }
+    // Sizes are checked before anything is allocated for them: the payload
+    // must fit in the rest of the file, and every document needs at least
+    // its string table entry
+    std::streamoff pos = file_.tellg();
+    file_.seekg(0, std::ios::end);
+    std::streamoff left = file_.tellg() - pos;
+    file_.seekg(pos);
+    if (bytes > kMaxPayload || left < 0 || bytes > static_cast<uint64_t>(left) ||
+        count > bytes / kMinDocumentBytes) {
+        error_ = "Corrupt snapshot block";
+        ok_ = false;
+        return false;
+    }
+
+    uint32_t expected = 0;
+    if (version_ >= 2) {
+        std::string sizes;
+        put<uint32_t>(sizes, count);
+        put<uint64_t>(sizes, bytes);
+        expected = crc32(sizes.data(), sizes.size());
+    }
+    std::string payload(bytes, '\0');
+    if (!file_.read(&payload[0], static_cast<std::streamsize>(bytes)) ||
+        crc32(payload.data(), payload.size(), expected) != crc) {
+        error_ = "Snapshot checksum mismatch";
+        ok_ = false;
+        return false;
+    }
+
+    Cursor cursor{payload.data(), payload.size(), 0};
+    uint64_t embedding_bytes = 0;
+    if (!cursor.get(embedding_bytes) || embedding_bytes > payload.size() - cursor.pos) {
+        error_ = "Corrupt snapshot block";
+        ok_ = false;
+        return false;
+    }
+
+    // Embeddings are consumed from the front of the block while the string
+    // table that describes them is walked after it
+    const char* floats = payload.data() + cursor.pos;
+    size_t floats_left = embedding_bytes;
+    cursor.pos += embedding_bytes;
+    if (count > (payload.size() - cursor.pos) / kMinDocumentBytes) {
+        error_ = "Corrupt snapshot block";
+        ok_ = false;
+        return false;
+    }
+
+    docs.resize(count);
+    for (auto& doc : docs) {
+        uint32_t length = 0;
+        bool parsed = cursor.get(length) &&
+                      cursor.get(doc.timestamp) &&
+                      cursor.get(doc.norm) &&
+                      cursor.getString(doc.id) &&
+                      cursor.getString(doc.content) &&
+                      cursor.getString(doc.source) &&
+                      cursor.getString(doc.metadata);
+        size_t bytes_needed = static_cast<size_t>(length) * sizeof(float);
+        if (!parsed || bytes_needed > floats_left) {
+            error_ = "Corrupt snapshot block";
+            ok_ = false;
+            docs.clear();
+            return false;
+        }
+
+        doc.embedding.resize(length);
+        std::memcpy(doc.embedding.data(), floats, bytes_needed);
+        floats += bytes_needed;
+        floats_left -= bytes_needed;
+    }
+    return true;
+}
+
+} // namespace casper
@@ -0,0 +1,83 @@
+#include "worker_pool.h"
+
+namespace casper {
+
+WorkerPool::WorkerPool(size_t threads)
+    : task_(nullptr)
+    , task_count_(0)
+    , next_task_(0)
+    , active_(0)
+    , generation_(0)
+    , stop_(false) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    for (size_t i = 1; i < threads; i++) {
+        workers_.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkerPool::run(size_t tasks, const std::function<void(size_t)>& task) {
+    std::lock_guard<std::mutex> serial(run_mutex_);
+
+    if (workers_.empty() || tasks <= 1) {
+        for (size_t i = 0; i < tasks; i++) task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        task_count_ = tasks;
+        next_task_ = 0;
+        active_ = workers_.size();
+        generation_++;
+    }
+    wake_.notify_all();
+
+    drain();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return active_ == 0; });
+    task_ = nullptr;
+}
+
+void WorkerPool::drain() {
+    for (;;) {
+        size_t i = next_task_.fetch_add(1);
+        if (i >= task_count_) break;
+        (*task_)(i);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+
+        drain();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--active_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
+
+} // namespace casper